@@ -0,0 +1,124 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/affinity.h"
+
+#include <pthread.h>
+
+#include <cstring>
+
+#include "bolson/topology.h"
+
+/// Maximum length of a thread name, excluding the terminating null character.
+#define BOLSON_THREAD_NAME_MAX 15
+
+namespace bolson {
+
+auto ToString(ThreadRole role) -> std::string {
+  switch (role) {
+    case ThreadRole::CLIENT:
+      return "client";
+    case ThreadRole::CONVERTER:
+      return "convert";
+    case ThreadRole::PUBLISHER:
+      return "publish";
+  }
+  return "Corrupt bolson::ThreadRole enum value.";
+}
+
+auto AffinityOptions::ParseInput() -> Status {
+  BOLSON_ROE(ParseCpuList(client_cpus_str, &client_cpus));
+  BOLSON_ROE(ParseCpuList(converter_cpus_str, &converter_cpus));
+  BOLSON_ROE(ParseCpuList(publisher_cpus_str, &publisher_cpus));
+  return Status::OK();
+}
+
+auto AffinityOptions::cpus(ThreadRole role) const -> const std::vector<size_t>& {
+  switch (role) {
+    case ThreadRole::CLIENT:
+      return client_cpus;
+    case ThreadRole::CONVERTER:
+      return converter_cpus;
+    case ThreadRole::PUBLISHER:
+      return publisher_cpus;
+  }
+  return client_cpus;
+}
+
+auto AffinityOptions::WaitFor(ThreadRole role, const WaitOptions& wait) const
+    -> WaitOptions {
+  WaitOptions result = wait;
+  if (isolated && !cpus(role).empty() &&
+      ((wait.strategy == WaitStrategy::SLEEP) || (wait.strategy == WaitStrategy::PARK))) {
+    result.strategy = WaitStrategy::SPIN;
+  }
+  return result;
+}
+
+void AddAffinityOptionsToCLI(CLI::App* sub, AffinityOptions* opts) {
+  sub->add_option("--client-cpus", opts->client_cpus_str,
+                  "CPU list to pin TCP client threads to, e.g. 0-3,8.");
+  sub->add_option("--converter-cpus", opts->converter_cpus_str,
+                  "CPU list to pin converter threads to, e.g. 4-19. Overrides the NUMA "
+                  "placement of converter threads.");
+  sub->add_option("--publisher-cpus", opts->publisher_cpus_str,
+                  "CPU list to pin publisher threads to, e.g. 20-23.");
+  sub->add_flag("--isolated-cpus", opts->isolated,
+                "Pin every thread to its own CPU of its role's CPU list, and busy-poll "
+                "instead of sleeping on pinned threads.")
+      ->default_val(false);
+}
+
+static auto NameThread(pthread_t thread, ThreadRole role, size_t index) -> Status {
+  auto name = ToString(role) + "-" + std::to_string(index);
+  name = name.substr(0, BOLSON_THREAD_NAME_MAX);
+  auto ret = pthread_setname_np(thread, name.c_str());
+  if (ret != 0) {
+    return Status(Error::GenericError,
+                  "Unable to name thread " + name + ": " + std::strerror(ret));
+  }
+  return Status::OK();
+}
+
+/// \brief Return the CPUs the thread with some index of a role is pinned to.
+static auto ThreadCpus(ThreadRole role, size_t index, const AffinityOptions& opts)
+    -> std::vector<size_t> {
+  const auto& cpus = opts.cpus(role);
+  if (opts.isolated && !cpus.empty()) {
+    return {cpus[index % cpus.size()]};
+  }
+  return cpus;
+}
+
+auto PlaceThread(std::thread* thread, ThreadRole role, size_t index,
+                 const AffinityOptions& opts) -> Status {
+  BOLSON_ROE(NameThread(thread->native_handle(), role, index));
+  auto cpus = ThreadCpus(role, index, opts);
+  if (!cpus.empty()) {
+    BOLSON_ROE(PinThread(thread, cpus));
+  }
+  return Status::OK();
+}
+
+auto PlaceCurrentThread(ThreadRole role, size_t index, const AffinityOptions& opts)
+    -> Status {
+  BOLSON_ROE(NameThread(pthread_self(), role, index));
+  auto cpus = ThreadCpus(role, index, opts);
+  if (!cpus.empty()) {
+    BOLSON_ROE(PinThread(cpus));
+  }
+  return Status::OK();
+}
+
+}  // namespace bolson
@@ -0,0 +1,92 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <CLI/CLI.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bolson/status.h"
+#include "bolson/wait.h"
+
+namespace bolson {
+
+/// Roles of threads spawned by Bolson.
+enum class ThreadRole {
+  /// Threads receiving JSONs from TCP sources.
+  CLIENT,
+  /// Threads converting JSONs to Arrow IPC messages.
+  CONVERTER,
+  /// Threads publishing Arrow IPC messages.
+  PUBLISHER
+};
+
+/// \brief Return a short human-readable name of a thread role.
+auto ToString(ThreadRole role) -> std::string;
+
+/// CPU affinity options for every thread role.
+struct AffinityOptions {
+  /// CPU lists, e.g. "4-19,24". Empty to not pin threads of the role.
+  std::string client_cpus_str;
+  std::string converter_cpus_str;
+  std::string publisher_cpus_str;
+  /// Parsed CPU lists.
+  std::vector<size_t> client_cpus;
+  std::vector<size_t> converter_cpus;
+  std::vector<size_t> publisher_cpus;
+  /// Pin every thread to its own core of its role's CPU list, and never sleep on them.
+  bool isolated = false;
+
+  /// \brief Parse the CPU lists.
+  auto ParseInput() -> Status;
+
+  /// \brief Return the CPUs that threads of a role are pinned to, empty if not pinned.
+  [[nodiscard]] auto cpus(ThreadRole role) const -> const std::vector<size_t>&;
+
+  /**
+   * \brief Return the wait options for threads of a role.
+   *
+   * Threads pinned to isolated cores have their cores to themselves, so sleeping or
+   * parking wait strategies are replaced by spinning.
+   */
+  [[nodiscard]] auto WaitFor(ThreadRole role, const WaitOptions& wait) const
+      -> WaitOptions;
+};
+
+/// \brief Add CPU affinity options to a CLI subcommand.
+void AddAffinityOptionsToCLI(CLI::App* sub, AffinityOptions* opts);
+
+/**
+ * \brief Name a thread after its role and index, and pin it to the CPUs of its role.
+ *
+ * Without isolated mode, threads are pinned to all CPUs of the role's list. In isolated
+ * mode, thread i is pinned to CPU i of the list, wrapping around if there are more
+ * threads than CPUs.
+ *
+ * \param thread The thread to place.
+ * \param role   The role of the thread.
+ * \param index  The index of the thread among threads of the same role.
+ * \param opts   The affinity options.
+ * \return Status::OK() if successful, some error otherwise.
+ */
+auto PlaceThread(std::thread* thread, ThreadRole role, size_t index,
+                 const AffinityOptions& opts) -> Status;
+
+/// \brief Name and pin the calling thread, see PlaceThread.
+auto PlaceCurrentThread(ThreadRole role, size_t index, const AffinityOptions& opts)
+    -> Status;
+
+}  // namespace bolson
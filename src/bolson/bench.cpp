@@ -14,16 +14,24 @@
 
 #include "bolson/bench.h"
 
+#include <arpa/inet.h>
 #include <blockingconcurrentqueue.h>
 #include <illex/arrow.h>
+#include <netinet/in.h>
 #include <putong/timer.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
+#include <cerrno>
+#include <future>
 #include <iostream>
 #include <memory>
+#include <random>
 #include <thread>
 
 #include "bolson/convert/converter.h"
 #include "bolson/convert/metrics.h"
+#include "bolson/parse/custom/index.h"
 #include "bolson/parse/parser.h"
 #include "bolson/publish/bench.h"
 #include "bolson/status.h"
@@ -205,8 +213,9 @@ auto BenchConvert(const ConvertBenchOptions& opts) -> Status {
       // Mark "receive time" point for buffer to be converted, just before we unlock.
       buffers[b]->SetRecvTime(illex::Timer::now());
     }
-    // Start conversion by unlocking the buffers.
+    // Start conversion by unlocking the buffers and signalling the converter threads.
     converter->parser_context()->UnlockBuffers();
+    converter->parser_context()->SignalFilledBuffers();
 
     // Pull JSON ipc items from the queue to check when we are done.
     while ((num_records_dequeued != gen_jsons) && !shutdown.load()) {
@@ -265,6 +274,7 @@ auto BenchConvert(const ConvertBenchOptions& opts) -> Status {
   auto a = Aggregate(converter->metrics());
   spdlog::info("Details:");
   LogConvertMetrics(a, "  ");
+  LogNumaMetrics(converter->metrics(), "  ");
   if (!o.latency_file.empty()) {
     BOLSON_ROE(SaveLatencyMetrics(latencies, opts.latency_file, TimePoints::parsed,
                                   TimePoints::popped));
@@ -319,8 +329,288 @@ auto BenchQueue(const QueueBenchOptions& opt) -> Status {
   return Status::OK();
 }
 
-auto BenchClient(const illex::ClientOptions& opt) -> Status {
-  return Status(Error::GenericError, "Not implemented.");
+/// A parser context without parsers, only providing input buffers to TCP clients.
+class ClientBenchContext : public parse::ParserContext {
+ public:
+  static auto Make(size_t num_buffers, size_t buffer_size,
+                   std::shared_ptr<ClientBenchContext>* out) -> Status {
+    auto result = std::shared_ptr<ClientBenchContext>(new ClientBenchContext());
+    result->allocator_ = std::make_shared<buffer::Allocator>();
+    BOLSON_ROE(result->AllocateBuffers(num_buffers, buffer_size));
+    *out = result;
+    return Status::OK();
+  }
+
+  auto parsers() -> std::vector<std::shared_ptr<parse::Parser>> override { return {}; }
+  [[nodiscard]] auto SupportsRingBuffers() const -> bool override { return true; }
+  [[nodiscard]] auto input_schema() const -> std::shared_ptr<arrow::Schema> override {
+    return nullptr;
+  }
+  [[nodiscard]] auto output_schema() const -> std::shared_ptr<arrow::Schema> override {
+    return nullptr;
+  }
+
+  ~ClientBenchContext() { FreeBuffers(); }
+
+ private:
+  ClientBenchContext() = default;
+};
+
+/// \brief Generate newline-delimited JSONs of approximately num_bytes bytes.
+static auto GenerateCorpus(const illex::GenerateOptions& gen_opts, size_t num_bytes)
+    -> std::string {
+  auto schema = arrow::schema(
+      {arrow::field("voltage", arrow::list(arrow::field("item", arrow::uint64(), false)),
+                    false)});
+  auto gen = illex::FromArrowSchema(*schema, gen_opts);
+  std::string result;
+  while (result.size() < num_bytes) {
+    result += gen.GetString();
+    result += '\n';
+  }
+  return result;
+}
+
+/// \brief Open a TCP socket listening on all interfaces.
+static auto Listen(uint16_t port, int backlog, int* out) -> Status {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return Status(Error::IOError,
+                  std::string("Unable to create socket: ") + std::strerror(errno));
+  }
+  int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if ((bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) ||
+      (listen(fd, backlog) != 0)) {
+    auto msg = std::string(std::strerror(errno));
+    close(fd);
+    return Status(Error::IOError,
+                  "Unable to listen on port " + std::to_string(port) + ": " + msg);
+  }
+  *out = fd;
+  return Status::OK();
+}
+
+/// \brief Repeatedly send the corpus until at least num_bytes were sent.
+static auto SendCorpus(int fd, const std::string& corpus, size_t num_bytes) -> Status {
+  size_t sent = 0;
+  while (sent < num_bytes) {
+    size_t offset = 0;
+    while (offset < corpus.size()) {
+      auto ret = send(fd, corpus.data() + offset, corpus.size() - offset, MSG_NOSIGNAL);
+      if (ret < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return Status(Error::IOError,
+                      std::string("Unable to send data: ") + std::strerror(errno));
+      }
+      offset += ret;
+    }
+    sent += corpus.size();
+  }
+  return Status::OK();
+}
+
+/// \brief Accept num_connections connections and send num_bytes to each of them.
+static auto ServeCorpus(int listener, size_t num_connections, const std::string& corpus,
+                        size_t num_bytes) -> Status {
+  std::vector<std::future<Status>> senders;
+  for (size_t c = 0; c < num_connections; c++) {
+    int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0) {
+      return Status(Error::IOError,
+                    std::string("Unable to accept connection: ") + std::strerror(errno));
+    }
+    senders.push_back(std::async(std::launch::async, [fd, &corpus, num_bytes]() {
+      auto status = SendCorpus(fd, corpus, num_bytes);
+      close(fd);
+      return status;
+    }));
+  }
+  MultiThreadStatus result;
+  for (auto& s : senders) {
+    result.push_back(s.get());
+  }
+  return Aggregate(result, "Sender ");
+}
+
+/// \brief Empty filled input buffers, standing in for the converter threads.
+static void DrainBuffers(parse::ParserContext* context, std::atomic<bool>* shutdown) {
+  auto buffers = context->mutable_buffers();
+  auto mutexes = context->mutexes();
+  while (!shutdown->load()) {
+    size_t b = 0;
+    if (context->ready_queue()->wait_dequeue_timed(
+            b, std::chrono::microseconds(BOLSON_CONVERTER_WAIT_TIMEOUT_US))) {
+      std::lock_guard<std::mutex> lock(*mutexes[b]);
+      buffers[b]->Reset();
+    }
+  }
+}
+
+auto BenchClient(const ClientBenchOptions& opt) -> Status {
+  const size_t num_connections = opt.client.endpoints.size();
+  const size_t bytes_per_connection = DivideCeil(opt.approx_total_bytes, num_connections);
+
+  spdlog::info("Generating JSON corpus...");
+  auto corpus = GenerateCorpus(opt.generate, BOLSON_BENCH_CLIENT_CORPUS_SIZE);
+
+  std::shared_ptr<ClientBenchContext> context;
+  BOLSON_ROE(ClientBenchContext::Make(opt.num_buffers,
+                                      DivideCeil(opt.input_size, opt.num_buffers),
+                                      &context));
+  if (opt.client.ring) {
+    BOLSON_ROE(context->EnableRingBuffers(num_connections, opt.client.ring_hugepages));
+  }
+
+  // Start the local JSON source.
+  int listener = -1;
+  BOLSON_ROE(Listen(opt.client.port, static_cast<int>(num_connections), &listener));
+  auto server = std::async(std::launch::async, ServeCorpus, listener, num_connections,
+                           std::cref(corpus), bytes_per_connection);
+
+  // Connect the clients and start draining the buffers.
+  std::atomic<uint64_t> seq = 0;
+  std::vector<std::shared_ptr<client::BufferingClient>> clients;
+  auto status = client::CreateClients(opt.client, context.get(), &seq, &clients);
+  if (!status.ok()) {
+    // Unblock the server, which may still be waiting for connections.
+    shutdown(listener, SHUT_RDWR);
+    close(listener);
+    server.wait();
+    return status;
+  }
+  std::atomic<bool> shutdown_drain = false;
+  std::thread drain(DrainBuffers, context.get(), &shutdown_drain);
+
+  spdlog::info("Receiving {} bytes over {} connection(s) using {} I/O...",
+               num_connections * bytes_per_connection, num_connections,
+               client::ToString(opt.client.io));
+  putong::Timer<> t_recv;
+  t_recv.Start();
+  auto recv_status = Aggregate(client::ReceiveJSONs(clients, opt.client.io), "Client ");
+  t_recv.Stop();
+
+  shutdown_drain.store(true);
+  drain.join();
+  close(listener);
+  BOLSON_ROE(server.get());
+  BOLSON_ROE(recv_status);
+  BOLSON_ROE(client::Close(clients));
+
+  size_t bytes_received = 0;
+  for (const auto& c : clients) {
+    bytes_received += c->bytes_received();
+  }
+  auto MB = static_cast<double>(bytes_received) / 1e6;
+  auto MJ = static_cast<double>(client::JSONsReceived(clients)) / 1e6;
+  auto syscalls = client::Syscalls(clients);
+
+  spdlog::info("TCP client:");
+  spdlog::info("  I/O                 : {}", client::ToString(opt.client.io));
+  spdlog::info("  Connections         : {}", num_connections);
+  spdlog::info("  JSONs               : {}", client::JSONsReceived(clients));
+  spdlog::info("  Bytes               : {} B", bytes_received);
+  spdlog::info("  Time                : {} s", t_recv.seconds());
+  spdlog::info("  Throughput          : {:.3f} MB/s", MB / t_recv.seconds());
+  spdlog::info("  Throughput          : {:.3f} MJSON/s", MJ / t_recv.seconds());
+  spdlog::info("  Receive syscalls    : {}", syscalls);
+  spdlog::info("  Syscalls per MB     : {:.3f}", static_cast<double>(syscalls) / MB);
+
+  return Status::OK();
+}
+
+/// \brief Parse all arrays of a numbers benchmark corpus, returning the parse time.
+template <typename ParseArray>
+static auto TimeNumbers(const std::string& corpus, parse::custom::StructuralIndex* index,
+                        std::shared_ptr<arrow::Array>* out, ParseArray&& parse_array)
+    -> double {
+  arrow::UInt64Builder builder;
+  putong::Timer<> t;
+  t.Start();
+  parse::custom::IndexCursor cur(corpus.data(), corpus.size(), *index);
+  while (!cur.done()) {
+    parse_array(&cur, &builder);
+    cur.Expect('\n');
+  }
+  t.Stop();
+  ARROW_TOE(builder.Finish(out));
+  return t.seconds();
+}
+
+/// \brief The previous path: std::from_chars and a builder append for every value.
+static void ParseArrayChars(parse::custom::IndexCursor* cur,
+                            arrow::UInt64Builder* builder) {
+  cur->Array([&]() {
+    auto v = cur->Value();
+    ARROW_TOE(
+        builder->Append(parse::custom::ParseUInt64Chars(v.data(), v.data() + v.size())));
+  });
+}
+
+/// \brief Runs of values parsed with SWAR arithmetic, appended to the builder at once.
+static void ParseArraySwar(parse::custom::IndexCursor* cur,
+                           arrow::UInt64Builder* builder) {
+  cur->UInt64Runs([&](const uint64_t* values, size_t count) {
+    ARROW_TOE(builder->AppendValues(values, static_cast<int64_t>(count)));
+  });
+}
+
+auto BenchNumbers(const NumbersBenchOptions& opt) -> Status {
+  spdlog::info("Generating {} arrays of {} uint64 values...", opt.num_arrays,
+               opt.list_size);
+  std::mt19937_64 rng(opt.seed);
+  std::uniform_int_distribution<size_t> digits(1, opt.max_digits);
+  std::string corpus;
+  for (size_t a = 0; a < opt.num_arrays; a++) {
+    corpus.push_back('[');
+    for (size_t i = 0; i < opt.list_size; i++) {
+      if (i > 0) {
+        corpus.push_back(',');
+      }
+      auto value = std::to_string(rng());
+      corpus.append(value, 0, std::min(value.size(), digits(rng)));
+    }
+    corpus.append("]\n");
+  }
+
+  parse::custom::StructuralIndex index;
+  try {
+    BOLSON_ROE(parse::custom::BuildStructuralIndex(corpus.data(), corpus.size(), &index));
+
+    double t_chars = 0.0;
+    double t_swar = 0.0;
+    for (size_t r = 0; r < opt.repeats; r++) {
+      std::shared_ptr<arrow::Array> chars;
+      std::shared_ptr<arrow::Array> swar;
+      t_chars += TimeNumbers(corpus, &index, &chars, ParseArrayChars);
+      t_swar += TimeNumbers(corpus, &index, &swar, ParseArraySwar);
+      if (!chars->Equals(*swar)) {
+        return Status(Error::GenericError, "SWAR and std::from_chars results differ.");
+      }
+    }
+
+    auto MB = static_cast<double>(corpus.size() * opt.repeats) / 1e6;
+    auto MV = static_cast<double>(opt.num_arrays * opt.list_size * opt.repeats) / 1e6;
+    spdlog::info("uint64 array parsing:");
+    spdlog::info("  Bytes               : {} B", corpus.size());
+    spdlog::info("  from_chars time     : {} s", t_chars);
+    spdlog::info("  from_chars tput     : {:.3f} MB/s", MB / t_chars);
+    spdlog::info("  from_chars tput     : {:.3f} Mvalues/s", MV / t_chars);
+    spdlog::info("  SWAR time           : {} s", t_swar);
+    spdlog::info("  SWAR tput           : {:.3f} MB/s", MB / t_swar);
+    spdlog::info("  SWAR tput           : {:.3f} Mvalues/s", MV / t_swar);
+    spdlog::info("  Speedup             : {:.2f}x", t_chars / t_swar);
+  } catch (const std::runtime_error& e) {
+    return Status(Error::GenericError, e.what());
+  }
+
+  return Status::OK();
 }
 
 auto RunBench(const BenchOptions& opt) -> Status {
@@ -333,6 +623,24 @@ auto RunBench(const BenchOptions& opt) -> Status {
       return BenchPulsar(opt.pulsar);
     case Bench::QUEUE:
       return BenchQueue(opt.queue);
+    case Bench::NUMBERS:
+      return BenchNumbers(opt.numbers);
+  }
+  return Status::OK();
+}
+
+auto ClientBenchOptions::ParseInput() -> Status {
+  if (!client.endpoints_str.empty()) {
+    return Status(Error::CLIError,
+                  "Client benchmark serves JSONs locally and does not support "
+                  "endpoints.");
+  }
+  BOLSON_ROE(client.ParseInput());
+  BOLSON_ROE(ParseWithScale(approx_total_bytes_str, &approx_total_bytes));
+  BOLSON_ROE(ParseWithScale(input_size_str, &input_size));
+  if (num_buffers < client.endpoints.size()) {
+    return Status(Error::CLIError,
+                  "Client benchmark requires at least one buffer per connection.");
   }
   return Status::OK();
 }
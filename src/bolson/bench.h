@@ -20,6 +20,7 @@
 #include <illex/protocol.h>
 #include <putong/timer.h>
 
+#include "bolson/client/buffering.h"
 #include "bolson/convert/converter.h"
 #include "bolson/parse/arrow.h"
 #include "bolson/parse/parser.h"
@@ -28,8 +29,30 @@
 #include "bolson/status.h"
 #include "bolson/utils.h"
 
+/// Size in bytes of the JSON corpus repeatedly sent by the client benchmark.
+#define BOLSON_BENCH_CLIENT_CORPUS_SIZE (1024 * 1024)
+
 namespace bolson {
 
+/// Options for the TCP client benchmark.
+struct ClientBenchOptions {
+  /// Client options. The local JSON source listens on the client port.
+  client::ClientOptions client;
+  /// JSON generator options
+  illex::GenerateOptions generate;
+  /// Approximate total number of JSON bytes to send over all connections.
+  std::string approx_total_bytes_str = "256Mi";
+  size_t approx_total_bytes = 0;
+  /// Total capacity of all input buffers.
+  std::string input_size_str = "64Mi";
+  size_t input_size = 0;
+  /// Number of input buffers.
+  size_t num_buffers = 8;
+
+  /// @brief Parse string-based options.
+  auto ParseInput() -> Status;
+};
+
 /// Options for the Convert benchmark
 struct ConvertBenchOptions {
   /// JSON generator options
@@ -54,6 +77,20 @@ struct ConvertBenchOptions {
   auto ParseInput() -> Status;
 };
 
+/// Options for the number parsing benchmark.
+struct NumbersBenchOptions {
+  /// Number of arrays to parse.
+  size_t num_arrays = 1024 * 1024;
+  /// Number of uint64 values in every array.
+  size_t list_size = 24;
+  /// Maximum number of digits of the values.
+  size_t max_digits = 20;
+  /// Number of times to repeat the measurement.
+  size_t repeats = 1;
+  /// Generation seed.
+  uint64_t seed = 0;
+};
+
 /// Options for queue benchmark
 struct QueueBenchOptions {
   /// Number of items to queue.
@@ -69,7 +106,9 @@ enum class Bench {
   /// Benchmark the Pulsar interface
   PULSAR,
   /// Benchmark for queues.
-  QUEUE
+  QUEUE,
+  /// Benchmark for parsing arrays of numbers.
+  NUMBERS
 };
 
 /// Benchmark subcommand options
@@ -77,13 +116,15 @@ struct BenchOptions {
   /// Chosen subcommand
   Bench bench = Bench::CONVERT;
   /// Options for client bench
-  illex::ClientOptions client;
+  ClientBenchOptions client;
   /// Options for convert bench
   ConvertBenchOptions convert;
   /// Options for Pulsar bench
   publish::BenchOptions pulsar;
   /// Options for Queue bench
   QueueBenchOptions queue;
+  /// Options for number parsing bench
+  NumbersBenchOptions numbers;
 };
 
 /**
@@ -96,10 +137,24 @@ struct BenchOptions {
  */
 auto RunBench(const BenchOptions& opt) -> Status;
 
-/// \brief Run the TCP client benchmark.
-auto BenchClient(const illex::ClientOptions& opt) -> Status;
+/**
+ * \brief Run the TCP client benchmark.
+ *
+ * Spawns a local JSON source that sends a generated corpus over every connection, and
+ * receives it with the buffering clients, while a single thread empties the input
+ * buffers. Reports throughput and the number of receive system calls per MB.
+ */
+auto BenchClient(const ClientBenchOptions& opt) -> Status;
 
 /// \brief Run the JSON-to-Arrow conversion benchmark.
 auto BenchConvert(const ConvertBenchOptions& opts) -> Status;
 
+/**
+ * \brief Run the number parsing benchmark.
+ *
+ * Parses arrays of uint64 values into an Arrow builder, once with std::from_chars and a
+ * builder append per value, and once with the SWAR run parser appending runs of values.
+ */
+auto BenchNumbers(const NumbersBenchOptions& opt) -> Status;
+
 }  // namespace bolson
\ No newline at end of file
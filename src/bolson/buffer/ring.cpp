@@ -0,0 +1,104 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/buffer/ring.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace bolson::buffer {
+
+static auto ErrnoStatus(const std::string& what) -> Status {
+  return Status(Error::GenericError,
+                "Ring buffer: " + what + " failed: " + std::strerror(errno));
+}
+
+auto RingBuffer::Make(size_t capacity, bool hugepages, std::shared_ptr<RingBuffer>* out)
+    -> Status {
+  const size_t page = hugepages ? BOLSON_RING_HUGE_PAGE_SIZE : BOLSON_RING_PAGE_SIZE;
+  capacity = ((capacity + page - 1) / page) * page;
+  if (capacity == 0) {
+    capacity = page;
+  }
+
+  auto result = std::shared_ptr<RingBuffer>(new RingBuffer());
+  result->capacity_ = capacity;
+
+  // Create an anonymous memory file to back the ring.
+  unsigned int flags = MFD_CLOEXEC;
+  if (hugepages) {
+    flags |= MFD_HUGETLB;
+  }
+  result->fd_ = memfd_create("bolson-ring", flags);
+  if (result->fd_ < 0) {
+    return ErrnoStatus("memfd_create");
+  }
+  if (ftruncate(result->fd_, static_cast<off_t>(capacity)) != 0) {
+    return ErrnoStatus("ftruncate");
+  }
+
+  // Reserve twice the capacity of virtual address space, aligned to the page size. Huge
+  // page mappings must be aligned to the huge page size, which mmap does not guarantee
+  // for the reservation, so reserve one page more and unmap the slack around it.
+  const size_t size = 2 * capacity;
+  void* reserved =
+      mmap(nullptr, size + page, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserved == MAP_FAILED) {
+    return ErrnoStatus("reserving address space");
+  }
+  auto* start = static_cast<std::byte*>(reserved);
+  auto address = reinterpret_cast<uintptr_t>(start);
+  auto* aligned = start + (((address + page - 1) / page) * page - address);
+  const size_t head = aligned - start;
+  if (head > 0) {
+    munmap(start, head);
+  }
+  if (page - head > 0) {
+    munmap(aligned + size, page - head);
+  }
+  result->base_ = aligned;
+  for (size_t m = 0; m < 2; m++) {
+    void* mapping = mmap(result->base_ + m * capacity, capacity, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_FIXED, result->fd_, 0);
+    if (mapping == MAP_FAILED) {
+      return ErrnoStatus("mapping ring");
+    }
+  }
+
+  *out = result;
+  return Status::OK();
+}
+
+auto RingBuffer::Commit(size_t num_bytes) -> std::byte* {
+  assert(num_bytes <= uncommitted());
+  auto* result = at(committed_);
+  committed_ += num_bytes;
+  return result;
+}
+
+RingBuffer::~RingBuffer() {
+  if (base_ != nullptr) {
+    munmap(base_, 2 * capacity_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+}  // namespace bolson::buffer
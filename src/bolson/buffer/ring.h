@@ -0,0 +1,99 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "bolson/status.h"
+
+/// Page size used to align ring buffer capacity.
+#define BOLSON_RING_PAGE_SIZE (4 * 1024)
+/// Huge page size used to align ring buffer capacity when using huge pages.
+#define BOLSON_RING_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+namespace bolson::buffer {
+
+/**
+ * \brief A double-mapped ring buffer.
+ *
+ * The same physical memory is mapped twice, back-to-back, in virtual memory. Any region
+ * of at most capacity() bytes starting anywhere in the first mapping is therefore
+ * contiguous, even if it wraps around the end of the ring.
+ *
+ * The ring tracks three monotonically increasing positions:
+ * - tail: the start of the oldest region that has not been released yet,
+ * - committed: the end of the last region that was handed out as a view,
+ * - head: the end of the data written into the ring.
+ *
+ * The ring is not thread-safe; it must be operated by a single producer. Views are
+ * released in the order in which they were committed.
+ */
+class RingBuffer {
+ public:
+  /**
+   * \brief Create a new ring buffer.
+   * \param capacity  The minimum capacity in bytes, rounded up to the page size.
+   * \param hugepages Whether to back the ring with huge pages.
+   * \param out       The resulting ring buffer.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  static auto Make(size_t capacity, bool hugepages, std::shared_ptr<RingBuffer>* out)
+      -> Status;
+
+  ~RingBuffer();
+
+  /// \brief Return the capacity of the ring in bytes.
+  [[nodiscard]] auto capacity() const -> size_t { return capacity_; }
+
+  /// \brief Return a pointer to the start of the writable region.
+  [[nodiscard]] auto write_ptr() -> std::byte* { return at(head_); }
+  /// \brief Return the number of bytes that can be written.
+  [[nodiscard]] auto writable() const -> size_t { return capacity_ - (head_ - tail_); }
+  /// \brief Mark num_bytes at write_ptr() as written.
+  void Produce(size_t num_bytes) { head_ += num_bytes; }
+
+  /// \brief Return a pointer to the start of the written but uncommitted region.
+  [[nodiscard]] auto uncommitted_ptr() -> std::byte* { return at(committed_); }
+  /// \brief Return the number of bytes written but not yet committed.
+  [[nodiscard]] auto uncommitted() const -> size_t { return head_ - committed_; }
+  /// \brief Commit num_bytes of the uncommitted region, returning a pointer to it.
+  auto Commit(size_t num_bytes) -> std::byte*;
+  /// \brief Discard all uncommitted bytes.
+  void Discard() { head_ = committed_; }
+
+  /// \brief Release the oldest num_bytes of committed bytes, making them writable.
+  void Release(size_t num_bytes) { tail_ += num_bytes; }
+
+ private:
+  RingBuffer() = default;
+
+  /// \brief Return a pointer into the ring for an absolute position.
+  auto at(uint64_t pos) -> std::byte* { return base_ + (pos % capacity_); }
+
+  /// Start of the first mapping.
+  std::byte* base_ = nullptr;
+  /// Capacity of the ring.
+  size_t capacity_ = 0;
+  /// The memory file descriptor backing the ring.
+  int fd_ = -1;
+
+  uint64_t tail_ = 0;
+  uint64_t committed_ = 0;
+  uint64_t head_ = 0;
+};
+
+}  // namespace bolson::buffer
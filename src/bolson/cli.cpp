@@ -19,6 +19,7 @@
 #include <CLI/CLI.hpp>
 #include <algorithm>
 
+#include "bolson/client/buffering.h"
 #include "bolson/convert/converter.h"
 #include "bolson/parse/implementations.h"
 #include "bolson/publish/publisher.h"
@@ -26,18 +27,25 @@
 
 namespace bolson {
 
-static void AddClientOptionsToCLI(CLI::App* sub, illex::ClientOptions* client) {
-  sub->add_option("--host", client->host, "JSON source TCP server hostname.")
-      ->default_val("localhost");
-  sub->add_option("--port", client->port, "JSON source TCP server port.")
-      ->default_val(ILLEX_DEFAULT_PORT);
-}
-
 static void AddBenchOptionsToCLI(CLI::App* bench, BenchOptions* out) {
   // 'bench client' subcommand.
   auto* bench_client =
       bench->add_subcommand("client", "Run TCP client interface microbenchmark.");
-  AddClientOptionsToCLI(bench_client, &out->client);
+  client::AddClientOptionsToCLI(bench_client, &out->client.client);
+  bench_client
+      ->add_option("--total-json-bytes", out->client.approx_total_bytes_str,
+                   "Approximate number of JSON bytes to send over all connections. "
+                   "Accepts scaling factors <n>Ki, <n>Mi, etc..")
+      ->default_val("256Mi");
+  bench_client
+      ->add_option("--input-size", out->client.input_size_str,
+                   "Total capacity of all input buffers. Accepts scaling factors.")
+      ->default_val("64Mi");
+  bench_client->add_option("--input-buffers", out->client.num_buffers,
+                           "Number of input buffers.")
+      ->default_val(8);
+  bench_client->add_option("--seed", out->client.generate.seed, "Generation seed.")
+      ->default_val(0);
 
   // 'bench convert' subcommand.
   auto* bench_conv =
@@ -69,6 +77,23 @@ static void AddBenchOptionsToCLI(CLI::App* bench, BenchOptions* out) {
   auto* bench_queue = bench->add_subcommand("queue", "Run queue microbenchmark.");
   bench_queue->add_option("m,-m,--num-items,", out->queue.num_items)->default_val(256);
 
+  // 'bench numbers' subcommand
+  auto* bench_numbers = bench->add_subcommand(
+      "numbers", "Run uint64 array parsing microbenchmark of the custom parsers.");
+  bench_numbers->add_option("--arrays", out->numbers.num_arrays, "Number of arrays.")
+      ->default_val(1024 * 1024);
+  bench_numbers->add_option("--list-size", out->numbers.list_size, "Values per array.")
+      ->default_val(24);
+  bench_numbers
+      ->add_option("--max-digits", out->numbers.max_digits,
+                   "Maximum number of digits of the values.")
+      ->check(CLI::Range(1, 20))
+      ->default_val(20);
+  bench_numbers->add_option("--repeats", out->numbers.repeats, "Number of repeats.")
+      ->default_val(1);
+  bench_numbers->add_option("--seed", out->numbers.seed, "Generation seed.")
+      ->default_val(0);
+
   // 'bench pulsar' subcommand
   auto* bench_pulsar =
       bench->add_subcommand("pulsar", "Run Pulsar publishing microbenchmark.");
@@ -88,9 +113,15 @@ auto AppOptions::FromArguments(int argc, char** argv, AppOptions* out) -> Status
                      "Enable batch latency measurements and write to supplied file.");
   stream->add_option("--metrics", out->stream.metrics_file,
                      "Write metrics to supplied file.");
+  stream
+      ->add_option("--ipc-queue-max-bytes", out->stream.ipc_queue_max_bytes_str,
+                   "Maximum number of bytes of IPC messages waiting to be published. "
+                   "Converters block when exceeded. Zero for no limit.")
+      ->default_val(BOLSON_PUBLISH_IPC_QUEUE_MAX_BYTES);
   AddConverterOptionsToCLI(stream, &out->stream.converter);
   AddPublishOptsToCLI(stream, &out->stream.pulsar);
-  AddClientOptionsToCLI(stream, &out->stream.client);
+  client::AddClientOptionsToCLI(stream, &out->stream.client);
+  AddAffinityOptionsToCLI(stream, &out->stream.affinity);
 
   // 'bench' subcommand:
   auto* bench =
@@ -113,11 +144,12 @@ auto AppOptions::FromArguments(int argc, char** argv, AppOptions* out) -> Status
 
   if (stream->parsed()) {
     out->sub = SubCommand::STREAM;
-    out->stream.converter.ParseInput();
+    BOLSON_ROE(out->stream.ParseInput());
   } else if (bench->parsed()) {
     out->sub = SubCommand::BENCH;
     if (bench->get_subcommand_ptr("client")->parsed()) {
       out->bench.bench = Bench::CLIENT;
+      BOLSON_ROE(out->bench.client.ParseInput());
     } else if (bench->get_subcommand_ptr("convert")->parsed()) {
       out->bench.bench = Bench::CONVERT;
       BOLSON_ROE(out->bench.convert.ParseInput());
@@ -125,6 +157,8 @@ auto AppOptions::FromArguments(int argc, char** argv, AppOptions* out) -> Status
       out->bench.bench = Bench::PULSAR;
     } else if (bench->get_subcommand_ptr("queue")->parsed()) {
       out->bench.bench = Bench::QUEUE;
+    } else if (bench->get_subcommand_ptr("numbers")->parsed()) {
+      out->bench.bench = Bench::NUMBERS;
     }
   }
 
@@ -0,0 +1,535 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/client/buffering.h"
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <thread>
+
+#include "bolson/client/uring.h"
+#include "bolson/latency.h"
+#include "bolson/log.h"
+#include "bolson/parse/custom/skip.h"
+
+namespace bolson::client {
+
+/// \brief Connect a TCP socket to host:port.
+static auto Connect(const std::string& host, uint16_t port, int* out) -> Status {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addrs = nullptr;
+  auto gai = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addrs);
+  if (gai != 0) {
+    return Status(Error::IOError, "Unable to resolve " + host + ": " + gai_strerror(gai));
+  }
+  int fd = -1;
+  for (auto* a = addrs; a != nullptr; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    if (connect(fd, a->ai_addr, a->ai_addrlen) == 0) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(addrs);
+  if (fd < 0) {
+    return Status(Error::IOError, "Unable to connect to " + host + ":" +
+                                      std::to_string(port) + ": " + std::strerror(errno));
+  }
+  *out = fd;
+  return Status::OK();
+}
+
+auto ToString(ClientIO io) -> std::string {
+  switch (io) {
+    case ClientIO::BLOCKING:
+      return "blocking";
+    case ClientIO::URING:
+      return "uring";
+  }
+  return "Corrupt bolson::client::ClientIO enum value.";
+}
+
+auto ClientOptions::ParseInput() -> Status {
+  endpoints.clear();
+  if (endpoints_str.empty()) {
+    if (num_connections == 0) {
+      return Status(Error::CLIError, "Number of connections must be at least one.");
+    }
+    illex::ClientOptions endpoint;
+    endpoint.host = host;
+    endpoint.port = port;
+    endpoints = std::vector<illex::ClientOptions>(num_connections, endpoint);
+    return Status::OK();
+  }
+  for (const auto& e : endpoints_str) {
+    illex::ClientOptions endpoint;
+    endpoint.port = port;
+    std::string port_str;
+    if (!e.empty() && (e[0] == '[')) {
+      // An IPv6 address, as [addr] or [addr]:port.
+      auto bracket = e.find(']');
+      if ((bracket == std::string::npos) ||
+          ((bracket + 1 < e.size()) && (e[bracket + 1] != ':'))) {
+        return Status(Error::CLIError, "Invalid IPv6 endpoint " + e);
+      }
+      endpoint.host = e.substr(1, bracket - 1);
+      if (bracket + 1 < e.size()) {
+        port_str = e.substr(bracket + 2);
+      }
+    } else {
+      auto colon = e.find(':');
+      if ((colon == std::string::npos) || (e.find(':', colon + 1) != std::string::npos)) {
+        // Either no port, or a bare IPv6 address without port.
+        endpoint.host = e;
+      } else {
+        endpoint.host = e.substr(0, colon);
+        port_str = e.substr(colon + 1);
+      }
+    }
+    if (!port_str.empty()) {
+      // The whole string must be a port number, which must fit 16 bits.
+      uint32_t value = 0;
+      const char* last = port_str.data() + port_str.size();
+      auto result = std::from_chars(port_str.data(), last, value);
+      if ((result.ec != std::errc()) || (result.ptr != last) || (value > 65535)) {
+        return Status(Error::CLIError, "Invalid port in endpoint " + e);
+      }
+      endpoint.port = static_cast<uint16_t>(value);
+    }
+    endpoints.push_back(endpoint);
+  }
+  return Status::OK();
+}
+
+void AddClientOptionsToCLI(CLI::App* sub, ClientOptions* opts) {
+  sub->add_option("--host", opts->host, "JSON source TCP server hostname.")
+      ->default_val("localhost");
+  sub->add_option("--port", opts->port, "JSON source TCP server port.")
+      ->default_val(ILLEX_DEFAULT_PORT);
+  sub->add_option("--connections", opts->num_connections,
+                  "Number of TCP connections to make to the JSON source server.")
+      ->default_val(1);
+  sub->add_option("--endpoints", opts->endpoints_str,
+                  "Comma-separated list of <host>:<port> JSON source TCP servers, one "
+                  "connection per endpoint, with IPv6 addresses as [<addr>]:<port>. "
+                  "Overrides --host, --port and --connections.")
+      ->delimiter(',');
+  sub->add_flag("--ring", opts->ring,
+                "Receive into double-mapped ring buffers, avoiding copies of incomplete "
+                "JSONs between input buffers.")
+      ->default_val(false);
+  sub->add_flag("--ring-hugepages", opts->ring_hugepages,
+                "Back the ring buffers with huge pages. Requires --ring.")
+      ->default_val(false);
+  sub->add_option("--client-io", opts->io,
+                  "I/O interface to receive data with. blocking: one thread per "
+                  "connection using recv(), uring: one thread driving all connections "
+                  "through io_uring. Falls back to blocking if io_uring is unavailable.")
+      ->transform(CLI::CheckedTransformer(ClientOptions::io_map(), CLI::ignore_case))
+      ->default_val(ClientIO::BLOCKING);
+}
+
+auto BufferingClient::Create(const illex::ClientOptions& endpoint,
+                             parse::ParserContext* context, std::vector<size_t> indices,
+                             std::atomic<uint64_t>* seq,
+                             std::shared_ptr<BufferingClient>* out) -> Status {
+  if (indices.empty()) {
+    return Status(Error::GenericError, "Buffering client requires at least one buffer.");
+  }
+  auto result = std::shared_ptr<BufferingClient>(new BufferingClient());
+  auto buffers = context->mutable_buffers();
+  auto mutexes = context->mutexes();
+  for (auto b : indices) {
+    result->buffers_.push_back(buffers[b]);
+    result->mutexes_.push_back(mutexes[b]);
+    result->ready_.push_back(context->ready_queue(context->buffer_node(b)));
+  }
+  result->freed_ = context->free_signal();
+  result->endpoint_ = endpoint;
+  result->indices_ = std::move(indices);
+  result->seq_ = seq;
+  result->ring_ = context->ring(result->indices_[0]);
+  for (auto b : result->indices_) {
+    if (context->ring(b) != result->ring_) {
+      return Status(Error::GenericError, "Buffers of a client must share the same ring.");
+    }
+  }
+  result->in_flight_flags_ = std::vector<bool>(result->indices_.size(), false);
+  result->view_sizes_ = std::vector<size_t>(result->indices_.size(), 0);
+  SPDLOG_DEBUG("Client | Connecting to {}:{}", endpoint.host, endpoint.port);
+  BOLSON_ROE(Connect(endpoint.host, endpoint.port, &result->socket_));
+  *out = result;
+  return Status::OK();
+}
+
+auto BufferingClient::PrepareBuffer(size_t b, size_t* filled) -> Status {
+  auto* buf = buffers_[b];
+  // Place the leftover bytes of the previous buffer at the start of this buffer.
+  if (carry_.size() > buf->capacity()) {
+    return Status(Error::GenericError, "JSON of " + std::to_string(carry_.size()) +
+                                           " bytes exceeds input buffer capacity.");
+  }
+  std::memcpy(buf->mutable_data(), carry_.data(), carry_.size());
+  *filled = carry_.size();
+  carry_.clear();
+  return Status::OK();
+}
+
+auto BufferingClient::ScanNewline(const char* data, size_t from, size_t to) -> size_t {
+  // Reverse scan only the newly received bytes for the last newline.
+  const char* newline = parse::custom::FindLastNewline(data + from, data + to);
+  if (newline == nullptr) {
+    return 0;
+  }
+  return newline - data + 1;
+}
+
+auto BufferingClient::FinishBuffer(size_t b, size_t filled, size_t complete, bool closed)
+    -> Status {
+  auto* buf = buffers_[b];
+  auto* data = reinterpret_cast<const char*>(buf->data());
+  if (complete < filled) {
+    carry_.assign(data + complete, data + filled);
+    if (closed) {
+      spdlog::warn("Server closed connection, dropping {} bytes of incomplete JSON.",
+                   carry_.size());
+      carry_.clear();
+    }
+  }
+
+  auto num_jsons = static_cast<uint64_t>(std::count(data, data + complete, '\n'));
+  if (num_jsons == 0) {
+    buf->Reset();
+    return Status::OK();
+  }
+
+  // Obtain a globally unique range of sequence numbers.
+  auto first = seq_->fetch_add(num_jsons);
+  BILLEX_ROE(buf->SetSize(complete));
+  buf->SetRange({first, first + num_jsons - 1});
+  buf->SetRecvTime(illex::Timer::now());
+  jsons_received_ += num_jsons;
+
+  return Status::OK();
+}
+
+auto BufferingClient::FillBuffer(size_t b, bool* closed) -> Status {
+  if (ring_ != nullptr) {
+    return FillRingView(b, closed);
+  }
+  auto* data = reinterpret_cast<char*>(buffers_[b]->mutable_data());
+  const size_t capacity = buffers_[b]->capacity();
+  size_t filled = 0;
+  BOLSON_ROE(PrepareBuffer(b, &filled));
+
+  // Receive until there is at least one newline in the buffer.
+  size_t complete = 0;
+  while (complete == 0) {
+    if (filled == capacity) {
+      return Status(Error::GenericError,
+                    "JSON exceeds input buffer capacity of " + std::to_string(capacity) +
+                        " bytes. Increase input buffer capacity.");
+    }
+    auto received = recv(socket_, data + filled, capacity - filled, 0);
+    syscalls_++;
+    if (received == 0) {
+      *closed = true;
+      break;
+    } else if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Status(Error::IOError,
+                    std::string("Unable to receive data: ") + std::strerror(errno));
+    }
+    complete = ScanNewline(data, filled, filled + received);
+    filled += received;
+    bytes_received_ += received;
+  }
+
+  // Everything up to and including the last newline are complete JSONs.
+  return FinishBuffer(b, filled, complete, *closed);
+}
+
+void BufferingClient::ReclaimViews() {
+  while (!in_flight_.empty()) {
+    auto f = in_flight_.front();
+    if (!mutexes_[f]->try_lock()) {
+      return;
+    }
+    bool parsed = buffers_[f]->empty();
+    mutexes_[f]->unlock();
+    if (!parsed) {
+      return;
+    }
+    ring_->Release(view_sizes_[f]);
+    in_flight_flags_[f] = false;
+    in_flight_.pop_front();
+  }
+}
+
+auto BufferingClient::FillRingView(size_t b, bool* closed) -> Status {
+  // Receive until the uncommitted region of the ring contains a newline.
+  while ((complete_ == 0) && !*closed) {
+    const size_t writable = ring_->writable();
+    if (writable == 0) {
+      if (in_flight_.empty()) {
+        return Status(Error::GenericError,
+                      "JSON exceeds ring buffer capacity of " +
+                          std::to_string(ring_->capacity()) +
+                          " bytes. Increase input buffer capacity.");
+      }
+      // The ring is full, try again once converters have released some regions.
+      return Status::OK();
+    }
+    // Thanks to the double mapping, the writable region is always contiguous.
+    auto* dest = reinterpret_cast<char*>(ring_->write_ptr());
+    auto received = recv(socket_, dest, writable, 0);
+    syscalls_++;
+    if (received == 0) {
+      *closed = true;
+      break;
+    } else if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Status(Error::IOError,
+                    std::string("Unable to receive data: ") + std::strerror(errno));
+    }
+    auto last = ScanNewline(dest, 0, received);
+    if (last > 0) {
+      complete_ = ring_->uncommitted() + last;
+    }
+    ring_->Produce(received);
+    bytes_received_ += received;
+  }
+
+  if (*closed && (ring_->uncommitted() > complete_)) {
+    spdlog::warn("Server closed connection, dropping {} bytes of incomplete JSON.",
+                 ring_->uncommitted() - complete_);
+  }
+
+  if (complete_ > 0) {
+    // Hand out a view of all complete JSONs. Incomplete JSONs stay in place.
+    auto* view = ring_->Commit(complete_);
+    auto* chars = reinterpret_cast<const char*>(view);
+    auto num_jsons = static_cast<uint64_t>(std::count(chars, chars + complete_, '\n'));
+    auto first = seq_->fetch_add(num_jsons);
+
+    auto* buf = buffers_[b];
+    BILLEX_ROE(illex::JSONBuffer::Create(view, complete_, buf));
+    BILLEX_ROE(buf->SetSize(complete_));
+    buf->SetRange({first, first + num_jsons - 1});
+    buf->SetRecvTime(illex::Timer::now());
+    jsons_received_ += num_jsons;
+
+    view_sizes_[b] = complete_;
+    in_flight_flags_[b] = true;
+    in_flight_.push_back(b);
+    complete_ = 0;
+  }
+
+  if (*closed) {
+    ring_->Discard();
+  }
+
+  return Status::OK();
+}
+
+auto BufferingClient::ReceiveJSONs(const WaitOptions& wait) -> Status {
+  const size_t num_buffers = buffers_.size();
+  Waiter waiter(wait, freed_);
+  size_t b = 0;
+  size_t attempts = 0;
+  bool closed = false;
+
+  t_receive_.Start();
+  while (!closed && !stop_.load()) {
+    if (ring_ != nullptr) {
+      ReclaimViews();
+    }
+    // Find the next unlocked and empty buffer in round-robin fashion.
+    if (!in_flight_flags_[b] && mutexes_[b]->try_lock()) {
+      if (buffers_[b]->empty()) {
+        auto status = FillBuffer(b, &closed);
+        bool filled = !buffers_[b]->empty();
+        mutexes_[b]->unlock();
+        if (!status.ok()) {
+          t_receive_.Stop();
+          return status;
+        }
+        // Wake up a converter thread.
+        if (filled) {
+          ready_[b]->enqueue(indices_[b]);
+          waiter.Reset();
+          attempts = 0;
+        }
+      } else {
+        mutexes_[b]->unlock();
+      }
+    }
+    b = (b + 1) % num_buffers;
+    attempts++;
+    // If all buffers are occupied, wait a bit for converters to empty them.
+    if (attempts > num_buffers) {
+      waiter.Wait();
+      attempts = 0;
+    }
+  }
+  t_receive_.Stop();
+
+  return Status::OK();
+}
+
+void BufferingClient::Stop() {
+  stop_.store(true);
+  // Unblock a pending recv().
+  if (socket_ >= 0) {
+    shutdown(socket_, SHUT_RDWR);
+  }
+}
+
+auto BufferingClient::Close() -> Status {
+  if (socket_ >= 0) {
+    if (close(socket_) != 0) {
+      return Status(Error::IOError,
+                    std::string("Unable to close socket: ") + std::strerror(errno));
+    }
+    socket_ = -1;
+  }
+  return Status::OK();
+}
+
+BufferingClient::~BufferingClient() { Close(); }
+
+auto CreateClients(const ClientOptions& opts, parse::ParserContext* context,
+                   std::atomic<uint64_t>* seq,
+                   std::vector<std::shared_ptr<BufferingClient>>* out) -> Status {
+  const size_t num_clients = opts.endpoints.size();
+  const size_t num_buffers = context->mutable_buffers().size();
+  if (num_clients == 0) {
+    return Status(Error::GenericError, "No JSON source endpoints supplied.");
+  }
+  if (num_clients > num_buffers) {
+    return Status(Error::GenericError,
+                  "Number of connections (" + std::to_string(num_clients) +
+                      ") exceeds number of input buffers (" +
+                      std::to_string(num_buffers) + ").");
+  }
+
+  // Distribute the buffers over the clients.
+  std::vector<std::vector<size_t>> indices(num_clients);
+  for (size_t b = 0; b < num_buffers; b++) {
+    indices[b % num_clients].push_back(b);
+  }
+
+  out->clear();
+  for (size_t c = 0; c < num_clients; c++) {
+    std::shared_ptr<BufferingClient> client;
+    BOLSON_ROE(BufferingClient::Create(opts.endpoints[c], context, indices[c], seq,
+                                       &client));
+    out->push_back(client);
+  }
+  return Status::OK();
+}
+
+auto ReceiveJSONs(const std::vector<std::shared_ptr<BufferingClient>>& clients,
+                  ClientIO io, const AffinityOptions& affinity,
+                  const WaitOptions& wait_opts) -> MultiThreadStatus {
+  // Client threads on isolated cores do not sleep while all buffers are occupied.
+  auto wait = affinity.WaitFor(ThreadRole::CLIENT, wait_opts);
+
+  if (io == ClientIO::URING) {
+    bool rings = std::any_of(clients.begin(), clients.end(),
+                             [](const auto& c) { return c->uses_ring(); });
+    if (rings) {
+      spdlog::warn("io_uring client does not support ring buffers, using blocking I/O.");
+    } else if (!UringAvailable()) {
+      spdlog::warn("io_uring is not available, using blocking I/O.");
+    } else {
+      bool fallback = false;
+      auto receiver = std::async(std::launch::async, [&]() {
+        BOLSON_ROE(PlaceCurrentThread(ThreadRole::CLIENT, 0, affinity));
+        return UringReceiver::Receive(clients, wait, &fallback);
+      });
+      auto status = receiver.get();
+      if (!fallback) {
+        return {status};
+      }
+    }
+  }
+
+  std::vector<std::future<Status>> futures;
+  for (size_t c = 0; c < clients.size(); c++) {
+    futures.push_back(std::async(std::launch::async, [&, c]() {
+      auto status = PlaceCurrentThread(ThreadRole::CLIENT, c, affinity);
+      if (status.ok()) {
+        status = clients[c]->ReceiveJSONs(wait);
+      }
+      // Stop all other clients on the first failure, rather than waiting for their
+      // servers to close the connections.
+      if (!status.ok()) {
+        for (const auto& client : clients) {
+          client->Stop();
+        }
+      }
+      return status;
+    }));
+  }
+  MultiThreadStatus result;
+  for (auto& f : futures) {
+    result.push_back(f.get());
+  }
+  return result;
+}
+
+auto JSONsReceived(const std::vector<std::shared_ptr<BufferingClient>>& clients)
+    -> size_t {
+  size_t result = 0;
+  for (const auto& client : clients) {
+    result += client->jsons_received();
+  }
+  return result;
+}
+
+auto Syscalls(const std::vector<std::shared_ptr<BufferingClient>>& clients) -> size_t {
+  size_t result = 0;
+  for (const auto& client : clients) {
+    result += client->syscalls();
+  }
+  return result;
+}
+
+auto Close(const std::vector<std::shared_ptr<BufferingClient>>& clients) -> Status {
+  for (const auto& client : clients) {
+    BOLSON_ROE(client->Close());
+  }
+  return Status::OK();
+}
+
+}  // namespace bolson::client
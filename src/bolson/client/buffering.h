@@ -0,0 +1,253 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <illex/client_buffering.h>
+#include <illex/protocol.h>
+#include <putong/timer.h>
+
+#include <CLI/CLI.hpp>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "bolson/affinity.h"
+#include "bolson/parse/parser.h"
+#include "bolson/status.h"
+
+/// Contains all constructs to receive raw JSON data from a source.
+namespace bolson::client {
+
+/// I/O interfaces used to receive from the TCP sockets.
+enum class ClientIO {
+  /// One thread per connection, blocking on recv().
+  BLOCKING,
+  /// One thread driving all connections through io_uring.
+  URING
+};
+
+/// \brief Return a human-readable name of a client I/O interface.
+auto ToString(ClientIO io) -> std::string;
+
+/// Options for the TCP client(s).
+struct ClientOptions {
+  /// JSON source TCP server hostname, used when no endpoints are supplied.
+  std::string host;
+  /// JSON source TCP server port, used when no endpoints are supplied.
+  uint16_t port = ILLEX_DEFAULT_PORT;
+  /// Number of connections to make to host:port.
+  size_t num_connections = 1;
+  /// Endpoints as "host:port" strings, one per connection.
+  std::vector<std::string> endpoints_str;
+  /// Parsed endpoints, one per connection.
+  std::vector<illex::ClientOptions> endpoints;
+  /// Receive into double-mapped ring buffers rather than fixed input buffers.
+  bool ring = false;
+  /// Back the ring buffers with huge pages.
+  bool ring_hugepages = false;
+  /// The I/O interface used to receive data.
+  ClientIO io = ClientIO::BLOCKING;
+
+  static auto io_map() -> std::map<std::string, ClientIO> {
+    static std::map<std::string, ClientIO> result = {{"blocking", ClientIO::BLOCKING},
+                                                     {"uring", ClientIO::URING}};
+    return result;
+  }
+
+  /// Derive the endpoints from the other options.
+  auto ParseInput() -> Status;
+};
+
+/// \brief Add client options to a CLI subcommand.
+void AddClientOptionsToCLI(CLI::App* sub, ClientOptions* opts);
+
+/**
+ * \brief A TCP client that receives newline-delimited JSONs into input buffers.
+ *
+ * The client round-robins over its subset of the input buffers, looking for a buffer
+ * that is unlocked and empty. It receives TCP data into that buffer, reverse scans the
+ * buffer for the last newline character, and carries over any trailing bytes of an
+ * incomplete JSON to the next buffer. Once a buffer contains a discrete number of JSONs,
+ * it is unlocked and its index is pushed onto the ready queue of the parser context,
+ * waking up a converter thread.
+ *
+ * When the input buffers of the parser context are backed by a ring buffer, the client
+ * receives directly into the ring. Input buffers are then re-created as views onto
+ * newline-aligned regions of the ring, such that incomplete JSONs are never copied.
+ * Regions are released back to the ring in order, once the converters have reset the
+ * input buffers viewing them.
+ *
+ * Multiple clients may feed the same parser context, as long as they operate on
+ * disjoint subsets of buffers. Sequence numbers are taken from a shared counter, so they
+ * are unique across clients.
+ */
+class BufferingClient {
+ public:
+  /**
+   * \brief Create a buffering client and connect it to the server.
+   * \param endpoint The server to connect to.
+   * \param context  The parser context holding the buffers and the ready queue.
+   * \param indices  The indices of the buffers this client may fill.
+   * \param seq      The shared counter to obtain sequence numbers from.
+   * \param out      The resulting client.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  static auto Create(const illex::ClientOptions& endpoint,
+                     parse::ParserContext* context, std::vector<size_t> indices,
+                     std::atomic<uint64_t>* seq, std::shared_ptr<BufferingClient>* out)
+      -> Status;
+
+  /**
+   * \brief Receive JSONs into the buffers until the server closes the connection.
+   * \param wait Wait strategy for when all buffers are occupied.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  auto ReceiveJSONs(const WaitOptions& wait = {}) -> Status;
+
+  /**
+   * \brief Make ReceiveJSONs() return as soon as possible, discarding unreceived data.
+   *
+   * May be called from any thread.
+   */
+  void Stop();
+
+  /// \brief Close the connection.
+  auto Close() -> Status;
+
+  /// \brief Return the endpoint this client is connected to.
+  [[nodiscard]] auto endpoint() const -> const illex::ClientOptions& { return endpoint_; }
+  /// \brief Return the number of bytes received.
+  [[nodiscard]] auto bytes_received() const -> size_t { return bytes_received_; }
+  /// \brief Return the number of JSONs received.
+  [[nodiscard]] auto jsons_received() const -> size_t { return jsons_received_; }
+  /// \brief Return true if this client receives into a ring buffer.
+  [[nodiscard]] auto uses_ring() const -> bool { return ring_ != nullptr; }
+  /// \brief Return the number of receive system calls made.
+  [[nodiscard]] auto syscalls() const -> size_t { return syscalls_; }
+  /// \brief Return the time spent in ReceiveJSONs() in seconds.
+  [[nodiscard]] auto receive_time() const -> double { return t_receive_.seconds(); }
+
+  ~BufferingClient();
+
+ private:
+  friend class UringReceiver;
+
+  BufferingClient() = default;
+
+  /// \brief Copy the carried-over bytes to the start of buffer b, setting filled.
+  auto PrepareBuffer(size_t b, size_t* filled) -> Status;
+  /// \brief Return the length of data up to and including the last newline in
+  ///        [from, to), or 0 if there is none.
+  static auto ScanNewline(const char* data, size_t from, size_t to) -> size_t;
+  /// \brief Carry over the bytes of buffer b beyond complete, and set up the buffer to
+  ///        hold the complete JSONs.
+  auto FinishBuffer(size_t b, size_t filled, size_t complete, bool closed) -> Status;
+
+  /// \brief Fill buffer b with JSONs, sets closed if the server closed the connection.
+  auto FillBuffer(size_t b, bool* closed) -> Status;
+  /// \brief Point buffer b to a newly received region of the ring.
+  auto FillRingView(size_t b, bool* closed) -> Status;
+  /// \brief Release ring regions of parsed buffers, in order.
+  void ReclaimViews();
+
+  /// The server this client is connected to.
+  illex::ClientOptions endpoint_;
+  /// Socket file descriptor.
+  int socket_ = -1;
+  /// Indices of the buffers in the parser context.
+  std::vector<size_t> indices_;
+  /// The buffers to fill.
+  std::vector<illex::JSONBuffer*> buffers_;
+  /// The mutexes of the buffers.
+  std::vector<std::mutex*> mutexes_;
+  /// The queues to push indices of filled buffers onto, per buffer.
+  std::vector<parse::ReadyQueue*> ready_;
+  /// Notified by converters whenever they free a buffer.
+  WakeSignal* freed_ = nullptr;
+  /// Bytes of an incomplete JSON to carry over to the next buffer.
+  std::vector<char> carry_;
+  /// The ring backing the buffers, if any.
+  buffer::RingBuffer* ring_ = nullptr;
+  /// Buffers viewing a region of the ring that was not released yet, in order.
+  std::deque<size_t> in_flight_;
+  /// Whether a buffer is in flight.
+  std::vector<bool> in_flight_flags_;
+  /// Size of the ring region viewed by each buffer.
+  std::vector<size_t> view_sizes_;
+  /// Number of uncommitted bytes in the ring up to and including the last newline.
+  size_t complete_ = 0;
+  /// Set when the client should stop receiving.
+  std::atomic<bool> stop_ = false;
+  /// Shared counter of sequence numbers.
+  std::atomic<uint64_t>* seq_ = nullptr;
+  /// Number of bytes received.
+  size_t bytes_received_ = 0;
+  /// Number of JSONs received.
+  size_t jsons_received_ = 0;
+  /// Number of receive system calls.
+  size_t syscalls_ = 0;
+  /// Time spent receiving.
+  putong::Timer<> t_receive_;
+};
+
+/**
+ * \brief Create one client per endpoint, all feeding the same parser context.
+ *
+ * Input buffers are distributed over the clients in round-robin fashion.
+ *
+ * \param opts     The client options.
+ * \param context  The parser context holding the buffers and the ready queue.
+ * \param seq      The shared counter to obtain sequence numbers from.
+ * \param out      The resulting clients.
+ * \return Status::OK() if successful, some error otherwise.
+ */
+auto CreateClients(const ClientOptions& opts, parse::ParserContext* context,
+                   std::atomic<uint64_t>* seq,
+                   std::vector<std::shared_ptr<BufferingClient>>* out) -> Status;
+
+/**
+ * \brief Receive JSONs on all clients concurrently, until all servers disconnect.
+ *
+ * When io_uring is requested but not available, or when the clients receive into ring
+ * buffers, this falls back to blocking I/O.
+ *
+ * Every client runs in its own thread, named and pinned according to the affinity
+ * options. The io_uring receiver runs all clients in a single thread.
+ *
+ * \param clients  The clients.
+ * \param io       The I/O interface to use.
+ * \param affinity CPU affinity of the client threads.
+ * \param wait     Wait strategy for when all buffers are occupied.
+ * \return The status of each client.
+ */
+auto ReceiveJSONs(const std::vector<std::shared_ptr<BufferingClient>>& clients,
+                  ClientIO io = ClientIO::BLOCKING, const AffinityOptions& affinity = {},
+                  const WaitOptions& wait = {}) -> MultiThreadStatus;
+
+/// \brief Return the total number of receive system calls made for all clients.
+auto Syscalls(const std::vector<std::shared_ptr<BufferingClient>>& clients) -> size_t;
+
+/// \brief Return the total number of JSONs received by all clients.
+auto JSONsReceived(const std::vector<std::shared_ptr<BufferingClient>>& clients)
+    -> size_t;
+
+/// \brief Close all clients.
+auto Close(const std::vector<std::shared_ptr<BufferingClient>>& clients) -> Status;
+
+}  // namespace bolson::client
@@ -0,0 +1,354 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/client/uring.h"
+
+#ifdef BOLSON_WITH_IO_URING
+#include <liburing.h>
+#include <sys/uio.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <thread>
+
+#include "bolson/latency.h"
+#include "bolson/log.h"
+
+namespace bolson::client {
+
+#ifdef BOLSON_WITH_IO_URING
+
+auto UringAvailable() -> bool {
+  io_uring ring{};
+  if (io_uring_queue_init(1, &ring, 0) < 0) {
+    return false;
+  }
+  io_uring_queue_exit(&ring);
+  return true;
+}
+
+/// State of a single connection driven by the receiver.
+struct UringReceiver::Connection {
+  /// The client owning the socket and buffers.
+  BufferingClient* client = nullptr;
+  /// Index of the first registered buffer of this client.
+  unsigned int first_registered = 0;
+  /// The locked buffer currently being filled, or npos if none.
+  size_t b = std::numeric_limits<size_t>::max();
+  /// Number of bytes in the current buffer.
+  size_t filled = 0;
+  /// The buffer to try first when acquiring a free buffer.
+  size_t next = 0;
+  /// Whether a read is in flight.
+  bool pending = false;
+  /// Whether the server closed the connection.
+  bool closed = false;
+
+  [[nodiscard]] auto has_buffer() const -> bool {
+    return b != std::numeric_limits<size_t>::max();
+  }
+};
+
+auto UringReceiver::AcquireBuffer(Connection* c) -> Status {
+  auto* client = c->client;
+  const size_t num_buffers = client->buffers_.size();
+  for (size_t i = 0; i < num_buffers; i++) {
+    size_t b = (c->next + i) % num_buffers;
+    if (!client->mutexes_[b]->try_lock()) {
+      continue;
+    }
+    if (!client->buffers_[b]->empty()) {
+      client->mutexes_[b]->unlock();
+      continue;
+    }
+    auto status = client->PrepareBuffer(b, &c->filled);
+    if (!status.ok()) {
+      client->mutexes_[b]->unlock();
+      return status;
+    }
+    c->b = b;
+    c->next = (b + 1) % num_buffers;
+    return Status::OK();
+  }
+  return Status::OK();
+}
+
+auto UringReceiver::ReleaseBuffer(Connection* c, size_t complete) -> Status {
+  auto* client = c->client;
+  auto status = client->FinishBuffer(c->b, c->filled, complete, c->closed);
+  bool filled = !client->buffers_[c->b]->empty();
+  client->mutexes_[c->b]->unlock();
+  if (filled) {
+    client->ready_[c->b]->enqueue(client->indices_[c->b]);
+  }
+  c->b = std::numeric_limits<size_t>::max();
+  c->filled = 0;
+  return status;
+}
+
+auto UringReceiver::Complete(Connection* c, size_t num_bytes) -> Status {
+  auto* client = c->client;
+  auto* buf = client->buffers_[c->b];
+  auto* data = reinterpret_cast<const char*>(buf->data());
+  if (num_bytes == 0) {
+    c->closed = true;
+  }
+  size_t last = BufferingClient::ScanNewline(data, c->filled, c->filled + num_bytes);
+  c->filled += num_bytes;
+  client->bytes_received_ += num_bytes;
+  if (last > 0) {
+    // Earlier reads into this buffer had no newline, so this is the last newline.
+    return ReleaseBuffer(c, last);
+  }
+  if (c->closed) {
+    return ReleaseBuffer(c, 0);
+  }
+  if (c->filled == buf->capacity()) {
+    return Status(Error::GenericError,
+                  "JSON exceeds input buffer capacity of " +
+                      std::to_string(buf->capacity()) +
+                      " bytes. Increase input buffer capacity.");
+  }
+  return Status::OK();
+}
+
+auto UringReceiver::ReceiveLoop(io_uring* ring, std::vector<Connection>* conns,
+                                Waiter* waiter) -> Status {
+  size_t open = conns->size();
+  io_uring_cqe* cqes[BOLSON_URING_CQE_BATCH];
+
+  while (open > 0) {
+    // Queue a read for every connection that has none in flight.
+    bool starved = false;
+    size_t in_flight = 0;
+    // The connection the next system call is accounted to.
+    Connection* submitter = nullptr;
+    for (auto& c : *conns) {
+      if (c.closed) {
+        continue;
+      }
+      if (!c.pending) {
+        if (!c.has_buffer()) {
+          BOLSON_ROE(AcquireBuffer(&c));
+        }
+        if (!c.has_buffer()) {
+          starved = true;
+          continue;
+        }
+        auto* buf = c.client->buffers_[c.b];
+        auto* sqe = io_uring_get_sqe(ring);
+        if (sqe == nullptr) {
+          return Status(Error::IOError, "io_uring submission queue is full.");
+        }
+        io_uring_prep_read_fixed(sqe, c.client->socket_, buf->mutable_data() + c.filled,
+                                 static_cast<unsigned int>(buf->capacity() - c.filled), 0,
+                                 static_cast<int>(c.first_registered + c.b));
+        io_uring_sqe_set_data(sqe, &c);
+        c.pending = true;
+        if (submitter == nullptr) {
+          submitter = &c;
+        }
+      }
+      in_flight++;
+    }
+
+    if (in_flight == 0) {
+      // All buffers are occupied, wait a bit for converters to empty them.
+      waiter->Wait();
+      continue;
+    }
+    waiter->Reset();
+
+    // Submit new reads and wait for completions in a single system call. If some
+    // connection is waiting for a free buffer, do not block indefinitely.
+    int ret = 0;
+    if (starved) {
+      __kernel_timespec ts{0, BOLSON_QUEUE_WAIT_US * 1000};
+      io_uring_cqe* cqe = nullptr;
+      ret = io_uring_submit_and_wait_timeout(ring, &cqe, 1, &ts, nullptr);
+      if (ret == -ETIME) {
+        ret = 0;
+      }
+    } else {
+      ret = io_uring_submit_and_wait(ring, 1);
+    }
+    // Account the system call to the first connection that submitted a read with it, or
+    // to any open connection if it only waited for completions.
+    if (submitter == nullptr) {
+      submitter = &*std::find_if(conns->begin(), conns->end(),
+                                 [](const Connection& c) { return !c.closed; });
+    }
+    submitter->client->syscalls_++;
+    if ((ret < 0) && (ret != -EINTR)) {
+      return Status(Error::IOError,
+                    std::string("io_uring wait failed: ") + std::strerror(-ret));
+    }
+
+    // Reap completions in batches.
+    unsigned int reaped = io_uring_peek_batch_cqe(ring, cqes, BOLSON_URING_CQE_BATCH);
+
+    Status status = Status::OK();
+    for (unsigned int i = 0; i < reaped; i++) {
+      auto* c = static_cast<Connection*>(io_uring_cqe_get_data(cqes[i]));
+      int res = cqes[i]->res;
+      // Every reaped read is no longer in flight, also those after an error.
+      c->pending = false;
+      if (!status.ok() || (res == -EINTR) || (res == -EAGAIN)) {
+        continue;
+      }
+      if (res < 0) {
+        status = Status(Error::IOError,
+                        std::string("Unable to receive data: ") + std::strerror(-res));
+        continue;
+      }
+      status = Complete(c, static_cast<size_t>(res));
+      if (status.ok() && c->closed) {
+        open--;
+      }
+    }
+    io_uring_cq_advance(ring, reaped);
+    BOLSON_ROE(status);
+  }
+  return Status::OK();
+}
+
+void UringReceiver::CancelPending(io_uring* ring, std::vector<Connection>* conns) {
+  size_t pending = 0;
+  for (auto& c : *conns) {
+    if (!c.pending) {
+      continue;
+    }
+    auto* sqe = io_uring_get_sqe(ring);
+    if (sqe == nullptr) {
+      io_uring_submit(ring);
+      sqe = io_uring_get_sqe(ring);
+    }
+    if (sqe != nullptr) {
+      io_uring_prep_cancel(sqe, &c, 0);
+      // Completions of cancellations carry no connection.
+      io_uring_sqe_set_data(sqe, nullptr);
+    }
+    pending++;
+  }
+  if (pending == 0) {
+    return;
+  }
+  io_uring_submit(ring);
+
+  // Reads that could not be cancelled complete on their own, e.g. when the server
+  // closes the connection.
+  while (pending > 0) {
+    io_uring_cqe* cqe = nullptr;
+    int ret = io_uring_wait_cqe(ring, &cqe);
+    if (ret == -EINTR) {
+      continue;
+    }
+    if (ret < 0) {
+      spdlog::warn("Unable to reap cancelled io_uring reads: {}", std::strerror(-ret));
+      return;
+    }
+    auto* c = static_cast<Connection*>(io_uring_cqe_get_data(cqe));
+    if ((c != nullptr) && c->pending) {
+      c->pending = false;
+      pending--;
+    }
+    io_uring_cqe_seen(ring, cqe);
+  }
+}
+
+auto UringReceiver::Receive(const std::vector<std::shared_ptr<BufferingClient>>& clients,
+                            const WaitOptions& wait, bool* fallback) -> Status {
+  *fallback = false;
+  if (clients.empty()) {
+    return Status::OK();
+  }
+
+  // Register the input buffers of all clients with the kernel.
+  std::vector<Connection> conns(clients.size());
+  std::vector<iovec> iovecs;
+  for (size_t i = 0; i < clients.size(); i++) {
+    if (clients[i]->ring_ != nullptr) {
+      return Status(Error::GenericError,
+                    "io_uring client does not support ring buffers.");
+    }
+    conns[i].client = clients[i].get();
+    conns[i].first_registered = static_cast<unsigned int>(iovecs.size());
+    for (auto* buf : clients[i]->buffers_) {
+      iovecs.push_back({buf->mutable_data(), buf->capacity()});
+    }
+  }
+
+  io_uring ring{};
+  auto entries = static_cast<unsigned int>(2 * clients.size());
+  int ret = io_uring_queue_init(entries, &ring, 0);
+  if (ret < 0) {
+    spdlog::warn("Unable to initialize io_uring: {}, using blocking I/O.",
+                 std::strerror(-ret));
+    *fallback = true;
+    return Status::OK();
+  }
+  // Registering buffers fails e.g. when they exceed the locked memory limit.
+  ret = io_uring_register_buffers(&ring, iovecs.data(),
+                                  static_cast<unsigned int>(iovecs.size()));
+  if (ret < 0) {
+    io_uring_queue_exit(&ring);
+    spdlog::warn("Unable to register io_uring buffers: {}, using blocking I/O.",
+                 std::strerror(-ret));
+    *fallback = true;
+    return Status::OK();
+  }
+
+  for (const auto& client : clients) {
+    client->t_receive_.Start();
+  }
+  // All clients feed the same parser context, so they share the signal of freed buffers.
+  Waiter waiter(wait, clients[0]->freed_);
+  auto status = ReceiveLoop(&ring, &conns, &waiter);
+  for (const auto& client : clients) {
+    client->t_receive_.Stop();
+  }
+
+  // After an error, reads of other connections may still be in flight. The kernel must
+  // be done with their buffers before they can go back to the pool.
+  CancelPending(&ring, &conns);
+  io_uring_queue_exit(&ring);
+
+  // Release any buffer left locked by an error.
+  for (auto& c : conns) {
+    if (c.has_buffer()) {
+      c.client->buffers_[c.b]->Reset();
+      c.client->mutexes_[c.b]->unlock();
+    }
+  }
+  return status;
+}
+
+#else
+
+auto UringAvailable() -> bool { return false; }
+
+auto UringReceiver::Receive(const std::vector<std::shared_ptr<BufferingClient>>&,
+                            const WaitOptions&, bool* fallback) -> Status {
+  *fallback = false;
+  return Status(Error::GenericError, "Bolson was built without io_uring support.");
+}
+
+#endif
+
+}  // namespace bolson::client
@@ -0,0 +1,77 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "bolson/client/buffering.h"
+#include "bolson/status.h"
+#include "bolson/wait.h"
+
+/// Maximum number of completions reaped from the io_uring completion queue at once.
+#define BOLSON_URING_CQE_BATCH 64
+
+struct io_uring;
+
+namespace bolson::client {
+
+/// \brief Return true if this build supports io_uring and the kernel allows it.
+auto UringAvailable() -> bool;
+
+/**
+ * \brief Drives the sockets of multiple buffering clients through a single io_uring.
+ *
+ * All input buffers of all clients are registered with the ring up front, such that
+ * reads land directly in the buffers without the kernel having to map them on every
+ * call. Each connection has exactly one fixed-buffer read in flight, which preserves the
+ * byte order of the TCP stream. Completions are reaped in batches; a buffer that holds
+ * at least one newline is finished, unlocked and pushed onto the ready queue, after which
+ * the connection continues in the next free buffer.
+ *
+ * Submitting new reads and waiting for completions share a single system call, so the
+ * number of system calls per received byte is typically far lower than with blocking
+ * recv() calls.
+ */
+class UringReceiver {
+ public:
+  /**
+   * \brief Receive JSONs on all clients until all servers disconnect.
+   * \param clients The clients. They may not receive into ring buffers.
+   * \param wait     Wait strategy for when all buffers are occupied.
+   * \param fallback Set to true if io_uring could not be set up, in which case nothing
+   *                 was received and the clients should use blocking I/O instead.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  static auto Receive(const std::vector<std::shared_ptr<BufferingClient>>& clients,
+                      const WaitOptions& wait, bool* fallback) -> Status;
+
+ private:
+  struct Connection;
+
+  /// \brief Run the receive loop on an initialized ring.
+  static auto ReceiveLoop(io_uring* ring, std::vector<Connection>* conns,
+                          Waiter* waiter) -> Status;
+  /// \brief Try to lock an empty buffer for a connection.
+  static auto AcquireBuffer(Connection* c) -> Status;
+  /// \brief Process a completed read of num_bytes for a connection.
+  static auto Complete(Connection* c, size_t num_bytes) -> Status;
+  /// \brief Hand off the current buffer of a connection to the converters.
+  static auto ReleaseBuffer(Connection* c, size_t complete) -> Status;
+  /// \brief Cancel all reads in flight and wait until the kernel completed them.
+  static void CancelPending(io_uring* ring, std::vector<Connection>* conns);
+};
+
+}  // namespace bolson::client
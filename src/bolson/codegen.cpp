@@ -0,0 +1,97 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+
+#include <CLI/CLI.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "bolson/parse/custom/codegen.h"
+#include "bolson/status.h"
+
+// Build-time generator of schema-specialized parsers. This tool is built and run by
+// CMake before Bolson itself is compiled, so it only depends on Arrow.
+
+namespace bolson {
+
+static auto ReadSchema(const std::string& file, std::shared_ptr<arrow::Schema>* out)
+    -> Status {
+  auto file_result = arrow::io::ReadableFile::Open(file);
+  if (!file_result.ok()) {
+    return Status(Error::IOError, file_result.status().message());
+  }
+  auto schema_result = arrow::ipc::ReadSchema(file_result.ValueOrDie().get(), nullptr);
+  if (!schema_result.ok()) {
+    return Status(Error::IOError, schema_result.status().message());
+  }
+  *out = schema_result.ValueOrDie();
+  return Status::OK();
+}
+
+static auto WriteFile(const std::filesystem::path& path, const std::string& contents)
+    -> Status {
+  std::ofstream file(path);
+  file << contents;
+  if (!file.good()) {
+    return Status(Error::IOError, "Unable to write " + path.string());
+  }
+  return Status::OK();
+}
+
+static auto Generate(const std::string& name, const std::string& schema_file,
+                     const std::string& output_dir) -> Status {
+  std::shared_ptr<arrow::Schema> schema;
+  BOLSON_ROE(ReadSchema(schema_file, &schema));
+
+  parse::custom::GeneratedSources sources;
+  BOLSON_ROE(parse::custom::GenerateParser(*schema, name, &sources));
+
+  auto dir = std::filesystem::path(output_dir) / "bolson" / "parse" / "generated";
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    return Status(Error::IOError, "Unable to create " + dir.string());
+  }
+  BOLSON_ROE(WriteFile(dir / (name + ".h"), sources.header));
+  BOLSON_ROE(WriteFile(dir / (name + ".cpp"), sources.source));
+  return Status::OK();
+}
+
+}  // namespace bolson
+
+auto main(int argc, char* argv[]) -> int {
+  CLI::App app{"bolson-codegen : Generate a parser specialized for an Arrow schema."};
+  std::string name;
+  std::string schema_file;
+  std::string output_dir;
+  app.add_option("name", name, "Name of the parser, a valid C++ identifier.")
+      ->required();
+  app.add_option("schema", schema_file, "Serialized Arrow schema file.")
+      ->required()
+      ->check(CLI::ExistingFile);
+  app.add_option("output", output_dir, "Root directory of the generated sources.")
+      ->required();
+  CLI11_PARSE(app, argc, argv);
+
+  auto status = bolson::Generate(name, schema_file, output_dir);
+  if (!status.ok()) {
+    std::cerr << "bolson-codegen: " << status.msg() << std::endl;
+    return -1;
+  }
+  return 0;
+}
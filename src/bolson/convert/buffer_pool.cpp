@@ -0,0 +1,84 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/convert/buffer_pool.h"
+
+#include <utility>
+
+namespace bolson::convert {
+
+auto BufferPool::SizeClass(int64_t size) -> size_t {
+  size_t bits = kMinClassBits;
+  while ((int64_t{1} << bits) < size) {
+    bits++;
+  }
+  return bits - kMinClassBits;
+}
+
+auto BufferPool::Acquire(int64_t size, std::shared_ptr<arrow::Buffer>* out,
+                         bool* allocated) -> Status {
+  const size_t size_class = SizeClass(size);
+  const int64_t capacity = int64_t{1} << (size_class + kMinClassBits);
+
+  std::unique_ptr<arrow::Buffer> buffer;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if ((size_class < idle_.size()) && !idle_[size_class].empty()) {
+      buffer = std::move(idle_[size_class].back());
+      idle_[size_class].pop_back();
+      idle_bytes_ -= static_cast<size_t>(capacity);
+    }
+  }
+  *allocated = buffer == nullptr;
+  if (buffer == nullptr) {
+    auto result = arrow::AllocateBuffer(capacity);
+    if (!result.ok()) {
+      return Status(Error::ArrowError, result.status().message());
+    }
+    buffer = std::move(result).ValueOrDie();
+  }
+
+  // Hand out a view onto the buffer, which returns the buffer once it is destroyed.
+  auto* data = buffer->mutable_data();
+  auto pool = shared_from_this();
+  auto* owned = buffer.release();
+  *out = std::shared_ptr<arrow::Buffer>(
+      new arrow::MutableBuffer(data, capacity),
+      [pool, size_class, owned](arrow::Buffer* view) {
+        delete view;
+        pool->Release(size_class, std::unique_ptr<arrow::Buffer>(owned));
+      });
+  return Status::OK();
+}
+
+void BufferPool::Release(size_t size_class, std::unique_ptr<arrow::Buffer> buffer) {
+  const auto capacity = static_cast<size_t>(buffer->size());
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (idle_bytes_ + capacity > max_idle_bytes_) {
+    // Free the buffer.
+    return;
+  }
+  if (size_class >= idle_.size()) {
+    idle_.resize(size_class + 1);
+  }
+  idle_[size_class].push_back(std::move(buffer));
+  idle_bytes_ += capacity;
+}
+
+auto BufferPool::idle_bytes() const -> size_t {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return idle_bytes_;
+}
+
+}  // namespace bolson::convert
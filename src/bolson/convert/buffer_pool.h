@@ -0,0 +1,76 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "bolson/status.h"
+
+namespace bolson::convert {
+
+/**
+ * \brief A pool of reusable buffers for IPC messages, in power-of-two size classes.
+ *
+ * Acquired buffers return to the pool when their last reference drops, which for IPC
+ * messages is after they are published, on any thread. Idle buffers are kept up to a
+ * total size, beyond which released buffers are freed. At high message rates, this
+ * avoids allocating and freeing a buffer for every message.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+ public:
+  /**
+   * \brief Construct a buffer pool. Must be owned by a shared pointer.
+   * \param max_idle_bytes The maximum total size of idle buffers, 0 to keep none.
+   */
+  explicit BufferPool(size_t max_idle_bytes) : max_idle_bytes_(max_idle_bytes) {}
+
+  /**
+   * \brief Acquire a mutable buffer.
+   * \param size      The minimum size of the buffer.
+   * \param out       The buffer, sized to its size class.
+   * \param allocated Set to true if the buffer was allocated, rather than reused.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  auto Acquire(int64_t size, std::shared_ptr<arrow::Buffer>* out, bool* allocated)
+      -> Status;
+
+  /// \brief Return the total size of idle buffers.
+  [[nodiscard]] auto idle_bytes() const -> size_t;
+
+ private:
+  /// Log2 of the size of the smallest size class.
+  static constexpr size_t kMinClassBits = 12;
+
+  /// \brief Return the size class of a buffer size.
+  static auto SizeClass(int64_t size) -> size_t;
+
+  /// \brief Return a buffer of a size class to the pool, or free it if the pool is full.
+  void Release(size_t size_class, std::unique_ptr<arrow::Buffer> buffer);
+
+  /// Protects the idle buffers.
+  mutable std::mutex mutex_;
+  /// Idle buffers of every size class.
+  std::vector<std::vector<std::unique_ptr<arrow::Buffer>>> idle_;
+  /// Total size of idle buffers.
+  size_t idle_bytes_ = 0;
+  /// Maximum total size of idle buffers.
+  size_t max_idle_bytes_ = 0;
+};
+
+}  // namespace bolson::convert
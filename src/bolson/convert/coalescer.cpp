@@ -0,0 +1,136 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/convert/coalescer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "bolson/convert/resizer.h"
+
+namespace bolson::convert {
+
+void AddCoalesceOptionsToCLI(CLI::App* sub, CoalesceOptions* out) {
+  sub->add_option("--coalesce-linger-us", out->linger_us,
+                  "Coalesce small parsed batches of any converter thread into larger "
+                  "batches, holding them for at most this many microseconds. 0 disables "
+                  "coalescing.")
+      ->default_val(0);
+  sub->add_option("--coalesce-rows", out->target_rows,
+                  "Target number of rows of coalesced batches. 0 uses --max-rows.")
+      ->default_val(0);
+  sub->add_option("--coalesce-bytes", out->target_bytes,
+                  "Target IPC message size in bytes of coalesced batches. 0 uses "
+                  "--max-ipc.")
+      ->default_val(0);
+}
+
+/// \brief Return the smallest non-zero limit, or the maximum value if both are zero.
+static auto ClampLimit(size_t target, size_t max) -> size_t {
+  target = target == 0 ? std::numeric_limits<size_t>::max() : target;
+  max = max == 0 ? std::numeric_limits<size_t>::max() : max;
+  return std::min(target, max);
+}
+
+Coalescer::Coalescer(const CoalesceOptions& opts, size_t max_rows, size_t max_bytes)
+    : linger_us_(opts.linger_us),
+      target_rows_(ClampLimit(opts.target_rows, max_rows)),
+      target_bytes_(ClampLimit(opts.target_bytes, max_bytes)) {}
+
+auto Coalescer::Push(const parse::ParsedBatch& batch, const TimePoints& time_points,
+                     std::vector<CoalescedBatch>* out) -> Status {
+  const auto rows = static_cast<size_t>(batch.batch->num_rows());
+  const size_t bytes = EstimateBufferSize(*batch.batch);
+  const auto now = illex::Timer::now();
+
+  std::vector<Group> ready;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Take the pending batches first if this batch would not fit.
+    if (!pending_.parts.empty() && ((pending_.rows + rows > target_rows_) ||
+                                    (pending_.bytes + bytes > target_bytes_))) {
+      ready.push_back(std::move(pending_));
+      pending_ = Group();
+    }
+    if (pending_.parts.empty()) {
+      pending_.bytes = EstimateMessageOverhead(*batch.batch);
+      pending_.deadline = now + std::chrono::microseconds(linger_us_);
+    }
+    pending_.parts.push_back({batch, time_points});
+    pending_.rows += rows;
+    pending_.bytes += bytes;
+    if ((pending_.rows >= target_rows_) || (pending_.bytes >= target_bytes_) ||
+        (now >= pending_.deadline)) {
+      ready.push_back(std::move(pending_));
+      pending_ = Group();
+    }
+  }
+
+  // Concatenate outside of the lock, such that other threads can keep adding batches.
+  for (auto& group : ready) {
+    BOLSON_ROE(Merge(&group, out));
+  }
+  return Status::OK();
+}
+
+auto Coalescer::Poll(bool flush, std::vector<CoalescedBatch>* out) -> Status {
+  Group group;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.parts.empty() || (!flush && (illex::Timer::now() < pending_.deadline))) {
+      return Status::OK();
+    }
+    group = std::move(pending_);
+    pending_ = Group();
+  }
+  return Merge(&group, out);
+}
+
+auto Coalescer::Merge(Group* group, std::vector<CoalescedBatch>* out) -> Status {
+  auto& parts = group->parts;
+  // Batches of multiple threads may arrive out of order.
+  std::sort(parts.begin(), parts.end(),
+            [](const CoalescedBatch& a, const CoalescedBatch& b) {
+              return a.parsed.seq_range.first < b.parsed.seq_range.first;
+            });
+
+  // Concatenate every run of parts with contiguous sequence numbers.
+  size_t first = 0;
+  for (size_t p = 1; p <= parts.size(); p++) {
+    if ((p < parts.size()) &&
+        (parts[p].parsed.seq_range.first == parts[p - 1].parsed.seq_range.last + 1)) {
+      continue;
+    }
+    CoalescedBatch coalesced;
+    std::vector<parse::ParsedBatch> run;
+    coalesced.time_points = parts[first].time_points;
+    for (size_t r = first; r < p; r++) {
+      run.push_back(parts[r].parsed);
+      // Latency is measured from the part that was received first.
+      const auto& points = parts[r].time_points;
+      if (points[TimePoints::received] < coalesced.time_points[TimePoints::received]) {
+        coalesced.time_points = points;
+      }
+    }
+    BOLSON_ROE(parse::StitchBatches(run, &coalesced.parsed));
+    out->push_back(std::move(coalesced));
+    first = p;
+  }
+  return Status::OK();
+}
+
+}  // namespace bolson::convert
@@ -0,0 +1,122 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+#include <illex/client_buffering.h>
+#include <illex/latency.h>
+
+#include <CLI/CLI.hpp>
+#include <mutex>
+#include <vector>
+
+#include "bolson/latency.h"
+#include "bolson/parse/parser.h"
+#include "bolson/status.h"
+
+namespace bolson::convert {
+
+/// Coalescing options.
+struct CoalesceOptions {
+  /// Maximum time in microseconds a parsed batch waits for others to be coalesced with.
+  /// Zero disables coalescing.
+  size_t linger_us = 0;
+  /// Target number of rows of coalesced batches, zero for the maximum rows per batch.
+  size_t target_rows = 0;
+  /// Target IPC message size in bytes of coalesced batches, zero for the maximum IPC
+  /// message size.
+  size_t target_bytes = 0;
+};
+
+/// \brief Add coalescing options to a CLI subcommand.
+void AddCoalesceOptionsToCLI(CLI::App* sub, CoalesceOptions* out);
+
+/// A batch coalesced from one or more parsed batches.
+struct CoalescedBatch {
+  /// The coalesced batch.
+  parse::ParsedBatch parsed;
+  /// The time points up to parsing of the part that was received first.
+  TimePoints time_points;
+};
+
+/**
+ * \brief Coalesces small parsed batches of any number of converter threads.
+ *
+ * Parsed batches are held until they add up to the target number of rows or message
+ * size, or until the first of them lingered for the maximum time, after which they are
+ * concatenated into a single batch. This decouples the size of IPC messages from the
+ * size of input buffers, which is small when the input rate is low.
+ *
+ * Targets are clamped to the limits of the resizer, so coalesced batches are never
+ * sliced again. Taken batches are sorted by sequence number and only contiguous runs of
+ * them are concatenated, so the sequence number range of a coalesced batch holds
+ * exactly its rows and skipped JSONs. A batch of which the predecessor is still being
+ * parsed by another thread thus starts a coalesced batch of its own.
+ */
+class Coalescer {
+ public:
+  /**
+   * \brief Construct a coalescer.
+   * \param opts      Coalescing options.
+   * \param max_rows  The maximum number of rows of a batch, or 0 for no limit.
+   * \param max_bytes The maximum size of the IPC message of a batch, or 0 for no limit.
+   */
+  Coalescer(const CoalesceOptions& opts, size_t max_rows, size_t max_bytes);
+
+  /**
+   * \brief Add a parsed batch, and take any batches that are ready.
+   * \param batch       The parsed batch.
+   * \param time_points The time points of the batch up to parsing.
+   * \param out         Coalesced batches that are ready, appended in order.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  auto Push(const parse::ParsedBatch& batch, const TimePoints& time_points,
+            std::vector<CoalescedBatch>* out) -> Status;
+
+  /**
+   * \brief Take the pending batches if they lingered for the maximum time.
+   * \param flush Take the pending batches regardless of how long they lingered.
+   * \param out   Coalesced batches, if any, are appended to this.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  auto Poll(bool flush, std::vector<CoalescedBatch>* out) -> Status;
+
+ private:
+  /// Parsed batches waiting to be coalesced.
+  struct Group {
+    /// The parsed batches, with their own time points.
+    std::vector<CoalescedBatch> parts;
+    /// The total number of rows.
+    size_t rows = 0;
+    /// The upper bound of the IPC message size.
+    size_t bytes = 0;
+    /// The time after which the group is taken, regardless of its size.
+    illex::TimePoint deadline;
+  };
+
+  /// \brief Concatenate every contiguous run of the parts of a group into a batch.
+  static auto Merge(Group* group, std::vector<CoalescedBatch>* out) -> Status;
+
+  size_t linger_us_ = 0;
+  size_t target_rows_ = 0;
+  size_t target_bytes_ = 0;
+
+  /// Protects the pending group.
+  std::mutex mutex_;
+  /// The group batches are currently added to.
+  Group pending_;
+};
+
+}  // namespace bolson::convert
@@ -17,11 +17,13 @@
 #include <arrow/api.h>
 #include <illex/client_buffering.h>
 
+#include <algorithm>
 #include <cassert>
 #include <future>
 #include <memory>
 #include <thread>
 
+#include "bolson/convert/coalescer.h"
 #include "bolson/convert/resizer.h"
 #include "bolson/convert/serializer.h"
 #include "bolson/latency.h"
@@ -31,35 +33,150 @@ namespace bolson::convert {
 
 auto Converter::metrics() const -> std::vector<Metrics> { return metrics_; }
 
+/// An input buffer split into chunks that are parsed by multiple converter threads.
+struct SplitJob {
+  /// Views onto the chunks of the input buffer.
+  std::vector<illex::JSONBuffer> chunks;
+  /// The parsed chunks.
+  std::vector<parse::ParsedBatch> parsed;
+  /// The status of parsing each chunk.
+  std::vector<Status> statuses;
+  /// Number of chunks that are not parsed yet.
+  std::atomic<size_t> remaining = 0;
+  /// Notified whenever a chunk is parsed. Outlives the job.
+  WakeSignal* done = nullptr;
+};
+
+/// \brief Parse one chunk from the chunk queue, if any. Return true if one was parsed.
+static auto HelpParse(parse::Parser* parser, ChunkQueue* chunks) -> bool {
+  ChunkTask task;
+  if (!chunks->try_dequeue(task)) {
+    return false;
+  }
+  auto* job = task.job;
+  std::vector<parse::ParsedBatch> parsed;
+  job->statuses[task.index] = parser->Parse({&job->chunks[task.index]}, &parsed);
+  if (job->statuses[task.index].ok()) {
+    job->parsed[task.index] = parsed[0];
+  }
+  // The owner may destroy the job as soon as the last chunk is parsed.
+  auto* done = job->done;
+  job->remaining.fetch_sub(1, std::memory_order_acq_rel);
+  done->Notify();
+  return true;
+}
+
 /**
- * \brief Attempt to get a lock on a buffer.
- * \param buffers   The buffers.
- * \param mutexes   The mutexes.
- * \param out       A pointer to the locked buffer.
- * \param lock_idx  The lock index. Is updated in case of lock. Lock attempts start here.
- * \return True if a lock was obtained, false otherwise.
+ * \brief Parse a buffer by splitting it into chunks that idle threads can help parse.
+ *
+ * Idle threads are woken up by pushing help signals onto the ready queue. The calling
+ * thread parses chunks as well, and stitches the parsed chunks into a single batch once
+ * all of them are parsed.
  */
-static auto TryGetFilledBuffer(const std::vector<illex::JSONBuffer*>& buffers,
-                               const std::vector<std::mutex*>& mutexes,
-                               illex::JSONBuffer** out, size_t* lock_idx) -> bool {
-  auto b = *lock_idx;
-  const size_t num_buffers = buffers.size();
-  for (size_t i = 0; i <= num_buffers; i++) {
-    b = (b + i) % num_buffers;  // increase buffer to try by i, but wrap around
-    if (mutexes[b]->try_lock()) {
-      if (!buffers[b]->empty()) {
-        *lock_idx = b;
-        *out = buffers[b];
-        return true;
-      } else {
-        mutexes[b]->unlock();
+static auto ParseSplit(parse::Parser* parser, illex::JSONBuffer* buf, size_t num_chunks,
+                       ChunkQueue* chunks, WakeSignal* chunks_done,
+                       parse::ReadyQueue* ready, const WaitOptions& wait,
+                       parse::ParsedBatch* out) -> Status {
+  SplitJob job;
+  job.done = chunks_done;
+  BOLSON_ROE(
+      parse::SplitBuffer(buf, num_chunks, BOLSON_SPLIT_MIN_CHUNK_SIZE, &job.chunks));
+  const size_t n = job.chunks.size();
+  if (n == 1) {
+    std::vector<parse::ParsedBatch> parsed;
+    BOLSON_ROE(parser->Parse({buf}, &parsed));
+    *out = parsed[0];
+    return Status::OK();
+  }
+
+  job.parsed.resize(n);
+  job.statuses = std::vector<Status>(n, Status::OK());
+  job.remaining.store(n);
+  for (size_t i = 0; i < n; i++) {
+    chunks->enqueue({&job, i});
+  }
+  for (size_t i = 1; i < n; i++) {
+    ready->enqueue(BOLSON_CONVERTER_HELP);
+  }
+
+  // Help parsing until all chunks of this job are parsed. This may parse chunks of other
+  // jobs as well.
+  Waiter waiter(wait, chunks_done);
+  while (job.remaining.load(std::memory_order_acquire) > 0) {
+    if (HelpParse(parser, chunks)) {
+      waiter.Reset();
+    } else {
+      waiter.Wait();
+    }
+  }
+
+  BOLSON_ROE(Aggregate(job.statuses, "Chunk "));
+  return parse::StitchBatches(job.parsed, out);
+}
+
+/**
+ * \brief Resize, serialize and enqueue batches, adding to the metrics.
+ * \param batches The batches, with their latency time points up to parsing.
+ */
+static auto EmitBatches(const std::vector<CoalescedBatch>& batches, Resizer* resizer,
+                        Serializer* serializer, publish::IpcQueue* out,
+                        std::atomic<bool>* shutdown, Metrics* metrics) -> Status {
+  putong::SplitTimer<3> t_stages;
+  for (const auto& batch : batches) {
+    t_stages.Start();
+    TimePoints lat = batch.time_points;
+
+    // Resize the batch.
+    ResizedBatches resized;
+    BOLSON_ROE(resizer->Resize(batch.parsed, &resized));
+    // Mark time points resized for all batches.
+    lat[TimePoints::resized] = illex::Timer::now();
+
+    t_stages.Split();
+
+    // Serialize the batch.
+    SerializedBatches serialized;
+    const size_t num_allocations = serializer->num_allocations();
+    BOLSON_ROE(serializer->Serialize(resized, &serialized));
+    metrics->num_ipc += serialized.size();
+    metrics->num_ipc_allocations += serializer->num_allocations() - num_allocations;
+    metrics->ipc_bytes += ByteSizeOf(serialized);
+    // Mark time points serialized for all batches.
+    lat[TimePoints::serialized] = illex::Timer::now();
+    // Copy the latency statistics to all serialized batches.
+    for (auto& s : serialized) {
+      s.time_points = lat;
+    }
+
+    t_stages.Split();
+
+    // Blocks while the IPC queue is full, so no further input buffers are drained.
+    for (const auto& sb : serialized) {
+      SPDLOG_DEBUG("Enqueued IPC message with records {}...{}", sb.seq_range.first,
+                   sb.seq_range.last);
+      if (!out->enqueue(sb, shutdown)) {
+        break;
       }
     }
+
+    t_stages.Split();
+
+    metrics->t.resize += t_stages.seconds()[0];
+    metrics->t.serialize += t_stages.seconds()[1];
+    metrics->t.enqueue += t_stages.seconds()[2];
+  }
+  return Status::OK();
+}
+
+/// \brief Name the calling converter thread, and pin it to its CPUs or NUMA node.
+static auto PlaceConverterThread(size_t index, const NumaNode* node,
+                                 const AffinityOptions& affinity) -> Status {
+  // An explicit CPU list takes precedence over NUMA node placement.
+  BOLSON_ROE(PlaceCurrentThread(ThreadRole::CONVERTER, index, affinity));
+  if ((node != nullptr) && affinity.cpus(ThreadRole::CONVERTER).empty()) {
+    BOLSON_ROE(PinThread(node->cpus));
   }
-  *out = nullptr;
-  // Try next buffer next time.
-  *lock_idx = (*lock_idx + 1) % num_buffers;
-  return false;
+  return Status::OK();
 }
 
 static void OneToOneConvertThread(size_t id, parse::Parser* parser,
@@ -67,7 +184,12 @@ static void OneToOneConvertThread(size_t id, parse::Parser* parser,
                                   const std::shared_ptr<Serializer>& serializer,
                                   const std::vector<illex::JSONBuffer*>& buffers,
                                   const std::vector<std::mutex*>& mutexes,
-                                  publish::IpcQueue* out, std::atomic<bool>* shutdown,
+                                  WakeSignal* freed, parse::ReadyQueue* ready,
+                                  ChunkQueue* chunks, WakeSignal* chunks_done,
+                                  size_t split_chunks, Coalescer* coalescer,
+                                  publish::IpcQueue* out, const WaitOptions& wait,
+                                  const NumaNode* node, const AffinityOptions& affinity,
+                                  std::atomic<bool>* shutdown,
                                   std::promise<Metrics>&& metrics_promise) {
   assert(mutexes.size() == buffers.size());
   /// Macro to shut this thread and others down when something failed.
@@ -82,96 +204,112 @@ static void OneToOneConvertThread(size_t id, parse::Parser* parser,
   }
   Metrics metrics;
   metrics.num_threads = 1;
+  metrics.wait_strategy = wait.strategy;
+  metrics.numa_node = node == nullptr ? -1 : static_cast<int>(node->id);
 
   // Thread timer.
   putong::Timer<> t_thread(true);
-  // Workload stage timer.
-  putong::SplitTimer<4> t_stages;
+  // Pin this thread before it allocates anything, such that its memory is first-touched
+  // on its own NUMA node.
+  metrics.status = PlaceConverterThread(id, node, affinity);
+  SHUTDOWN_ON_FAILURE();
+  // Parse stage timer.
+  putong::SplitTimer<1> t_stages;
   // Latency time points.
   TimePoints lat;
-  // Whether to try and unlock a buffer or to wait a bit.
-  bool try_buffers = true;
-  // Buffer to unlock.
-  size_t lock_idx = 0;
+  // Waits for buffers to be signalled.
+  Waiter waiter(wait);
+  // Index of the buffer to parse.
+  size_t idx = 0;
 
   SPDLOG_DEBUG("Thread {:2} | Spawned.", id);
 
   while (!shutdown->load()) {
-    if (try_buffers) {
-      illex::JSONBuffer* buf = nullptr;
-      if (TryGetFilledBuffer(buffers, mutexes, &buf, &lock_idx)) {
-        t_stages.Start();
-        lat[TimePoints::received] = buf->recv_time();
-
-        // Parse the buffer.
-        std::vector<parse::ParsedBatch> parsed_batches;
-        {
-          metrics.status = parser->Parse({buf}, &parsed_batches);
-          SHUTDOWN_ON_FAILURE();
-
-          // Add metrics before buffer is converted and reset.
-          metrics.num_jsons_converted += parsed_batches[0].batch->num_rows();
-          metrics.num_json_bytes_converted += buf->size();
-          metrics.num_recordbatch_bytes += GetBatchSize(parsed_batches[0].batch);
-          metrics.num_buffers_converted++;
-          // Reset and unlock the buffer.
-          buf->Reset();
-          mutexes[lock_idx]->unlock();
-          lock_idx++;  // start at next buffer next time we try to unlock.
-          lat[TimePoints::parsed] = illex::Timer::now();
-        }
-
-        t_stages.Split();
-
-        // Resize the batch.
-        ResizedBatches resized;
-        {
-          metrics.status = resizer->Resize(parsed_batches[0], &resized);
-          SHUTDOWN_ON_FAILURE();
-          // Mark time points resized for all batches.
-          lat[TimePoints::resized] = illex::Timer::now();
-        }
-
-        t_stages.Split();
-
-        // Serialize the batch.
-        SerializedBatches serialized;
-        {
-          metrics.status = serializer->Serialize(resized, &serialized);
-          SHUTDOWN_ON_FAILURE();
-          metrics.num_ipc += serialized.size();
-          metrics.ipc_bytes += ByteSizeOf(serialized);
-          // Mark time points serialized for all batches.
-          lat[TimePoints::serialized] = illex::Timer::now();
-          // Copy the latency statistics to all serialized batches.
-          for (auto& s : serialized) {
-            s.time_points = lat;
-          }
-        }
+    // Block until the client signals a filled buffer, but wake up regularly to check
+    // whether we should shut down.
+    if (!waiter.Dequeue(ready, &idx,
+                        std::chrono::microseconds(BOLSON_CONVERTER_WAIT_TIMEOUT_US))) {
+      // Emit coalesced batches that lingered too long while no buffers were filled.
+      if (coalescer != nullptr) {
+        std::vector<CoalescedBatch> batches;
+        metrics.status = coalescer->Poll(false, &batches);
+        SHUTDOWN_ON_FAILURE();
+        metrics.status = EmitBatches(batches, resizer.get(), serializer.get(), out,
+                                     shutdown, &metrics);
+        SHUTDOWN_ON_FAILURE();
+      }
+      continue;
+    }
 
-        t_stages.Split();
+    // Help parsing chunks of buffers split by other threads.
+    if (idx == BOLSON_CONVERTER_HELP) {
+      while (HelpParse(parser, chunks)) {
+      }
+      continue;
+    }
 
-        // Enqueue IPC items
-        {
-          for (const auto& sb : serialized) {
-            out->enqueue(sb);
-          }
-        }
+    mutexes[idx]->lock();
+    illex::JSONBuffer* buf = buffers[idx];
+    // The buffer may have been signalled more than once, skip it if already parsed.
+    if (buf->empty()) {
+      mutexes[idx]->unlock();
+      continue;
+    }
 
-        t_stages.Split();
+    t_stages.Start();
+    lat[TimePoints::received] = buf->recv_time();
 
-        // Add parse time to stats.
-        metrics.t.parse += t_stages.seconds()[0];
-        metrics.t.resize += t_stages.seconds()[1];
-        metrics.t.serialize += t_stages.seconds()[2];
-        metrics.t.enqueue += t_stages.seconds()[3];
+    // Parse the buffer.
+    std::vector<parse::ParsedBatch> parsed_batches;
+    {
+      if (split_chunks > 1) {
+        parsed_batches.resize(1);
+        metrics.status = ParseSplit(parser, buf, split_chunks, chunks, chunks_done,
+                                    ready, wait, &parsed_batches[0]);
       } else {
-        try_buffers = false;
+        metrics.status = parser->Parse({buf}, &parsed_batches);
       }
+      SHUTDOWN_ON_FAILURE();
+
+      // Add metrics before buffer is converted and reset.
+      metrics.num_jsons_converted += parsed_batches[0].batch->num_rows();
+      metrics.num_jsons_skipped += parsed_batches[0].skipped.size();
+      metrics.num_json_bytes_converted += buf->size();
+      metrics.num_recordbatch_bytes += GetBatchSize(parsed_batches[0].batch);
+      metrics.num_buffers_converted++;
+      // Reset and unlock the buffer, and wake up a client waiting for it.
+      buf->Reset();
+      mutexes[idx]->unlock();
+      freed->Notify();
+      lat[TimePoints::parsed] = illex::Timer::now();
+    }
+
+    t_stages.Split();
+    metrics.t.parse += t_stages.seconds()[0];
+
+    // Coalesce the batch with small batches of earlier buffers, possibly parsed by other
+    // threads.
+    std::vector<CoalescedBatch> batches;
+    if (coalescer != nullptr) {
+      metrics.status = coalescer->Push(parsed_batches[0], lat, &batches);
+      SHUTDOWN_ON_FAILURE();
     } else {
-      std::this_thread::sleep_for(std::chrono::microseconds(BOLSON_QUEUE_WAIT_US));
-      try_buffers = true;
+      batches.push_back({parsed_batches[0], lat});
     }
+
+    metrics.status = EmitBatches(batches, resizer.get(), serializer.get(), out, shutdown,
+                                 &metrics);
+    SHUTDOWN_ON_FAILURE();
+  }
+
+  // Emit the batches still waiting to be coalesced, unless another thread already did.
+  if (coalescer != nullptr) {
+    std::vector<CoalescedBatch> batches;
+    metrics.status = coalescer->Poll(true, &batches);
+    SHUTDOWN_ON_FAILURE();
+    metrics.status = EmitBatches(batches, resizer.get(), serializer.get(), out, shutdown,
+                                 &metrics);
+    SHUTDOWN_ON_FAILURE();
   }
 
   t_thread.Stop();
@@ -186,7 +324,12 @@ static void AllToOneConverterThread(size_t id, parse::Parser* parser,
                                     const std::shared_ptr<Serializer>& serializer,
                                     const std::vector<illex::JSONBuffer*>& buffers,
                                     const std::vector<std::mutex*>& mutexes,
-                                    publish::IpcQueue* out, std::atomic<bool>* shutdown,
+                                    WakeSignal* freed, parse::ReadyQueue* ready,
+                                    Coalescer* coalescer,
+                                    publish::IpcQueue* out, const WaitOptions& wait,
+                                    const NumaNode* node,
+                                    const AffinityOptions& affinity,
+                                    std::atomic<bool>* shutdown,
                                     std::promise<Metrics>&& metrics_promise) {
   assert(mutexes.size() == buffers.size());
   /// Macro to shut this thread and others down when something failed.
@@ -203,21 +346,49 @@ static void AllToOneConverterThread(size_t id, parse::Parser* parser,
 
   Metrics metrics;
   metrics.num_threads = 1;
+  metrics.wait_strategy = wait.strategy;
+  metrics.numa_node = node == nullptr ? -1 : static_cast<int>(node->id);
 
   // Thread timer.
   putong::Timer<> t_thread(true);
-  // Workload stage timer.
-  putong::SplitTimer<4> t_stages;
+  // Pin this thread before it allocates anything, such that its memory is first-touched
+  // on its own NUMA node.
+  metrics.status = PlaceConverterThread(id, node, affinity);
+  SHUTDOWN_ON_FAILURE();
+  // Parse stage timer.
+  putong::SplitTimer<1> t_stages;
   // Latency time points.
   TimePoints lat;
+  // Waits for buffers to be signalled.
+  Waiter waiter(wait);
 
   SPDLOG_DEBUG("Thread {:2} | Spawned.", id);
 
   while (!shutdown->load()) {
+    // Block until the client signals a filled buffer, but wake up regularly to check
+    // whether we should shut down.
+    size_t idx = 0;
+    if (!waiter.Dequeue(ready, &idx,
+                        std::chrono::microseconds(BOLSON_CONVERTER_WAIT_TIMEOUT_US))) {
+      // Emit coalesced batches that lingered too long while no buffers were filled.
+      if (coalescer != nullptr) {
+        std::vector<CoalescedBatch> batches;
+        metrics.status = coalescer->Poll(false, &batches);
+        SHUTDOWN_ON_FAILURE();
+        metrics.status = EmitBatches(batches, resizer.get(), serializer.get(), out,
+                                     shutdown, &metrics);
+        SHUTDOWN_ON_FAILURE();
+      }
+      continue;
+    }
+
     // Obtain a lock on all buffers.
     for (auto* m : mutexes) {
       m->lock();
     }
+    // All buffers are parsed at once, so drain any other signals.
+    while (ready->try_dequeue(idx)) {
+    }
 
     // Check if there is anything to do.
     bool skip = true;
@@ -242,6 +413,9 @@ static void AllToOneConverterThread(size_t id, parse::Parser* parser,
 
         // Update metrics
         metrics.num_jsons_converted += parsed_batches[0].batch->num_rows();
+        for (const auto& batch : parsed_batches) {
+          metrics.num_jsons_skipped += batch.skipped.size();
+        }
         metrics.num_buffers_converted += buffers.size();
         metrics.num_recordbatch_bytes += GetBatchSize(parsed_batches[0].batch);
 
@@ -256,59 +430,40 @@ static void AllToOneConverterThread(size_t id, parse::Parser* parser,
           buffers[i]->Reset();
           mutexes[i]->unlock();
         }
+        // Wake up clients waiting for the buffers.
+        freed->Notify();
 
         lat[TimePoints::parsed] = illex::Timer::now();
         t_stages.Split();
       }
 
-      // Resize the batch.
-      ResizedBatches resized;
-      {
-        for (auto pb : parsed_batches) {
-          ResizedBatches rb;
-          metrics.status = resizer->Resize(parsed_batches[0], &rb);
-          resized.insert(resized.end(), rb.begin(), rb.end());
-        }
-        SHUTDOWN_ON_FAILURE();
-        // Mark time points resized for all batches.
-        lat[TimePoints::resized] = illex::Timer::now();
-        t_stages.Split();
-      }
-
-      // Serialize the batch.
-      SerializedBatches serialized;
-      {
-        metrics.status = serializer->Serialize(resized, &serialized);
-        SHUTDOWN_ON_FAILURE();
-        metrics.num_ipc += serialized.size();
-        metrics.ipc_bytes += ByteSizeOf(serialized);
-        // Mark time points serialized for all batches.
-        lat[TimePoints::serialized] = illex::Timer::now();
-        // Copy the latency statistics to all serialized batches.
-        for (auto& s : serialized) {
-          s.time_points = lat;
-        }
-        t_stages.Split();
-      }
+      metrics.t.parse += t_stages.seconds()[0];
 
-      // Enqueue IPC items
-      {
-        for (const auto& sb : serialized) {
-          SPDLOG_DEBUG("Enqueued IPC message with records {}...{}", sb.seq_range.first,
-                       sb.seq_range.last);
-          out->enqueue(sb);
+      // Coalesce the batches with small batches of earlier buffers.
+      std::vector<CoalescedBatch> batches;
+      for (const auto& pb : parsed_batches) {
+        if (coalescer != nullptr) {
+          metrics.status = coalescer->Push(pb, lat, &batches);
+          SHUTDOWN_ON_FAILURE();
+        } else {
+          batches.push_back({pb, lat});
         }
       }
-      t_stages.Split();
 
-      // Add parse time to stats.
-      metrics.t.parse += t_stages.seconds()[0];
-      metrics.t.resize += t_stages.seconds()[1];
-      metrics.t.serialize += t_stages.seconds()[2];
-      metrics.t.enqueue += t_stages.seconds()[3];
+      metrics.status = EmitBatches(batches, resizer.get(), serializer.get(), out,
+                                   shutdown, &metrics);
+      SHUTDOWN_ON_FAILURE();
     }
+  }
 
-    std::this_thread::sleep_for(std::chrono::microseconds(BOLSON_QUEUE_WAIT_US));
+  // Emit the batches still waiting to be coalesced, unless another thread already did.
+  if (coalescer != nullptr) {
+    std::vector<CoalescedBatch> batches;
+    metrics.status = coalescer->Poll(true, &batches);
+    SHUTDOWN_ON_FAILURE();
+    metrics.status = EmitBatches(batches, resizer.get(), serializer.get(), out, shutdown,
+                                 &metrics);
+    SHUTDOWN_ON_FAILURE();
   }
 
   t_thread.Stop();
@@ -321,18 +476,23 @@ static void AllToOneConverterThread(size_t id, parse::Parser* parser,
 auto Converter::Start(std::atomic<bool>* shutdown) -> Status {
   shutdown_ = shutdown;
   auto buffers = parser_context()->mutable_buffers().size();
+  const auto& nodes = parser_context_->numa_nodes();
 
   if ((num_threads_ > 1) || ((num_threads_ == 1) && (buffers == 1))) {
     SPDLOG_DEBUG("Spawning {} one-to-one parser threads.", num_threads_);
     // One to one parsers, spawn as many threads as parser context allows, and give each
-    // thread a parser to work with.
+    // thread a parser to work with. With NUMA placement, threads are distributed over
+    // the nodes, and only parse buffers of their own node.
     for (int t = 0; t < num_threads_; t++) {
+      size_t node = nodes.empty() ? 0 : t % nodes.size();
       std::promise<Metrics> m;
       metrics_futures_.push_back(m.get_future());
       threads_.emplace_back(
           OneToOneConvertThread, t, parser_context_->parsers()[t].get(), resizers_[t],
           serializers_[t], parser_context_->mutable_buffers(), parser_context_->mutexes(),
-          output_queue_, shutdown_, std::move(m));
+          parser_context_->free_signal(), parser_context_->ready_queue(node), &chunks_,
+          &chunks_done_, split_chunks_, coalescer_.get(), output_queue_, wait_,
+          nodes.empty() ? nullptr : &nodes[node], affinity_, shutdown_, std::move(m));
     }
   } else if (num_threads_ == 1) {
     SPDLOG_DEBUG("Spawning one many-to-one parser thread.");
@@ -344,7 +504,10 @@ auto Converter::Start(std::atomic<bool>* shutdown) -> Status {
     threads_.emplace_back(AllToOneConverterThread, 0, parser_context_->parsers()[0].get(),
                           resizers_[0], serializers_[0],
                           parser_context_->mutable_buffers(), parser_context_->mutexes(),
-                          output_queue_, shutdown_, std::move(m));
+                          parser_context_->free_signal(),
+                          parser_context_->ready_queue(), coalescer_.get(),
+                          output_queue_, wait_, nodes.empty() ? nullptr : &nodes[0],
+                          affinity_, shutdown_, std::move(m));
   }
   return Status::OK();
 }
@@ -375,35 +538,61 @@ auto Converter::Make(const ConverterOptions& opts, publish::IpcQueue* ipc_queue,
   std::vector<std::shared_ptr<Resizer>> resizers;
   std::vector<std::shared_ptr<Serializer>> serializers;
 
+  // Converter threads on isolated cores do not sleep while waiting.
+  auto wait = opts.affinity.WaitFor(ThreadRole::CONVERTER, opts.wait);
+
+  // Hardware parsers poll their status registers using the converter wait strategy.
+  parse::ParserOptions parser_opts = opts.parser;
+  parser_opts.opae_battery.wait = wait;
+  parser_opts.opae_trip.wait = wait;
+  parser_opts.fpga_battery.wait = wait;
+  parser_opts.fpga_trip.wait = wait;
+
   // Determine which parser and allocator implementation to use.
-  switch (opts.parser.impl) {
+  switch (parser_opts.impl) {
     case parse::Impl::ARROW:
-      BOLSON_ROE(parse::ArrowParserContext::Make(opts.parser.arrow, opts.num_threads,
+      BOLSON_ROE(parse::ArrowParserContext::Make(parser_opts.arrow, opts.num_threads,
                                                  opts.input_size, &parser_context));
       break;
     case parse::Impl::OPAE_BATTERY:
       BOLSON_ROE(parse::opae::BatteryParserContext::Make(
-          opts.parser.opae_battery, opts.input_size, &parser_context));
+          parser_opts.opae_battery, opts.input_size, &parser_context));
       break;
     case parse::Impl::OPAE_TRIP:
-      BOLSON_ROE(parse::opae::TripParserContext::Make(opts.parser.opae_trip,
+      BOLSON_ROE(parse::opae::TripParserContext::Make(parser_opts.opae_trip,
                                                       opts.input_size, &parser_context));
       break;
     case parse::Impl::CUSTOM_BATTERY:
       BOLSON_ROE(parse::custom::BatteryParserContext::Make(
-          opts.parser.custom_battery, opts.num_threads, opts.input_size,
+          parser_opts.custom_battery, opts.num_threads, opts.input_size,
           &parser_context));
       break;
     case parse::Impl::CUSTOM_TRIP:
       BOLSON_ROE(parse::custom::TripParserContext::Make(
-          opts.parser.custom_trip, opts.num_threads, opts.input_size, &parser_context));
+          parser_opts.custom_trip, opts.num_threads, opts.input_size, &parser_context));
       break;
+    case parse::Impl::CUSTOM_GENERIC:
+      // The generic parser reads the same schema as the Arrow parser.
+      parser_opts.custom_generic.schema = parser_opts.arrow.schema;
+      parser_opts.custom_generic.schema_path = parser_opts.arrow.schema_path;
+      BOLSON_ROE(parse::custom::GenericParserContext::Make(
+          parser_opts.custom_generic, opts.num_threads, opts.input_size,
+          &parser_context));
+      break;
+#define BOLSON_GENERATED_IMPL(name, NAME)                                          \
+  case parse::Impl::GENERATED_##NAME:                                              \
+    BOLSON_ROE(parse::generated::name::GeneratedParserContext::Make(               \
+        parser_opts.custom_generic, opts.num_threads, opts.input_size,             \
+        &parser_context));                                                         \
+    break;
+      BOLSON_GENERATED_PARSERS(BOLSON_GENERATED_IMPL)
+#undef BOLSON_GENERATED_IMPL
     case parse::Impl::FPGA_BATTERY:
       BOLSON_ROE(parse::fpga::BatteryParserContext::Make(
-          opts.parser.fpga_battery, opts.input_size, &parser_context));
+          parser_opts.fpga_battery, opts.input_size, &parser_context));
       break;
     case parse::Impl::FPGA_TRIP:
-      BOLSON_ROE(parse::fpga::TripParserContext::Make(opts.parser.fpga_trip,
+      BOLSON_ROE(parse::fpga::TripParserContext::Make(parser_opts.fpga_trip,
                                                       opts.input_size, &parser_context));
       break;
   }
@@ -417,23 +606,83 @@ auto Converter::Make(const ConverterOptions& opts, publish::IpcQueue* ipc_queue,
                  opts.num_threads, num_threads);
   }
 
+  // Dictionary-encode columns of tagged fields, or with few distinct values.
+  std::shared_ptr<DictionaryEncoder> dictionaries;
+  BOLSON_ROE(DictionaryEncoder::Make(*parser_context->output_schema(), opts.dictionary,
+                                     &dictionaries));
+
+  // Coalesce small batches of all threads, up to the limits of the resizers.
+  std::shared_ptr<Coalescer> coalescer;
+  if (opts.coalesce.linger_us > 0) {
+    coalescer = std::make_shared<Coalescer>(opts.coalesce, opts.max_batch_rows,
+                                            opts.max_ipc_size);
+  }
+
+  // Serializers write messages into buffers that are reused once they are published.
+  auto buffers = std::make_shared<BufferPool>(opts.ipc_pool_size);
+
   // Set up Resizers and Serializers.
   for (size_t t = 0; t < num_threads; t++) {
     if (!opts.mock_resize) {
-      resizers.push_back(std::make_shared<Resizer>(opts.max_batch_rows));
+      resizers.push_back(
+          std::make_shared<Resizer>(opts.max_batch_rows, opts.max_ipc_size));
     } else {
       resizers.push_back(std::make_shared<ResizerMock>());
     }
     if (!opts.mock_serialize) {
-      serializers.push_back(std::make_shared<Serializer>(opts.max_ipc_size));
+      serializers.push_back(
+          std::make_shared<Serializer>(opts.max_ipc_size, dictionaries, buffers));
     } else {
       serializers.push_back(std::make_shared<SerializerMock>());
     }
   }
 
+  // Place the input buffers on NUMA nodes. Every node needs at least one converter
+  // thread to parse its buffers.
+  if (opts.numa) {
+    if (!parser_context->SupportsNuma()) {
+      spdlog::warn("Parser implementation does not support NUMA buffer placement.");
+    } else {
+      std::vector<NumaNode> nodes;
+      BOLSON_ROE(NumaNodes(&nodes));
+      size_t max_nodes = std::min(num_threads, parser_context->mutable_buffers().size());
+      if (nodes.size() > max_nodes) {
+        spdlog::warn("Using only {} of {} NUMA nodes, limited by threads and buffers.",
+                     max_nodes, nodes.size());
+        nodes.resize(max_nodes);
+      }
+      BOLSON_ROE(parser_context->EnableNuma(nodes));
+    }
+  }
+
+  // Determine whether input buffers can be split.
+  size_t split_chunks = std::max<size_t>(opts.split_chunks, 1);
+  if ((split_chunks > 1) && !parser_context->SupportsSplitting()) {
+    spdlog::warn("Parser implementation cannot parse chunks of input buffers, disabling "
+                 "buffer splitting.");
+    split_chunks = 1;
+  }
+
+  // Send malformed JSONs to a dead-letter sink shared by all parsers.
+  const auto& dead_letter = parser_opts.dead_letter;
+  std::shared_ptr<parse::DeadLetterSink> sink;
+  if (dead_letter.tolerant || !dead_letter.file.empty()) {
+    if (!parser_context->SupportsDeadLetters()) {
+      spdlog::warn("Parser implementation cannot skip malformed JSONs, disabling "
+                   "tolerant parsing.");
+    } else {
+      BOLSON_ROE(parse::DeadLetterSink::Make(dead_letter, &sink));
+      for (const auto& parser : parser_context->parsers()) {
+        parser->set_dead_letters(sink);
+      }
+    }
+  }
+
   // Create the converter.
-  auto result = std::shared_ptr<convert::Converter>(new convert::Converter(
-      parser_context, resizers, serializers, ipc_queue, num_threads));
+  auto result = std::shared_ptr<convert::Converter>(
+      new convert::Converter(parser_context, resizers, serializers, coalescer, ipc_queue,
+                             wait, opts.affinity, num_threads, split_chunks));
+  result->dead_letters_ = std::move(sink);
 
   *out = std::move(result);
 
@@ -447,12 +696,18 @@ auto Converter::parser_context() const -> std::shared_ptr<parse::ParserContext>
 Converter::Converter(std::shared_ptr<parse::ParserContext> parser_context,
                      std::vector<std::shared_ptr<convert::Resizer>> resizers,
                      std::vector<std::shared_ptr<convert::Serializer>> serializers,
-                     publish::IpcQueue* output_queue, size_t num_threads)
+                     std::shared_ptr<convert::Coalescer> coalescer,
+                     publish::IpcQueue* output_queue, const WaitOptions& wait,
+                     AffinityOptions affinity, size_t num_threads, size_t split_chunks)
     : parser_context_(std::move(parser_context)),
       resizers_(std::move(resizers)),
       serializers_(std::move(serializers)),
+      coalescer_(std::move(coalescer)),
       output_queue_(output_queue),
-      num_threads_(num_threads) {
+      wait_(wait),
+      affinity_(std::move(affinity)),
+      num_threads_(num_threads),
+      split_chunks_(split_chunks) {
   assert(output_queue_ != nullptr);
   assert(num_threads_ != 0);
 }
@@ -470,11 +725,17 @@ auto ConverterOptions::ParseInput() -> Status {
 
 void AddConverterOptionsToCLI(CLI::App* sub, convert::ConverterOptions* opts) {
   sub->add_option("--max-rows", opts->max_batch_rows,
-                  "Maximum number of rows per RecordBatch.")
+                  "Maximum number of rows per RecordBatch. 0 packs RecordBatches up to "
+                  "the maximum IPC message size only.")
       ->default_val(1024);
   sub->add_option("--max-ipc", opts->max_ipc_size,
                   "Maximum size of IPC messages in bytes.")
       ->default_val(BOLSON_DEFAULT_PULSAR_MAX_MSG_SIZE);
+  sub->add_option("--ipc-pool", opts->ipc_pool_size,
+                  "Maximum total size in bytes of idle IPC message buffers kept for "
+                  "reuse after their messages are published. 0 allocates a buffer for "
+                  "every message.")
+      ->default_val(64 * 1024 * 1024);
   sub->add_option("--threads", opts->num_threads,
                   "Number of threads to use for conversion.")
       ->default_val(1);
@@ -482,7 +743,19 @@ void AddConverterOptionsToCLI(CLI::App* sub, convert::ConverterOptions* opts) {
                   "Total capacity of all input buffers in bytes. Also accepts <n>KiB, "
                   "<n>MiB, etc.")
       ->default_val("16Mi");
+  sub->add_flag("--numa", opts->numa,
+                "Partition input buffers over NUMA nodes with node-local first touch, "
+                "and pin every converter thread to the node owning its buffers.")
+      ->default_val(false);
+  sub->add_option("--split", opts->split_chunks,
+                  "Split each input buffer into this many newline-aligned chunks, which "
+                  "idle converter threads help to parse. Only used with more than one "
+                  "thread. 1 disables splitting.")
+      ->default_val(1);
   AddParserOptions(sub, &opts->parser);
+  AddCoalesceOptionsToCLI(sub, &opts->coalesce);
+  AddDictionaryOptionsToCLI(sub, &opts->dictionary);
+  AddWaitOptionsToCLI(sub, &opts->wait);
 }
 
 }  // namespace bolson::convert
@@ -14,11 +14,17 @@
 
 #pragma once
 
+#include <concurrentqueue.h>
+
 #include <atomic>
+#include <limits>
 #include <optional>
 #include <utility>
 
+#include "bolson/affinity.h"
 #include "bolson/buffer/allocator.h"
+#include "bolson/convert/coalescer.h"
+#include "bolson/convert/dictionary.h"
 #include "bolson/convert/metrics.h"
 #include "bolson/convert/resizer.h"
 #include "bolson/convert/serializer.h"
@@ -29,6 +35,18 @@
 #include "bolson/parse/parser.h"
 #include "bolson/publish/publisher.h"
 #include "bolson/status.h"
+#include "bolson/topology.h"
+#include "bolson/wait.h"
+
+/// Timeout in microseconds for converter threads waiting on filled buffers, after which
+/// they check whether they should shut down.
+#define BOLSON_CONVERTER_WAIT_TIMEOUT_US 1000
+
+/// Minimum size in bytes of a chunk of an input buffer when splitting buffers.
+#define BOLSON_SPLIT_MIN_CHUNK_SIZE (64 * 1024)
+
+/// Index pushed onto the ready queue to wake converter threads to help parse chunks.
+#define BOLSON_CONVERTER_HELP (std::numeric_limits<size_t>::max())
 
 /// Contains all constructs to support JSON to Arrow conversion and serialization.
 namespace bolson::convert {
@@ -44,11 +62,20 @@ struct ConverterOptions {
   size_t max_ipc_size = 0;
   /// Maximum number of rows in a RecordBatch.
   size_t max_batch_rows = 0;
+  /// Maximum total size in bytes of idle IPC message buffers kept for reuse.
+  size_t ipc_pool_size = 0;
 
   /// Total capacity of all input buffers.
   std::string input_size_str;
   size_t input_size = 0;
 
+  /// Number of newline-aligned chunks to split each input buffer into, such that idle
+  /// converter threads can help parsing it. One disables splitting.
+  size_t split_chunks = 1;
+
+  /// Place input buffers on NUMA nodes and pin converter threads to their nodes.
+  bool numa = false;
+
   /// Use a no-op resizer.
   bool mock_resize = false;
   /// Use a no-op serializer;
@@ -57,10 +84,35 @@ struct ConverterOptions {
   /// Parser options.
   parse::ParserOptions parser;
 
+  /// Coalescing options.
+  CoalesceOptions coalesce;
+
+  /// Dictionary encoding options.
+  DictionaryOptions dictionary;
+
+  /// Wait strategy for threads polling for work or hardware status.
+  WaitOptions wait;
+
+  /// CPU affinity of converter threads. Set from the stream options.
+  AffinityOptions affinity;
+
   /// Parse string fields to useful values
   auto ParseInput() -> Status;
 };
 
+struct SplitJob;
+
+/// A chunk of a split input buffer that any converter thread may parse.
+struct ChunkTask {
+  /// The job the chunk belongs to.
+  SplitJob* job = nullptr;
+  /// The index of the chunk in the job.
+  size_t index = 0;
+};
+
+/// Queue of chunks of split input buffers waiting to be parsed.
+using ChunkQueue = moodycamel::ConcurrentQueue<ChunkTask>;
+
 /// @brief Add converter options to CLI
 void AddConverterOptionsToCLI(CLI::App* sub, convert::ConverterOptions* opts);
 
@@ -110,19 +162,36 @@ class Converter {
   /// \brief Return converter metrics.
   [[nodiscard]] auto metrics() const -> std::vector<Metrics>;
 
+  /// \brief Return the dead-letter sink of the parsers, or nullptr if not tolerant.
+  [[nodiscard]] auto dead_letters() const -> std::shared_ptr<parse::DeadLetterSink> {
+    return dead_letters_;
+  }
+
  protected:
   /// Converter constructor.
   Converter(std::shared_ptr<parse::ParserContext> parser_context,
             std::vector<std::shared_ptr<convert::Resizer>> resizers,
             std::vector<std::shared_ptr<convert::Serializer>> serializers,
-            publish::IpcQueue* output_queue, size_t num_threads = 1);
+            std::shared_ptr<convert::Coalescer> coalescer,
+            publish::IpcQueue* output_queue, const WaitOptions& wait,
+            AffinityOptions affinity, size_t num_threads = 1, size_t split_chunks = 1);
 
   /// The output queue.
   publish::IpcQueue* output_queue_ = nullptr;
+  /// Wait strategy options for the converter threads.
+  WaitOptions wait_;
+  /// CPU affinity options for the converter threads.
+  AffinityOptions affinity_;
   /// Shutdown signal.
   std::atomic<bool>* shutdown_ = nullptr;
   /// Number of threads.
   size_t num_threads_ = 1;
+  /// Number of chunks to split each input buffer into.
+  size_t split_chunks_ = 1;
+  /// Chunks of split input buffers.
+  ChunkQueue chunks_;
+  /// Notified whenever a chunk of a split input buffer is parsed.
+  WakeSignal chunks_done_;
   /// Converter threads.
   std::vector<std::thread> threads_;
   /// Parser manager implementations.
@@ -131,6 +200,10 @@ class Converter {
   std::vector<std::shared_ptr<convert::Resizer>> resizers_;
   /// Serializer instances.
   std::vector<std::shared_ptr<convert::Serializer>> serializers_;
+  /// Coalescer shared by all threads, or nullptr if batches are not coalesced.
+  std::shared_ptr<convert::Coalescer> coalescer_;
+  /// Dead-letter sink shared by all parsers, or nullptr if not tolerant.
+  std::shared_ptr<parse::DeadLetterSink> dead_letters_;
   /// Metrics of converter thread(s).
   std::vector<Metrics> metrics_;
   /// Metrics futures of running threads.
@@ -0,0 +1,150 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/convert/dictionary.h"
+
+#include <arrow/api.h>
+
+#include <algorithm>
+
+namespace bolson::convert {
+
+void AddDictionaryOptionsToCLI(CLI::App* sub, DictionaryOptions* out) {
+  sub->add_flag("--dict-auto", out->auto_detect,
+                "Dictionary-encode utf8 columns with few distinct values in a sample of "
+                "every batch. Fields tagged with \"bolson_dictionary\" metadata are "
+                "always encoded.")
+      ->default_val(false);
+  sub->add_option("--dict-sample", out->sample_rows,
+                  "Number of rows sampled to detect columns to dictionary-encode.")
+      ->default_val(1024);
+  sub->add_option("--dict-max-ratio", out->max_ratio,
+                  "Maximum ratio of distinct values to sampled rows of columns to "
+                  "dictionary-encode.")
+      ->default_val(0.25);
+}
+
+auto DictionaryEncoder::Make(const arrow::Schema& schema, const DictionaryOptions& opts,
+                             std::shared_ptr<DictionaryEncoder>* out) -> Status {
+  auto result = std::shared_ptr<DictionaryEncoder>(new DictionaryEncoder());
+  result->opts_ = opts;
+  for (const auto& field : schema.fields()) {
+    const bool utf8 = field->type()->id() == arrow::Type::STRING;
+    const auto& meta = field->metadata();
+    if ((meta != nullptr) && (meta->FindKey(kDictionaryMetaKey) != -1)) {
+      if (!utf8) {
+        return Status(Error::GenericError, "Field " + field->name() + " is tagged with " +
+                                               kDictionaryMetaKey + " but is not utf8.");
+      }
+      result->modes_[field->name()] = Mode::ALWAYS;
+    } else if (utf8 && opts.auto_detect) {
+      result->modes_[field->name()] = Mode::AUTO;
+    }
+  }
+  *out = result->modes_.empty() ? nullptr : result;
+  return Status::OK();
+}
+
+/**
+ * \brief Dictionary-encode a utf8 column.
+ * \param strings   The column.
+ * \param sample    The number of rows after which the number of distinct values is
+ *                  checked, at most the length of the column.
+ * \param max_ratio The maximum ratio of distinct values to sampled rows.
+ * \param out       The encoded column, or nullptr if the sample had too many distinct
+ *                  values.
+ * \return Status::OK() if successful, some error otherwise.
+ */
+static auto EncodeColumn(const arrow::StringArray& strings, int64_t sample,
+                         double max_ratio, std::shared_ptr<arrow::Array>* out) -> Status {
+  *out = nullptr;
+  StringTable table;
+  arrow::Int32Builder indices;
+  ARROW_ROE(indices.Reserve(strings.length()));
+  auto too_many = [&]() {
+    return static_cast<double>(table.size()) > max_ratio * static_cast<double>(sample);
+  };
+  for (int64_t i = 0; i < strings.length(); i++) {
+    if ((i == sample) && too_many()) {
+      return Status::OK();
+    }
+    if (strings.IsNull(i)) {
+      indices.UnsafeAppendNull();
+    } else {
+      auto value = strings.GetView(i);
+      indices.UnsafeAppend(table.Insert({value.data(), value.size()}));
+    }
+  }
+  if ((sample == strings.length()) && too_many()) {
+    return Status::OK();
+  }
+
+  int64_t num_bytes = 0;
+  for (const auto& value : table.values()) {
+    num_bytes += static_cast<int64_t>(value.size());
+  }
+  arrow::StringBuilder dictionary;
+  ARROW_ROE(dictionary.Reserve(static_cast<int64_t>(table.size())));
+  ARROW_ROE(dictionary.ReserveData(num_bytes));
+  for (const auto& value : table.values()) {
+    dictionary.UnsafeAppend(value.data(), static_cast<int32_t>(value.size()));
+  }
+
+  std::shared_ptr<arrow::Array> index_array;
+  std::shared_ptr<arrow::Array> dictionary_array;
+  ARROW_ROE(indices.Finish(&index_array));
+  ARROW_ROE(dictionary.Finish(&dictionary_array));
+  auto result = arrow::DictionaryArray::FromArrays(
+      arrow::dictionary(arrow::int32(), arrow::utf8()), index_array, dictionary_array);
+  if (!result.ok()) {
+    return Status(Error::ArrowError, result.status().message());
+  }
+  *out = result.ValueOrDie();
+  return Status::OK();
+}
+
+auto DictionaryEncoder::Encode(const std::shared_ptr<arrow::RecordBatch>& batch,
+                               std::shared_ptr<arrow::RecordBatch>* out) const -> Status {
+  auto columns = batch->columns();
+  auto fields = batch->schema()->fields();
+  bool encoded = false;
+  for (size_t c = 0; c < columns.size(); c++) {
+    // Parsers may add columns, e.g. sequence numbers, so columns are matched by name.
+    auto mode = modes_.find(fields[c]->name());
+    if ((mode == modes_.end()) || (columns[c]->type_id() != arrow::Type::STRING)) {
+      continue;
+    }
+    const int64_t sample =
+        std::min(columns[c]->length(), static_cast<int64_t>(opts_.sample_rows));
+    // Columns that are always encoded pass any check.
+    const double max_ratio = mode->second == Mode::ALWAYS ? 1.0 : opts_.max_ratio;
+    std::shared_ptr<arrow::Array> column;
+    BOLSON_ROE(EncodeColumn(static_cast<const arrow::StringArray&>(*columns[c]), sample,
+                            max_ratio, &column));
+    if (column != nullptr) {
+      columns[c] = column;
+      fields[c] = fields[c]->WithType(column->type());
+      encoded = true;
+    }
+  }
+  if (!encoded) {
+    *out = batch;
+    return Status::OK();
+  }
+  *out = arrow::RecordBatch::Make(arrow::schema(fields, batch->schema()->metadata()),
+                                  batch->num_rows(), columns);
+  return Status::OK();
+}
+
+}  // namespace bolson::convert
@@ -0,0 +1,182 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+
+#include <CLI/CLI.hpp>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "bolson/status.h"
+
+namespace bolson::convert {
+
+/// Field metadata key tagging utf8 fields that are always dictionary-encoded.
+constexpr const char* kDictionaryMetaKey = "bolson_dictionary";
+
+/// Dictionary encoding options.
+struct DictionaryOptions {
+  /// Encode untagged utf8 columns with few distinct values in a sample of each batch.
+  bool auto_detect = false;
+  /// Number of rows sampled to detect whether a column has few distinct values.
+  size_t sample_rows = 1024;
+  /// Maximum ratio of distinct values to sampled rows of auto-detected columns.
+  double max_ratio = 0.25;
+};
+
+/// \brief Add dictionary encoding options to a CLI subcommand.
+void AddDictionaryOptionsToCLI(CLI::App* sub, DictionaryOptions* out);
+
+/// \brief Hash a string, eight bytes at a time.
+inline auto HashString(std::string_view s) -> uint64_t {
+  uint64_t h = 0x9E3779B97F4A7C15ULL ^ s.size();
+  size_t i = 0;
+  for (; i + 8 <= s.size(); i += 8) {
+    uint64_t word;
+    std::memcpy(&word, s.data() + i, sizeof(word));
+    h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 32U;
+  }
+  uint64_t tail = 0;
+  // The data of an empty string may be a null pointer, which memcpy must not be given.
+  if (i < s.size()) {
+    std::memcpy(&tail, s.data() + i, s.size() - i);
+  }
+  h = (h ^ tail) * 0xC4CEB9FE1A85EC53ULL;
+  return h ^ (h >> 29U);
+}
+
+/**
+ * \brief An open-addressing hash table assigning indices to distinct strings.
+ *
+ * Strings are not copied, so they must outlive the table. Slots are probed linearly and
+ * store the full hash, so most mismatches are rejected without comparing strings.
+ */
+class StringTable {
+ public:
+  /// \brief Construct a table, sized for an expected number of distinct strings.
+  explicit StringTable(size_t expected = 64) {
+    size_t num_slots = 16;
+    while (num_slots < 2 * expected) {
+      num_slots *= 2;
+    }
+    slots_.resize(num_slots);
+    mask_ = num_slots - 1;
+  }
+
+  /// \brief Return the index of a string, inserting it if it is new.
+  inline auto Insert(std::string_view value) -> int32_t {
+    const uint64_t hash = HashString(value);
+    for (size_t s = hash & mask_;; s = (s + 1) & mask_) {
+      Slot& slot = slots_[s];
+      if (slot.index == kEmpty) {
+        slot = {hash, static_cast<int32_t>(values_.size())};
+        values_.push_back(value);
+        // Keep the load at most one half.
+        if (2 * values_.size() > slots_.size()) {
+          Grow();
+        }
+        return static_cast<int32_t>(values_.size() - 1);
+      }
+      if ((slot.hash == hash) && (values_[slot.index] == value)) {
+        return slot.index;
+      }
+    }
+  }
+
+  /// \brief Return the distinct strings, in order of insertion.
+  [[nodiscard]] auto values() const -> const std::vector<std::string_view>& {
+    return values_;
+  }
+
+  /// \brief Return the number of distinct strings.
+  [[nodiscard]] auto size() const -> size_t { return values_.size(); }
+
+ private:
+  static constexpr int32_t kEmpty = -1;
+
+  struct Slot {
+    uint64_t hash = 0;
+    int32_t index = kEmpty;
+  };
+
+  void Grow() {
+    std::vector<Slot> slots(2 * slots_.size());
+    mask_ = slots.size() - 1;
+    for (const auto& slot : slots_) {
+      if (slot.index != kEmpty) {
+        size_t s = slot.hash & mask_;
+        while (slots[s].index != kEmpty) {
+          s = (s + 1) & mask_;
+        }
+        slots[s] = slot;
+      }
+    }
+    slots_ = std::move(slots);
+  }
+
+  std::vector<Slot> slots_;
+  std::vector<std::string_view> values_;
+  size_t mask_ = 0;
+};
+
+/**
+ * \brief Dictionary-encodes the utf8 columns of RecordBatches.
+ *
+ * Every batch gets its own dictionaries, such that every IPC message can be decoded on
+ * its own. Columns of fields tagged with kDictionaryMetaKey are always encoded. With
+ * auto-detection, other utf8 columns are encoded if a sample of the batch has few
+ * distinct values.
+ */
+class DictionaryEncoder {
+ public:
+  /**
+   * \brief Make a dictionary encoder for batches of a schema.
+   * \param schema The schema of the batches.
+   * \param opts   Dictionary encoding options.
+   * \param out    The encoder, or nullptr if no column would ever be encoded.
+   * \return Status::OK() if successful, an error if a tagged field is not utf8.
+   */
+  static auto Make(const arrow::Schema& schema, const DictionaryOptions& opts,
+                   std::shared_ptr<DictionaryEncoder>* out) -> Status;
+
+  /**
+   * \brief Dictionary-encode the columns of a batch.
+   * \param batch The batch.
+   * \param out   The batch with dictionary-encoded columns, or the batch itself if no
+   *              column was encoded.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  auto Encode(const std::shared_ptr<arrow::RecordBatch>& batch,
+              std::shared_ptr<arrow::RecordBatch>* out) const -> Status;
+
+ private:
+  DictionaryEncoder() = default;
+
+  /// How to treat a column.
+  enum class Mode { AUTO, ALWAYS };
+
+  /// Mode of the fields of the schema that may be encoded, by name.
+  std::unordered_map<std::string, Mode> modes_;
+  DictionaryOptions opts_;
+};
+
+}  // namespace bolson::convert
@@ -15,24 +15,30 @@
 #include "bolson/convert/metrics.h"
 
 #include <fstream>
+#include <map>
 
 #include "bolson/log.h"
+#include "bolson/utils.h"
 
 namespace bolson::convert {
 
 auto Metrics::operator+=(const bolson::convert::Metrics& r) -> Metrics& {
+  numa_node = ((num_threads == 0) || (numa_node == r.numa_node)) ? r.numa_node : -1;
   num_threads += r.num_threads;
   num_jsons_converted += r.num_jsons_converted;
+  num_jsons_skipped += r.num_jsons_skipped;
   num_json_bytes_converted += r.num_json_bytes_converted;
   num_recordbatch_bytes += r.num_recordbatch_bytes;
   num_ipc += r.num_ipc;
   ipc_bytes += r.ipc_bytes;
+  num_ipc_allocations += r.num_ipc_allocations;
   num_buffers_converted += r.num_buffers_converted;
   t.parse += r.t.parse;
   t.resize += r.t.resize;
   t.serialize += r.t.serialize;
   t.thread += r.t.thread;
   t.enqueue += r.t.enqueue;
+  wait_strategy = r.wait_strategy;
   if (!r.status.ok()) {
     status = r.status;
   }
@@ -42,10 +48,12 @@ auto Metrics::operator+=(const bolson::convert::Metrics& r) -> Metrics& {
 std::string Metrics::ToCSV() const {
   std::stringstream ss;
 
-  ss << num_threads << ',' << num_jsons_converted << "," << num_json_bytes_converted
-     << "," << num_recordbatch_bytes << "," << num_ipc << "," << ipc_bytes << ","
-     << num_buffers_converted << "," << t.parse << "," << t.resize << "," << t.serialize
-     << "," << t.thread << "," << t.enqueue << "," << status.ok();
+  ss << num_threads << ',' << num_jsons_converted << "," << num_jsons_skipped << ","
+     << num_json_bytes_converted << "," << num_recordbatch_bytes << "," << num_ipc << ","
+     << ipc_bytes << "," << num_buffers_converted << "," << t.parse << "," << t.resize
+     << "," << t.serialize << "," << t.thread << "," << t.enqueue << ","
+     << ToString(wait_strategy) << "," << numa_node << "," << status.ok() << ","
+     << num_ipc_allocations;
   return ss.str();
 }
 
@@ -54,7 +62,9 @@ void LogConvertMetrics(const Metrics& metrics, const std::string& t) {
   auto json_MiB = static_cast<double>(metrics.num_json_bytes_converted) / (1024. * 1024.);
 
   spdlog::info("{}JSON to Arrow conversion:", t);
+  spdlog::info("{}  Wait strategy         : {}", t, ToString(metrics.wait_strategy));
   spdlog::info("{}  Converted             : {} JSON", t, metrics.num_jsons_converted);
+  spdlog::info("{}  Skipped               : {} JSON", t, metrics.num_jsons_skipped);
   spdlog::info("{}  Raw JSON bytes        : {} B, {:.3f} MiB", t,
                metrics.num_json_bytes_converted, json_MiB);
 
@@ -91,6 +101,10 @@ void LogConvertMetrics(const Metrics& metrics, const std::string& t) {
   auto ipc_bpi = (metrics.num_ipc == 0) ? 0
                                         : (static_cast<double>(metrics.ipc_bytes) /
                                            static_cast<double>(metrics.num_ipc));
+  auto ipc_apm = (metrics.num_ipc == 0)
+                     ? 0
+                     : (static_cast<double>(metrics.num_ipc_allocations) /
+                        static_cast<double>(metrics.num_ipc));
   auto ipc_MB = static_cast<double>(metrics.ipc_bytes) / 1e6;
   auto ser_tt = metrics.t.serialize / static_cast<double>(metrics.num_threads);
 
@@ -99,6 +113,8 @@ void LogConvertMetrics(const Metrics& metrics, const std::string& t) {
   spdlog::info("{}  IPC bytes             : {}", t, metrics.ipc_bytes);
   spdlog::info("{}  Avg. IPC bytes/json   : {:.1f} B/JSON", t, ipc_bpj);
   spdlog::info("{}  Avg. IPC bytes/msg    : {:.1f} B/IPC", t, ipc_bpi);
+  spdlog::info("{}  Buffer allocations    : {}", t, metrics.num_ipc_allocations);
+  spdlog::info("{}  Avg. allocations/msg  : {:.3f}", t, ipc_apm);
   spdlog::info("{}  Time in {:2} threads    : {} s", t, metrics.num_threads,
                metrics.t.serialize);
   spdlog::info("{}  Avg. time             : {} s", t, ser_tt);
@@ -114,6 +130,29 @@ void LogConvertMetrics(const Metrics& metrics, const std::string& t) {
   spdlog::info("{}  Avg. throughput       : {:.3f} MJSON/s", t, json_M / enq_tt);
 }
 
+void LogNumaMetrics(const std::vector<Metrics>& metrics, const std::string& t) {
+  std::map<int, std::vector<Metrics>> per_node;
+  for (const auto& m : metrics) {
+    if (m.numa_node >= 0) {
+      per_node[m.numa_node].push_back(m);
+    }
+  }
+  if (per_node.empty()) {
+    return;
+  }
+  spdlog::info("{}Per NUMA node:", t);
+  for (const auto& [node, node_metrics] : per_node) {
+    auto m = Aggregate(node_metrics);
+    auto json_MB = static_cast<double>(m.num_json_bytes_converted) / 1e6;
+    auto parse_tt = m.t.parse / static_cast<double>(m.num_threads);
+    spdlog::info("{}  Node {}:", t, node);
+    spdlog::info("{}    Threads             : {}", t, m.num_threads);
+    spdlog::info("{}    Converted           : {} JSON", t, m.num_jsons_converted);
+    spdlog::info("{}    Raw JSON bytes      : {} B", t, m.num_json_bytes_converted);
+    spdlog::info("{}    Avg. parse tput (in): {:.3f} MB/s", t, json_MB / parse_tt);
+  }
+}
+
 Status SaveConvertMetrics(const std::vector<Metrics>& metrics, const std::string& file) {
   // Open output stream to write file.
   std::ofstream ofs(file);
@@ -122,9 +161,10 @@ Status SaveConvertMetrics(const std::vector<Metrics>& metrics, const std::string
   }
 
   // Header:
-  ofs << "num_threads,num_jsons_converted,num_json_bytes_converted,num_recordbatch_bytes,"
-         "num_ipc,ipc_bytes,num_buffers_converted,t_parse,t_resize,t_serialize,t_thread,"
-         "t_enqueue,status\n";
+  ofs << "num_threads,num_jsons_converted,num_jsons_skipped,num_json_bytes_converted,"
+         "num_recordbatch_bytes,num_ipc,ipc_bytes,num_buffers_converted,t_parse,t_resize,"
+         "t_serialize,t_thread,t_enqueue,wait_strategy,numa_node,status,"
+         "num_ipc_allocations\n";
 
   for (const auto& m : metrics) {
     ofs << m.ToCSV() << '\n';
@@ -15,6 +15,7 @@
 #include <putong/timer.h>
 
 #include "bolson/status.h"
+#include "bolson/wait.h"
 
 #pragma once
 
@@ -28,6 +29,8 @@ struct Metrics {
   size_t num_threads = 0;
   /// Number of converted JSONs.
   size_t num_jsons_converted = 0;
+  /// Number of malformed JSONs skipped in tolerant mode.
+  size_t num_jsons_skipped = 0;
   /// Number of converted JSON bytes.
   size_t num_json_bytes_converted = 0;
   /// Number of buffers converted.
@@ -38,6 +41,12 @@ struct Metrics {
   size_t num_ipc = 0;
   /// Number of bytes in the IPC messages.
   size_t ipc_bytes = 0;
+  /// Number of IPC message buffers allocated rather than reused.
+  size_t num_ipc_allocations = 0;
+  /// Wait strategy used by the thread(s).
+  WaitStrategy wait_strategy = WaitStrategy::SLEEP;
+  /// NUMA node the thread(s) were pinned to, -1 if not pinned or mixed.
+  int numa_node = -1;
   /// Total time of specific operations in the pipeline.
   struct {
     /// Total time spent on parsing JSONs to Arrow RecordBatch.
@@ -69,6 +78,13 @@ struct Metrics {
  */
 void LogConvertMetrics(const Metrics& metrics, const std::string& t = "");
 
+/**
+ * \brief Print throughput per NUMA node, if threads were pinned to NUMA nodes.
+ * \param metrics The metrics of every converter thread.
+ * \param t Prefix for indenting.
+ */
+void LogNumaMetrics(const std::vector<Metrics>& metrics, const std::string& t = "");
+
 /**
  * \brief Save convert metrics to a file.
  */
@@ -14,35 +14,165 @@
 
 #include "bolson/convert/resizer.h"
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
 namespace bolson::convert {
 
-// TODO: this could also be done based on arrow::ipc::GetRecordBatchSize
+/// \brief Add the estimated size in bits of every row of an array to rows.
+static void AddRowBits(const arrow::Array& array, uint64_t* rows) {
+  const int64_t length = array.length();
+  // Bits every row takes regardless of its contents.
+  uint64_t fixed = array.null_bitmap_data() != nullptr ? 1 : 0;
+  switch (array.type_id()) {
+    case arrow::Type::STRING:
+    case arrow::Type::BINARY: {
+      const auto& strings = static_cast<const arrow::BinaryArray&>(array);
+      fixed += 32;
+      for (int64_t i = 0; i < length; i++) {
+        rows[i] += 8 * static_cast<uint64_t>(strings.value_length(i));
+      }
+      break;
+    }
+    case arrow::Type::LIST: {
+      const auto& list = static_cast<const arrow::ListArray&>(array);
+      fixed += 32;
+      // Sum the elements of every list through prefix sums of the element sizes.
+      const auto& values = *list.values();
+      std::vector<uint64_t> elements(values.length() + 1, 0);
+      AddRowBits(values, elements.data() + 1);
+      std::partial_sum(elements.begin(), elements.end(), elements.begin());
+      for (int64_t i = 0; i < length; i++) {
+        rows[i] += elements[list.value_offset(i) + list.value_length(i)] -
+                   elements[list.value_offset(i)];
+      }
+      break;
+    }
+    case arrow::Type::FIXED_SIZE_LIST: {
+      const auto& list = static_cast<const arrow::FixedSizeListArray&>(array);
+      const auto& values = *list.values();
+      std::vector<uint64_t> elements(values.length(), 0);
+      AddRowBits(values, elements.data());
+      for (int64_t i = 0; i < length; i++) {
+        for (int32_t j = 0; j < list.value_length(); j++) {
+          rows[i] += elements[list.value_offset(i) + j];
+        }
+      }
+      break;
+    }
+    case arrow::Type::STRUCT: {
+      const auto& fields = static_cast<const arrow::StructArray&>(array);
+      for (int f = 0; f < fields.num_fields(); f++) {
+        AddRowBits(*fields.field(f), rows);
+      }
+      break;
+    }
+    default: {
+      const auto* fixed_width =
+          dynamic_cast<const arrow::FixedWidthType*>(array.type().get());
+      if (fixed_width != nullptr) {
+        fixed += fixed_width->bit_width();
+      } else if (length > 0) {
+        // Spread the buffers of any other layout evenly over the rows.
+        uint64_t bytes = 0;
+        for (const auto& buffer : array.data()->buffers) {
+          bytes += buffer != nullptr ? buffer->size() : 0;
+        }
+        fixed += (8 * bytes + length - 1) / length;
+      }
+      break;
+    }
+  }
+  for (int64_t i = 0; i < length; i++) {
+    rows[i] += fixed;
+  }
+}
+
+void EstimateRowBits(const arrow::RecordBatch& batch, std::vector<uint64_t>* out) {
+  out->assign(batch.num_rows() + 1, 0);
+  for (const auto& column : batch.columns()) {
+    AddRowBits(*column, out->data() + 1);
+  }
+  std::partial_sum(out->begin(), out->end(), out->begin());
+}
+
+/// \brief Return the number of buffers and field nodes of an array and its children.
+static auto CountBuffers(const arrow::ArrayData& data) -> size_t {
+  size_t result = 1 + data.buffers.size();
+  for (const auto& child : data.child_data) {
+    result += CountBuffers(*child);
+  }
+  return result;
+}
+
+/// \brief Return the size of all buffers of an array and its children.
+static auto BufferSize(const arrow::ArrayData& data) -> size_t {
+  size_t result = 0;
+  for (const auto& buffer : data.buffers) {
+    result += buffer != nullptr ? buffer->size() : 0;
+  }
+  for (const auto& child : data.child_data) {
+    result += BufferSize(*child);
+  }
+  return result;
+}
+
+auto EstimateMessageOverhead(const arrow::RecordBatch& batch) -> size_t {
+  // Every buffer and field node takes a metadata entry and up to 8 bytes of padding,
+  // next to a fixed-size message header.
+  size_t num_buffers = 0;
+  for (const auto& column : batch.column_data()) {
+    num_buffers += CountBuffers(*column);
+  }
+  return 512 + 32 * num_buffers;
+}
+
+auto EstimateBufferSize(const arrow::RecordBatch& batch) -> size_t {
+  size_t result = 0;
+  for (const auto& column : batch.column_data()) {
+    result += BufferSize(*column);
+  }
+  return result;
+}
 
 auto Resizer::Resize(const parse::ParsedBatch& in, ResizedBatches* out) const -> Status {
   ResizedBatches result;
-  if (in.batch->num_rows() > max_rows) {
-    size_t offset = 0;
-    size_t remaining = in.batch->num_rows();
-    while (remaining > 0) {
-      auto first = in.seq_range.first + offset;
-      if (remaining > max_rows) {
-        illex::SeqRange new_seq = {first, first + max_rows - 1};
-        result.push_back(parse::ParsedBatch{
-            parse::AddSeqAsSchemaMeta(in.batch->Slice(offset, max_rows), new_seq),
-            new_seq});
-        offset += max_rows;
-        remaining -= max_rows;
-      } else {
-        illex::SeqRange new_seq = {first, first + remaining - 1};
-        result.push_back(parse::ParsedBatch{
-            parse::AddSeqAsSchemaMeta(in.batch->Slice(offset, remaining), new_seq),
-            new_seq});
-        offset += remaining;
-        remaining = 0;
-      }
+  const auto num_rows = static_cast<size_t>(in.batch->num_rows());
+  const size_t row_limit = max_rows == 0 ? num_rows : max_rows;
+
+  // The buffer sizes are an upper bound of the message size. Only estimate the size
+  // of every row if it exceeds the limit.
+  std::vector<uint64_t> row_bits;
+  size_t overhead = 0;
+  if (max_bytes > 0) {
+    overhead = EstimateMessageOverhead(*in.batch);
+    if (overhead + EstimateBufferSize(*in.batch) > max_bytes) {
+      EstimateRowBits(*in.batch, &row_bits);
+    }
+  }
+
+  if ((num_rows == 0) || ((num_rows <= row_limit) && row_bits.empty())) {
+    result.push_back(in);
+    *out = result;
+    return Status::OK();
+  }
+
+  // Every slice ends at the last row that fits, or after one row if it does not fit.
+  const uint64_t budget_bits = 8 * (max_bytes - std::min(max_bytes, overhead));
+  size_t offset = 0;
+  while (offset < num_rows) {
+    size_t end = std::min(num_rows, offset + row_limit);
+    if (!row_bits.empty()) {
+      auto last = std::upper_bound(row_bits.begin() + offset + 1,
+                                   row_bits.begin() + end + 1,
+                                   row_bits[offset] + budget_bits);
+      end = std::max(offset + 1, static_cast<size_t>(last - row_bits.begin()) - 1);
     }
-  } else {
-    result.push_back(parse::ParsedBatch{in.batch, in.seq_range});
+    // Skipped JSONs leave gaps between the sequence numbers of the rows.
+    result.push_back(parse::SliceParsed(in, static_cast<int64_t>(offset),
+                                        static_cast<int64_t>(end - offset)));
+    offset = end;
   }
 
   *out = result;
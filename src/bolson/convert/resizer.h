@@ -27,17 +27,27 @@ namespace bolson::convert {
 using ResizedBatches = std::vector<parse::ParsedBatch>;
 
 /**
- * \brief Resizes RecordBatches to not exceed a specific number of rows.
+ * \brief Resizes RecordBatches to not exceed a number of rows or IPC message size.
  */
 class Resizer {
  public:
   /**
    * \brief Resizer constructor.
-   * \param max_rows The maximum number of rows a RecordBatch may contain.
+   * \param max_rows  The maximum number of rows a RecordBatch may contain, or 0 for no
+   *                  limit.
+   * \param max_bytes The maximum size of the IPC message of a RecordBatch, or 0 for no
+   *                  limit.
    */
-  explicit Resizer(size_t max_rows) : max_rows(max_rows) {}
+  explicit Resizer(size_t max_rows, size_t max_bytes = 0)
+      : max_rows(max_rows), max_bytes(max_bytes) {}
   /**
-   * \brief Resize all RecordBatches in a parsed buffer to not exceed a maximum no. rows.
+   * \brief Resize all RecordBatches in a parsed buffer to not exceed the limits.
+   *
+   * The IPC message size of every row is estimated from the widths of fixed-width
+   * columns and the offsets of variable-length columns, such that slices are packed up
+   * to the maximum size. Slices hold at least one row, even if it exceeds the maximum
+   * size.
+   *
    * \param in  The parsed buffer containing resulting Arrow RecordBatches.
    * \param out The resized RecordBatches.
    * \return Status::OK() if successful, some error otherwise.
@@ -46,8 +56,28 @@ class Resizer {
 
  protected:
   size_t max_rows;
+  size_t max_bytes;
 };
 
+/**
+ * \brief Estimate the size of the IPC message of every row of a RecordBatch.
+ * \param batch The batch.
+ * \param out   Prefix sums of the estimated size in bits of all rows, such that rows
+ *              [a, b) take (*out)[b] - (*out)[a] bits. Excludes any message overhead.
+ */
+void EstimateRowBits(const arrow::RecordBatch& batch, std::vector<uint64_t>* out);
+
+/// \brief Return an upper bound of the overhead of the IPC message of a RecordBatch.
+auto EstimateMessageOverhead(const arrow::RecordBatch& batch) -> size_t;
+
+/**
+ * \brief Return the size of all buffers of a RecordBatch.
+ *
+ * Together with the message overhead, this is an upper bound of the size of its IPC
+ * message, which is cheap to compute.
+ */
+auto EstimateBufferSize(const arrow::RecordBatch& batch) -> size_t;
+
 /// \brief A resizer that doesn't do anything, for benchmarking purposes.
 class ResizerMock : public Resizer {
  public:
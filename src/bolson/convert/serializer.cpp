@@ -14,33 +14,137 @@
 
 #include "bolson/convert/serializer.h"
 
+#include <arrow/io/api.h>
+
+#include <utility>
+#include <vector>
+
 namespace bolson::convert {
 
-auto Serializer::Serialize(const ResizedBatches& in, SerializedBatches* out) const
-    -> Status {
-  SerializedBatches result;
+/// Arrow IPC messages of a batch, with their total size once written.
+struct IpcPayloads {
+  std::vector<arrow::ipc::IpcPayload> payloads;
+  int64_t size = 0;
+  bool stream = false;
+};
 
-  // Set up a pointer for the combined batch.
-  std::shared_ptr<arrow::RecordBatch> combined_batch;
+/// The end-of-stream marker: a continuation token followed by a zero length.
+static constexpr int32_t kEndOfStream[] = {-1, 0};
 
-  // Serialize each batch.
-  for (const auto& batch : in) {
-    auto serialize_result = arrow::ipc::SerializeRecordBatch(*batch.batch, opts);
-    if (!serialize_result.ok()) {
-      return Status(Error::ArrowError,
-                    "Could not serialize batch: " + serialize_result.status().message());
+/**
+ * \brief Build the IPC messages of a batch, as a single RecordBatch message, or as a
+ *        complete IPC stream.
+ *
+ * Streams hold the schema, the dictionary batches and the RecordBatch, followed by the
+ * end-of-stream marker.
+ */
+static auto GetIpcPayloads(const arrow::RecordBatch& batch, bool stream,
+                           const arrow::ipc::IpcWriteOptions& opts, IpcPayloads* out)
+    -> Status {
+  out->payloads.clear();
+  out->stream = stream;
+  if (stream) {
+    arrow::ipc::DictionaryFieldMapper mapper(*batch.schema());
+    auto dicts_result = arrow::ipc::CollectDictionaries(batch, mapper);
+    if (!dicts_result.ok()) {
+      return Status(Error::ArrowError, dicts_result.status().message());
     }
-    auto serialized = serialize_result.ValueOrDie();
-    if (serialized->size() > max_ipc_size) {
+    out->payloads.emplace_back();
+    ARROW_ROE(arrow::ipc::GetSchemaPayload(*batch.schema(), opts, mapper,
+                                           &out->payloads.back()));
+    for (const auto& dict : dicts_result.ValueOrDie()) {
+      out->payloads.emplace_back();
+      ARROW_ROE(arrow::ipc::GetDictionaryPayload(dict.first, dict.second, opts,
+                                                 &out->payloads.back()));
+    }
+  }
+  out->payloads.emplace_back();
+  ARROW_ROE(arrow::ipc::GetRecordBatchPayload(batch, opts, &out->payloads.back()));
+
+  out->size = stream ? sizeof(kEndOfStream) : 0;
+  for (const auto& payload : out->payloads) {
+    int64_t size = 0;
+    ARROW_ROE(arrow::ipc::GetPayloadSize(payload, opts, &size));
+    out->size += size;
+  }
+  return Status::OK();
+}
+
+/// \brief Write the IPC messages of a batch.
+static auto WriteIpcPayloads(const IpcPayloads& in,
+                             const arrow::ipc::IpcWriteOptions& opts,
+                             arrow::io::OutputStream* dst) -> Status {
+  for (const auto& payload : in.payloads) {
+    int32_t metadata_length = 0;
+    ARROW_ROE(arrow::ipc::WriteIpcPayload(payload, opts, dst, &metadata_length));
+  }
+  if (in.stream) {
+    ARROW_ROE(dst->Write(kEndOfStream, sizeof(kEndOfStream)));
+  }
+  return Status::OK();
+}
+
+Serializer::Serializer(size_t max_ipc_size,
+                       std::shared_ptr<DictionaryEncoder> dictionaries,
+                       std::shared_ptr<BufferPool> buffers)
+    : max_ipc_size(max_ipc_size),
+      dictionaries(std::move(dictionaries)),
+      buffers(std::move(buffers)) {
+  if (this->buffers == nullptr) {
+    this->buffers = std::make_shared<BufferPool>(0);
+  }
+}
+
+auto Serializer::SerializeOne(const parse::ParsedBatch& batch,
+                              SerializedBatches* out) const -> Status {
+  std::shared_ptr<arrow::RecordBatch> encoded = batch.batch;
+  if (dictionaries != nullptr) {
+    BOLSON_ROE(dictionaries->Encode(batch.batch, &encoded));
+  }
+  // With an encoder, every message is a stream, also when no column of this batch was
+  // encoded, so consumers can rely on a single format for the whole run.
+  const bool stream = dictionaries != nullptr;
+
+  // Build the messages once; their size tells whether to split the batch and how large
+  // a buffer to write them into.
+  IpcPayloads payloads;
+  BOLSON_ROE(GetIpcPayloads(*encoded, stream, opts, &payloads));
+  const int64_t size = payloads.size;
+
+  if (static_cast<size_t>(size) > max_ipc_size) {
+    // The resizer only estimates message sizes, so split batches it misjudged in half.
+    const int64_t num_rows = batch.batch->num_rows();
+    if (num_rows <= 1) {
       return Status(Error::GenericError,
-                    "Maximum IPC message size exceeded."
-                    "Reduce max number of rows per batch.");
+                    "Maximum IPC message size exceeded by a single record.");
     }
-    result.push_back({serialize_result.ValueOrDie(), batch.seq_range});
+    // Skipped JSONs leave gaps between the sequence numbers of the rows.
+    const int64_t half = num_rows / 2;
+    BOLSON_ROE(SerializeOne(parse::SliceParsed(batch, 0, half), out));
+    BOLSON_ROE(SerializeOne(parse::SliceParsed(batch, half, num_rows - half), out));
+    return Status::OK();
   }
 
-  *out = result;
+  // Write the message into a pooled buffer, which returns to the pool once the message
+  // is published.
+  std::shared_ptr<arrow::Buffer> buffer;
+  bool allocated = false;
+  BOLSON_ROE(buffers->Acquire(size, &buffer, &allocated));
+  num_allocations_ += static_cast<size_t>(allocated);
+  arrow::io::FixedSizeBufferWriter writer(buffer);
+  BOLSON_ROE(WriteIpcPayloads(payloads, opts, &writer));
 
+  out->push_back({arrow::SliceBuffer(buffer, 0, size), batch.seq_range});
+  return Status::OK();
+}
+
+auto Serializer::Serialize(const ResizedBatches& in, SerializedBatches* out) const
+    -> Status {
+  SerializedBatches result;
+  for (const auto& batch : in) {
+    BOLSON_ROE(SerializeOne(batch, &result));
+  }
+  *out = result;
   return Status::OK();
 }
 
@@ -72,4 +176,4 @@ auto SerializerMock::Serialize(const ResizedBatches& in, SerializedBatches* out)
   }
   return Status::OK();
 }
-}  // namespace bolson::convert
\ No newline at end of file
+}  // namespace bolson::convert
@@ -16,6 +16,11 @@
 
 #include <arrow/ipc/api.h>
 
+#include <memory>
+#include <utility>
+
+#include "bolson/convert/buffer_pool.h"
+#include "bolson/convert/dictionary.h"
 #include "bolson/convert/resizer.h"
 #include "bolson/status.h"
 
@@ -51,13 +56,29 @@ class Serializer {
   /**
    * \brief Serializer constructor.
    * \param max_ipc_size Maximum size of Arrow IPC messages.
+   * \param dictionaries Dictionary encoder applied to every batch, if any.
+   * \param buffers      Pool of buffers to write messages into. If nullptr, every message
+   *                     gets a freshly allocated buffer.
    */
-  explicit Serializer(size_t max_ipc_size) : max_ipc_size(max_ipc_size) {}
+  explicit Serializer(size_t max_ipc_size,
+                      std::shared_ptr<DictionaryEncoder> dictionaries = nullptr,
+                      std::shared_ptr<BufferPool> buffers = nullptr);
   /**
    * \brief Serialize RecordBatches.
    *
-   * If the serialized RecordBatch exceeds max_ipc_size in bytes, this function returns
-   * an error.
+   * If a serialized RecordBatch exceeds max_ipc_size in bytes, it is split in half
+   * until all parts fit. This function only returns an error if a single record exceeds
+   * max_ipc_size.
+   *
+   * Without a dictionary encoder, batches are serialized as a single RecordBatch
+   * message. With a dictionary encoder, every batch is serialized as a complete IPC
+   * stream: the schema, a dictionary batch for every encoded column, and the
+   * RecordBatch, such that every message can be decoded on its own. This holds even for
+   * batches of which no column was encoded, so the format is the same for all messages.
+   *
+   * The IPC messages of a batch are built once, measured, and written into a buffer of
+   * the buffer pool, which returns to the pool when the last reference to the message
+   * drops.
    *
    * \param in  The RecordBatches to be resized.
    * \param out The serialized RecordBatches.
@@ -66,12 +87,28 @@ class Serializer {
   virtual auto Serialize(const ResizedBatches& in, SerializedBatches* out) const
       -> Status;
 
+  /// \brief Return the number of message buffers allocated rather than reused.
+  [[nodiscard]] auto num_allocations() const -> size_t { return num_allocations_; }
+
  private:
+  /// \brief Serialize a RecordBatch, splitting it if it exceeds max_ipc_size.
+  auto SerializeOne(const parse::ParsedBatch& batch, SerializedBatches* out) const
+      -> Status;
+
   /// Options for Arrow's IPC writer.
   arrow::ipc::IpcWriteOptions opts = arrow::ipc::IpcWriteOptions::Defaults();
 
   /// Maximum IPC size. Serialize() will return an Error if this is exceeded.
   size_t max_ipc_size;
+
+  /// Dictionary encoder, or nullptr if no columns are dictionary-encoded.
+  std::shared_ptr<DictionaryEncoder> dictionaries;
+
+  /// Pool of message buffers.
+  std::shared_ptr<BufferPool> buffers;
+
+  /// Number of message buffers allocated rather than reused.
+  mutable size_t num_allocations_ = 0;
 };
 
 /// \brief A serializer that doesn't do anything, for benchmarking purposes.
@@ -82,4 +119,4 @@ class SerializerMock : public Serializer {
       -> Status override;
 };
 
-}  // namespace bolson::convert
\ No newline at end of file
+}  // namespace bolson::convert
@@ -36,7 +36,8 @@ auto SaveStreamMetrics(const bolson::convert::Metrics& converter_metrics,
   }
 
   // Write header.
-  ofs << "Producer threads,Converter threads,Parser,Persistent topic,Batched mode,JSONs,";
+  ofs << "Producer threads,Converter threads,Parser,Wait strategy,Persistent topic,"
+         "Batched mode,JSONs,";
   for (size_t i = TimePoints::received; i <= TimePoints::published; i++) {
     ofs << TimePoints::point_name(i);
     if (i != TimePoints::published) ofs << ',';
@@ -48,6 +49,7 @@ auto SaveStreamMetrics(const bolson::convert::Metrics& converter_metrics,
     ofs << opt.pulsar.num_producers << ",";
     ofs << opt.converter.num_threads << ",";
     ofs << bolson::parse::ToString(opt.converter.parser.impl) << ",";
+    ofs << bolson::ToString(opt.converter.wait.strategy) << ",";
     ofs << (opt.pulsar.topic.find("non-persistent") == std::string::npos) << ",";
     ofs << opt.pulsar.batching.enable << ",";
     ofs << converter_metrics.num_jsons_converted << ",";
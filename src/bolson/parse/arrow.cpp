@@ -26,6 +26,7 @@
 
 #include "bolson/log.h"
 #include "bolson/parse/parser.h"
+#include "bolson/parse/timestamp.h"
 
 namespace bolson::parse {
 
@@ -79,25 +80,28 @@ auto ArrowParserContext::Make(const ArrowOptions& opts, size_t num_parsers,
     result->input_schema_ = opts.schema;
   }
 
+  // Tagged string fields are converted to timestamps after parsing.
+  std::shared_ptr<arrow::Schema> converted;
+  BOLSON_ROE(WithTimestampFields(*result->input_schema_, &converted));
+  std::shared_ptr<arrow::Schema> timestamps;
+  if (!converted->Equals(*result->input_schema_, true)) {
+    timestamps = converted;
+  }
+
   // Add the sequence number field to the output schema if specified.
   if (opts.seq_column) {
-    BOLSON_ROE(WithSeqField(*result->input_schema_, &result->output_schema_));
+    BOLSON_ROE(WithSeqField(*converted, &result->output_schema_));
   } else {
-    result->output_schema_ = result->input_schema_;
+    result->output_schema_ = converted;
   }
 
   parse_opts.explicit_schema = result->input_schema_;
   parse_opts.unexpected_field_behavior = arrow::json::UnexpectedFieldBehavior::Error;
 
-  // Determine Arrow JSON table reader options.
-  arrow::json::ReadOptions read_opts;
-  read_opts.use_threads = false;  // threading is handled by Bolson
-  read_opts.block_size = 2 * read_opts.block_size;
-
   // Initialize all parsers.
   for (size_t i = 0; i < num_parsers; i++) {
-    result->parsers_.push_back(
-        std::make_shared<ArrowParser>(parse_opts, read_opts, opts.seq_column));
+    auto parser = std::make_shared<ArrowParser>(parse_opts, opts.seq_column, timestamps);
+    result->parsers_.push_back(parser);
   }
 
   // Allocate buffers. Use number of parsers if number of buffers is 0 in options.
@@ -109,68 +113,135 @@ auto ArrowParserContext::Make(const ArrowOptions& opts, size_t num_parsers,
   return Status::OK();
 }
 
+auto ArrowParser::Read(const uint8_t* data, size_t size,
+                       std::shared_ptr<arrow::RecordBatch>* out) -> Status {
+  // Parse the whole chunk as a single block. Unlike a TableReader, this needs no input
+  // stream, chunker or task group, and the converted columns are not chunked, so they
+  // do not have to be combined into a single batch by copying them.
+  auto result = arrow::json::ParseOne(parse_opts, arrow::Buffer::Wrap(data, size));
+  if (!result.ok()) {
+    return Status(Error::ArrowError, result.status().message());
+  }
+  *out = result.ValueOrDie();
+  if (timestamps != nullptr) {
+    BOLSON_ROE(ConvertTimestampColumns(*out, timestamps, out));
+  }
+  return Status::OK();
+}
+
+/// \brief Return the number of lines in a chunk, ignoring a trailing newline.
+static auto CountLines(const uint8_t* data, size_t size) -> size_t {
+  if (size == 0) return 0;
+  auto newlines = static_cast<size_t>(std::count(data, data + size - 1, '\n'));
+  return newlines + 1;
+}
+
+auto ArrowParser::ReadTolerant(const uint8_t* data, size_t size, illex::Seq first,
+                               std::vector<ParsedBatch>* parts,
+                               std::vector<illex::Seq>* skipped) -> Status {
+  if (size == 0) return Status::OK();
+
+  std::shared_ptr<arrow::RecordBatch> batch;
+  auto status = Read(data, size, &batch);
+  if (status.ok()) {
+    if (batch->num_rows() == 0) return Status::OK();
+    illex::SeqRange range = {first, first + batch->num_rows() - 1};
+    parts->emplace_back(batch, range);
+    return Status::OK();
+  }
+
+  // Arrow does not report which JSON is malformed, so bisect the chunk at a newline
+  // until the malformed JSONs are isolated. Valid chunks are parsed as a whole.
+  auto num_lines = CountLines(data, size);
+  if (num_lines == 1) {
+    auto length = size - static_cast<size_t>(data[size - 1] == '\n');
+    dead_letters_->Push(first, {reinterpret_cast<const char*>(data), length},
+                        status.msg());
+    skipped->push_back(first);
+    return Status::OK();
+  }
+
+  const auto* end = data + size - 1;
+  const auto* mid = data + size / 2;
+  const auto* split = std::find(mid, end, '\n');
+  if (split == end) {
+    // There is no newline in the second half, so take the last one of the first half.
+    split = mid;
+    while (*--split != '\n') {
+    }
+  }
+  auto head = static_cast<size_t>(split - data) + 1;
+  BOLSON_ROE(ReadTolerant(data, head, first, parts, skipped));
+  BOLSON_ROE(ReadTolerant(data + head, size - head, first + CountLines(data, head), parts,
+                          skipped));
+  return Status::OK();
+}
+
 auto ArrowParser::Parse(const std::vector<illex::JSONBuffer*>& buffers_in,
                         std::vector<ParsedBatch>* batches_out) -> Status {
   assert(batches_out != nullptr);
 
   for (auto* in : buffers_in) {
     assert(in != nullptr);
-    auto buffer = arrow::Buffer::Wrap(in->data(), in->size());
-    auto br = std::make_shared<arrow::io::BufferReader>(buffer);
-    auto tr_make_result = arrow::json::TableReader::Make(arrow::default_memory_pool(), br,
-                                                         read_opts, parse_opts);
-    if (!tr_make_result.ok()) {
-      return Status(Error::ArrowError, "Unable to make JSON Table Reader: " +
-                                           tr_make_result.status().message());
-    }
-    auto t_reader = tr_make_result.ValueOrDie();
-
-    auto tr_read_result = t_reader->Read();
-    if (!tr_read_result.ok()) {
-      SPDLOG_DEBUG(
-          "Encountered error while parsing (showing at most 256 characters...): {}",
-          std::string(reinterpret_cast<const char*>(in->data()),
-                      std::min(in->size(), static_cast<size_t>(256))));
-      return Status(
-          Error::ArrowError,
-          "Unable to read " + std::to_string(in->num_jsons()) +
-              " JSONs to RecordBatch(es): " + tr_read_result.status().message());
-    }
-    auto table = tr_read_result.ValueOrDie();
 
-    // Combine potential chunks in this table and read the first batch.
-    auto table_combine_result = table->CombineChunks();
-    if (!table_combine_result.ok()) {
-      return Status(Error::ArrowError, table_combine_result.status().message());
-    }
-    auto tb_reader = arrow::TableBatchReader(*table_combine_result.ValueOrDie());
-    auto table_reader_next_result = tb_reader.Next();
-    if (!table_reader_next_result.ok()) {
-      return Status(Error::ArrowError, table_reader_next_result.status().message());
+    // Batches that were parsed, with the sequence numbers of their first and last JSON.
+    std::vector<ParsedBatch> parts;
+    std::vector<illex::Seq> skipped;
+    if (dead_letters_ == nullptr) {
+      std::shared_ptr<arrow::RecordBatch> batch;
+      auto status = Read(in->data(), in->size(), &batch);
+      if (!status.ok()) {
+        SPDLOG_DEBUG(
+            "Encountered error while parsing (showing at most 256 characters...): {}",
+            std::string(reinterpret_cast<const char*>(in->data()),
+                        std::min(in->size(), static_cast<size_t>(256))));
+        return Status(Error::ArrowError,
+                      "Unable to read " + std::to_string(in->num_jsons()) +
+                          " JSONs to RecordBatch(es): " + status.msg());
+      }
+      parts.emplace_back(batch, in->range());
+    } else {
+      BOLSON_ROE(
+          ReadTolerant(in->data(), in->size(), in->range().first, &parts, &skipped));
     }
 
-    auto combined_batch = table_reader_next_result.ValueOrDie();
-
-    std::shared_ptr<arrow::RecordBatch> final_batch;
+    if (parts.empty()) {
+      // All JSONs were malformed, produce an empty batch.
+      std::unique_ptr<arrow::RecordBatchBuilder> builder;
+      std::shared_ptr<arrow::RecordBatch> empty;
+      auto schema = timestamps != nullptr ? timestamps : parse_opts.explicit_schema;
+      ARROW_ROE(arrow::RecordBatchBuilder::Make(schema, arrow::default_memory_pool(),
+                                                &builder));
+      ARROW_ROE(builder->Flush(&empty));
+      parts.emplace_back(empty, in->range());
+    }
 
     if (seq_column) {
-      std::shared_ptr<arrow::UInt64Array> seq;
-      arrow::UInt64Builder builder;
-      ARROW_ROE(builder.Reserve(in->range().last - in->range().first + 1));
-      for (uint64_t s = in->range().first; s <= in->range().last; s++) {
-        builder.UnsafeAppend(s);
+      // Number each part from its own first sequence number, as skipped JSONs leave gaps.
+      for (auto& part : parts) {
+        std::shared_ptr<arrow::UInt64Array> seq;
+        arrow::UInt64Builder builder;
+        ARROW_ROE(builder.Reserve(part.batch->num_rows()));
+        for (int64_t i = 0; i < part.batch->num_rows(); i++) {
+          builder.UnsafeAppend(part.seq_range.first + i);
+        }
+        ARROW_ROE(builder.Finish(&seq));
+        auto final_batch_result = part.batch->AddColumn(0, "bolson_seq", seq);
+        if (!final_batch_result.ok()) {
+          return Status(Error::ArrowError, final_batch_result.status().message());
+        }
+        part.batch = final_batch_result.ValueOrDie();
       }
-      ARROW_ROE(builder.Finish(&seq));
-      auto final_batch_result = combined_batch->AddColumn(0, "bolson_seq", seq);
-      if (!final_batch_result.ok()) {
-        return Status(Error::ArrowError, final_batch_result.status().message());
-      }
-      final_batch = final_batch_result.ValueOrDie();
-    } else {
-      final_batch = AddSeqAsSchemaMeta(combined_batch, in->range());
     }
 
-    batches_out->emplace_back(final_batch, in->range());
+    ParsedBatch result;
+    BOLSON_ROE(StitchBatches(parts, &result));
+    if (!seq_column) {
+      result.batch = AddSeqAsSchemaMeta(result.batch, in->range());
+    }
+    result.seq_range = in->range();
+    result.skipped = std::move(skipped);
+    batches_out->push_back(result);
   }
 
   return Status::OK();
@@ -59,19 +59,34 @@ void AddArrowOptionsToCLI(CLI::App* sub, ArrowOptions* out);
 /// \brief Parser implementation using Arrow's built-in JSON parser.
 class ArrowParser : public Parser {
  public:
-  explicit ArrowParser(arrow::json::ParseOptions parse_options,
-                       arrow::json::ReadOptions read_options, bool seq_column)
+  /**
+   * \brief Construct an Arrow parser.
+   * \param parse_options Options of the Arrow JSON parser, including the input schema.
+   * \param seq_column    Whether to add a column with sequence numbers.
+   * \param timestamps    Schema with timestamp fields to convert utf8 columns to, or
+   *                      nullptr if there are none.
+   */
+  ArrowParser(arrow::json::ParseOptions parse_options, bool seq_column,
+              std::shared_ptr<arrow::Schema> timestamps = nullptr)
       : parse_opts(std::move(parse_options)),
-        read_opts(read_options),
-        seq_column(seq_column) {}
+        seq_column(seq_column),
+        timestamps(std::move(timestamps)) {}
 
   auto Parse(const std::vector<illex::JSONBuffer*>& buffers_in,
              std::vector<ParsedBatch>* batches_out) -> Status override;
 
  private:
+  /// \brief Read a chunk of JSONs into a single RecordBatch.
+  auto Read(const uint8_t* data, size_t size, std::shared_ptr<arrow::RecordBatch>* out)
+      -> Status;
+  /// \brief Read a chunk of JSONs, sending malformed JSONs to the dead-letter sink.
+  auto ReadTolerant(const uint8_t* data, size_t size, illex::Seq first,
+                    std::vector<ParsedBatch>* parts, std::vector<illex::Seq>* skipped)
+      -> Status;
+
   arrow::json::ParseOptions parse_opts;
-  arrow::json::ReadOptions read_opts;
   bool seq_column;
+  std::shared_ptr<arrow::Schema> timestamps;
 };
 
 /// \brief Context for Arrow parsers.
@@ -84,6 +99,10 @@ class ArrowParserContext : public ParserContext {
 
   [[nodiscard]] auto input_schema() const -> std::shared_ptr<arrow::Schema> override;
   [[nodiscard]] auto output_schema() const -> std::shared_ptr<arrow::Schema> override;
+  [[nodiscard]] auto SupportsRingBuffers() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsSplitting() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsNuma() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsDeadLetters() const -> bool override { return true; }
 
  private:
   std::shared_ptr<arrow::Schema> input_schema_;
@@ -22,125 +22,58 @@
 
 #include "bolson/latency.h"
 #include "bolson/log.h"
-#include "bolson/parse/custom/common.h"
+#include "bolson/parse/custom/index.h"
+#include "bolson/parse/custom/ndjson.h"
 #include "bolson/parse/parser.h"
 
 namespace bolson::parse::custom {
 
 // assume ndjson
-static inline auto ParseBatteryNDJSONs(const char* data, size_t size,
-                                       arrow::ListBuilder* list_bld,
-                                       arrow::UInt64Builder* values_bld) -> Status {
-  auto error = Status(Error::GenericError, "Unable to parse JSON data.");
-
-  const auto* pos = data;
-  const auto* end = data + size;
-  // Eat any initial whitespace.
-  pos = EatWhitespace(pos, end);
-
-  // Start parsing objects
-  while ((pos < end) && (pos != nullptr)) {
-    pos = EatObjectStart(pos, end);  // {
-    pos = EatWhitespace(pos, end);
-    pos = EatMemberKey(pos, end, "voltage");  // "voltage"
-    pos = EatWhitespace(pos, end);
-    pos = EatMemberKeyValueSeperator(pos, end);  // :
-    pos = EatWhitespace(pos, end);
-    pos = EatUInt64Array(pos, end, list_bld, values_bld);  // e.g. [1,2,3]
-    pos = EatWhitespace(pos, end);
-    pos = EatObjectEnd(pos, end);  // }
-    pos = EatWhitespace(pos, end);
-    pos = EatChar(pos, end, '\n');
-
-    // The newline may be the last byte, check if we didn't reach end of input before
-    // continuing.
-    if ((pos < end) && (pos != nullptr)) {
-      pos = EatWhitespace(pos, end);
-    }
-  }
-
-  return Status::OK();
-}
-
-// assume ndjson
-static inline auto UnsafeParseBatteryNDJSONs(const char* data, size_t size,
-                                             arrow::ListBuilder* list_bld,
-                                             arrow::UInt64Builder* values_bld) -> Status {
-  auto error = Status(Error::GenericError, "Unable to parse JSON data.");
-
-  const auto* pos = data;
-  const auto* end = data + size;
-  // Eat any initial whitespace.
-  pos = EatWhitespace(pos, end);
-
-  // Start parsing objects
-  while ((pos < end) && (pos != nullptr)) {
-    pos = EatObjectStart(pos, end);  // {
-    pos = EatWhitespace(pos, end);
-    pos = EatMemberKey(pos, end, "voltage");  // "voltage"
-    pos = EatWhitespace(pos, end);
-    pos = EatMemberKeyValueSeperator(pos, end);  // :
-    pos = EatWhitespace(pos, end);
-    pos = EatUInt64ArrayUnsafe(pos, end, list_bld, values_bld);  // e.g. [1,2,3]
-    pos = EatWhitespace(pos, end);
-    pos = EatObjectEnd(pos, end);  // }
-    pos = EatWhitespace(pos, end);
-    pos = EatChar(pos, end, '\n');
-
-    // The newline may be the last byte, check if we didn't reach end of input before
-    // continuing.
-    if ((pos < end) && (pos != nullptr)) {
-      pos = EatWhitespace(pos, end);
-    }
-  }
-
-  return Status::OK();
-}
-
-auto UnsafeBatteryParser::ParseOne(const illex::JSONBuffer* buffer, ParsedBatch* out)
-    -> Status {
-  auto values_builder = std::make_shared<arrow::UInt64Builder>();
-  auto voltage_builder =
-      std::make_shared<arrow::ListBuilder>(arrow::default_memory_pool(), values_builder);
-  values_builder->Reserve(pre_alloc_values);
-  voltage_builder->Reserve(pre_alloc_offsets);
-
-  BOLSON_ROE(UnsafeParseBatteryNDJSONs(reinterpret_cast<const char*>(buffer->data()),
-                                       buffer->size(), voltage_builder.get(),
-                                       values_builder.get()));
-
-  std::shared_ptr<arrow::ListArray> voltage;
-  ARROW_ROE(voltage_builder->Finish(&voltage));
-
-  out->seq_range = buffer->range();
-  out->batch = arrow::RecordBatch::Make(output_schema(), voltage->length(), {voltage});
-
-  return Status::OK();
-}
-
 auto BatteryParser::ParseOne(const illex::JSONBuffer* buffer, ParsedBatch* out)
     -> Status {
-  auto values_builder = std::make_shared<arrow::UInt64Builder>();
-  auto voltage_builder =
-      std::make_shared<arrow::ListBuilder>(arrow::default_memory_pool(), values_builder);
-
-  // Reserve expected number of JSONs in case a seq. no. column is desired.
-  arrow::UInt64Builder seq_bld;
-  uint64_t seq = buffer->range().first;
-  if (seq_column) {
-    ARROW_ROE(seq_bld.Reserve(buffer->range().last - buffer->range().first + 1));
+  // Reserve capacity for the expected number of batteries and voltage values.
+  BOLSON_ROE(sizer_.Reserve(buffer->size()));
+
+  auto parse = [&](IndexCursor* cur) {
+    cur->Expect('{');
+    cur->Key("voltage");
+    ARROW_TOE(list_builder_->Append());
+    cur->UInt64Runs([&](const uint64_t* values, size_t count) {  // e.g. [1,2,3]
+      ARROW_TOE(values_builder_->AppendValues(values, static_cast<int64_t>(count)));
+    });
+    cur->Expect('}');
+  };
+
+  // Batches finished before every malformed JSON, in tolerant mode.
+  std::vector<ParsedBatch> parts;
+  auto finish = [&](int64_t length) -> Status {
+    std::shared_ptr<arrow::Array> voltage;
+    ARROW_ROE(list_builder_->Finish(&voltage));
+    auto batch =
+        arrow::RecordBatch::Make(output_schema(), length, {voltage->Slice(0, length)});
+    parts.emplace_back(batch, buffer->range());
+    return Status::OK();
+  };
+  auto cut = [&](size_t num_parsed) { return finish(static_cast<int64_t>(num_parsed)); };
+
+  std::vector<illex::Seq> skipped;
+  auto status = ParseNDJSONs(reinterpret_cast<const char*>(buffer->data()),
+                             buffer->size(), buffer->range().first, &index_,
+                             dead_letters_.get(), parse, cut, &skipped);
+  if (!status.ok()) {
+    // Reset the builders, discarding any partially parsed objects.
+    std::shared_ptr<arrow::Array> discarded;
+    (void)list_builder_->Finish(&discarded);
+    return status;
   }
+  if (parts.empty()) {
+    sizer_.Observe(buffer->size());
+  }
+  BOLSON_ROE(finish(list_builder_->length()));
 
-  BOLSON_ROE(ParseBatteryNDJSONs(reinterpret_cast<const char*>(buffer->data()),
-                                 buffer->size(), voltage_builder.get(),
-                                 values_builder.get()));
-
-  std::shared_ptr<arrow::ListArray> voltage;
-  ARROW_ROE(voltage_builder->Finish(&voltage));
-
+  BOLSON_ROE(StitchBatches(parts, out));
   out->seq_range = buffer->range();
-  out->batch = arrow::RecordBatch::Make(output_schema(), voltage->length(), {voltage});
-
+  out->skipped = std::move(skipped);
   return Status::OK();
 }
 
@@ -168,19 +101,12 @@ auto BatteryParser::output_schema() const -> std::shared_ptr<arrow::Schema> {
   return output_schema_;
 }
 
-BatteryParser::BatteryParser(bool seq_column) : seq_column(seq_column) {
-  if (seq_column) {
-    WithSeqField(*input_schema(), &output_schema_);
-  } else {
-    output_schema_ = input_schema();
-  }
-}
-
-UnsafeBatteryParser::UnsafeBatteryParser(bool seq_column, size_t pre_alloc_offsets = 0,
-                                         size_t pre_alloc_values = 0)
-    : BatteryParser(seq_column),
-      pre_alloc_offsets(pre_alloc_offsets),
-      pre_alloc_values(pre_alloc_values) {
+BatteryParser::BatteryParser(bool seq_column)
+    : seq_column(seq_column),
+      values_builder_(std::make_shared<arrow::UInt64Builder>()),
+      list_builder_(std::make_shared<arrow::ListBuilder>(arrow::default_memory_pool(),
+                                                         values_builder_)),
+      sizer_({list_builder_.get()}) {
   if (seq_column) {
     WithSeqField(*input_schema(), &output_schema_);
   } else {
@@ -197,14 +123,9 @@ auto BatteryParserContext::Make(const BatteryOptions& opts, size_t num_parsers,
   result->allocator_ = std::make_shared<buffer::Allocator>();
 
   // Initialize all parsers.
-  if (opts.pre_alloc_offsets + opts.pre_alloc_values > 0) {
-    result->parsers_ = std::vector<std::shared_ptr<BatteryParser>>(
-        num_parsers, std::make_shared<UnsafeBatteryParser>(
-                         opts.seq_column, opts.pre_alloc_offsets, opts.pre_alloc_values));
-  } else {
-    for (size_t i = 0; i < num_parsers; i++) {
-      result->parsers_.push_back(std::make_shared<BatteryParser>(opts.seq_column));
-    }
+  // Parsers hold a structural index and builders, so every thread needs its own.
+  for (size_t i = 0; i < num_parsers; i++) {
+    result->parsers_.push_back(std::make_shared<BatteryParser>(opts.seq_column));
   }
 
   // Allocate buffers. Use number of parsers if number of buffers is 0 in options.
@@ -232,14 +153,6 @@ void AddBatteryOptionsToCLI(CLI::App* sub, BatteryOptions* out) {
                 "Custom battery parser, retain ordering information by adding a sequence "
                 "number column.")
       ->default_val(false);
-  sub->add_option("--custom-battery-pre-alloc-offsets", out->pre_alloc_offsets,
-                  "Pre-allocate this many offsets when this value is > 0. Enables unsafe "
-                  "behavior.")
-      ->default_val(0);
-  sub->add_option(
-         "--custom-battery-pre-alloc-values", out->pre_alloc_values,
-         "Pre-allocate this many values when this value is > 0. Enables unsafe behavior.")
-      ->default_val(0);
 }
 
 }  // namespace bolson::parse::custom
@@ -21,6 +21,8 @@
 #include <memory>
 #include <utility>
 
+#include "bolson/parse/custom/index.h"
+#include "bolson/parse/custom/sizer.h"
 #include "bolson/parse/parser.h"
 #include "bolson/utils.h"
 
@@ -34,11 +36,6 @@ struct BatteryOptions {
   bool seq_column = false;
   /// Capacity of input buffers.
   size_t buf_capacity = 0;
-
-  /// Number of values to pre-allocate.
-  size_t pre_alloc_values;
-  /// Number of offsets to pre-allocate.
-  size_t pre_alloc_offsets;
 };
 
 void AddBatteryOptionsToCLI(CLI::App* sub, BatteryOptions* out);
@@ -50,26 +47,21 @@ class BatteryParser : public Parser {
   auto Parse(const std::vector<illex::JSONBuffer*>& in, std::vector<ParsedBatch>* out)
       -> Status override;
 
-  virtual auto ParseOne(const illex::JSONBuffer* buffer, ParsedBatch* out) -> Status;
+  auto ParseOne(const illex::JSONBuffer* buffer, ParsedBatch* out) -> Status;
 
   static auto input_schema() -> std::shared_ptr<arrow::Schema>;
   [[nodiscard]] auto output_schema() const -> std::shared_ptr<arrow::Schema>;
 
- protected:
+ private:
   bool seq_column = false;
   std::shared_ptr<arrow::Schema> output_schema_;
-};
-
-class UnsafeBatteryParser : public BatteryParser {
- public:
-  explicit UnsafeBatteryParser(bool seq_column, size_t pre_alloc_offsets,
-                               size_t pre_alloc_values);
-
-  auto ParseOne(const illex::JSONBuffer* buffer, ParsedBatch* out) -> Status override;
-
- private:
-  size_t pre_alloc_offsets;
-  size_t pre_alloc_values;
+  /// Structural index of the buffer being parsed, reused between buffers.
+  StructuralIndex index_;
+  /// Builders, reused between buffers.
+  std::shared_ptr<arrow::UInt64Builder> values_builder_;
+  std::shared_ptr<arrow::ListBuilder> list_builder_;
+  /// Pre-sizes the builders for every buffer.
+  BuilderSizer sizer_;
 };
 
 class BatteryParserContext : public ParserContext {
@@ -81,6 +73,10 @@ class BatteryParserContext : public ParserContext {
 
   [[nodiscard]] auto input_schema() const -> std::shared_ptr<arrow::Schema> override;
   [[nodiscard]] auto output_schema() const -> std::shared_ptr<arrow::Schema> override;
+  [[nodiscard]] auto SupportsRingBuffers() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsSplitting() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsNuma() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsDeadLetters() const -> bool override { return true; }
 
  private:
   std::vector<std::shared_ptr<BatteryParser>> parsers_;
@@ -0,0 +1,518 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/parse/custom/codegen.h"
+
+#include <arrow/api.h>
+
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bolson/parse/timestamp.h"
+
+namespace bolson::parse::custom {
+
+/// \brief Return the builder class and cursor method for a scalar type.
+static auto ScalarOf(const arrow::DataType& type, std::string* builder,
+                     std::string* method) -> bool {
+  switch (type.id()) {
+    case arrow::Type::UINT64:
+      *builder = "arrow::UInt64Builder";
+      *method = "UInt64";
+      return true;
+    case arrow::Type::INT64:
+      *builder = "arrow::Int64Builder";
+      *method = "Int64";
+      return true;
+    case arrow::Type::DOUBLE:
+      *builder = "arrow::DoubleBuilder";
+      *method = "Double";
+      return true;
+    case arrow::Type::BOOL:
+      *builder = "arrow::BooleanBuilder";
+      *method = "Bool";
+      return true;
+    case arrow::Type::STRING:
+      *builder = "arrow::StringBuilder";
+      *method = "UnescapedString";
+      return true;
+    case arrow::Type::TIMESTAMP:
+      *builder = "arrow::TimestampBuilder";
+      *method = "Timestamp";
+      return static_cast<const arrow::TimestampType&>(type).unit() ==
+             arrow::TimeUnit::NANO;
+    default:
+      return false;
+  }
+}
+
+static auto TypeExpr(const arrow::DataType& type) -> std::string;
+
+/// \brief Return a C++ string literal of a string.
+static auto Quote(const std::string& str) -> std::string {
+  std::string result = "\"";
+  for (char c : str) {
+    if ((c == '"') || (c == '\\')) {
+      result += '\\';
+    }
+    result += c;
+  }
+  return result + "\"";
+}
+
+/// \brief Return a C++ expression constructing an Arrow field, including its metadata.
+static auto FieldExpr(const arrow::Field& field) -> std::string {
+  std::string result = "arrow::field(" + Quote(field.name()) + ", " +
+                       TypeExpr(*field.type()) + ", " +
+                       (field.nullable() ? "true" : "false");
+  // Metadata tags fields, e.g. for dictionary encoding, so it must not get lost.
+  const auto& meta = field.metadata();
+  if ((meta != nullptr) && (meta->size() > 0)) {
+    std::string keys;
+    std::string values;
+    for (int64_t i = 0; i < meta->size(); i++) {
+      keys += (i > 0 ? ", " : "") + Quote(meta->key(i));
+      values += (i > 0 ? ", " : "") + Quote(meta->value(i));
+    }
+    result += ", arrow::key_value_metadata({" + keys + "}, {" + values + "})";
+  }
+  return result + ")";
+}
+
+/// \brief Return a C++ expression constructing an Arrow type.
+static auto TypeExpr(const arrow::DataType& type) -> std::string {
+  switch (type.id()) {
+    case arrow::Type::UINT64:
+      return "arrow::uint64()";
+    case arrow::Type::INT64:
+      return "arrow::int64()";
+    case arrow::Type::DOUBLE:
+      return "arrow::float64()";
+    case arrow::Type::BOOL:
+      return "arrow::boolean()";
+    case arrow::Type::STRING:
+      return "arrow::utf8()";
+    case arrow::Type::TIMESTAMP:
+      return "arrow::timestamp(arrow::TimeUnit::NANO, \"" +
+             static_cast<const arrow::TimestampType&>(type).timezone() + "\")";
+    case arrow::Type::LIST:
+      return "arrow::list(" + FieldExpr(*type.field(0)) + ")";
+    case arrow::Type::FIXED_SIZE_LIST:
+      return "arrow::fixed_size_list(" + FieldExpr(*type.field(0)) + ", " +
+             std::to_string(
+                 static_cast<const arrow::FixedSizeListType&>(type).list_size()) +
+             ")";
+    case arrow::Type::STRUCT: {
+      std::string result = "arrow::struct_({";
+      for (int i = 0; i < type.num_fields(); i++) {
+        result += (i > 0 ? ", " : "") + FieldExpr(*type.field(i));
+      }
+      return result + "})";
+    }
+    default:
+      return "nullptr";
+  }
+}
+
+/// State of the generator while walking a schema.
+struct Generator {
+  /// Typed builder members, as pairs of their class and initialization expression.
+  std::vector<std::pair<std::string, std::string>> builders;
+  /// Member keys of every object, in order of appearance.
+  std::vector<std::vector<std::string>> objects;
+  /// Body of the function parsing a single object.
+  std::stringstream body;
+  /// Indentation of the next line.
+  std::string indent = "  ";
+
+  auto AddBuilder(const std::string& type, const std::string& init) -> std::string {
+    auto name = "b" + std::to_string(builders.size()) + "_";
+    builders.emplace_back(type, "static_cast<" + type + "*>(" + init + ")");
+    return name;
+  }
+
+  void Line(const std::string& line) { body << indent << line << "\n"; }
+  void Indent() { indent += "  "; }
+  void Dedent() { indent.resize(indent.size() - 2); }
+
+  auto Value(const arrow::Field& field, const std::string& init) -> Status {
+    const auto& type = *field.type();
+    std::string builder_type;
+    std::string method;
+
+    if (ScalarOf(type, &builder_type, &method)) {
+      auto b = AddBuilder(builder_type, init);
+      Line("ARROW_TOE(" + b + "->Append(cur->" + method + "()));");
+      return Status::OK();
+    }
+
+    switch (type.id()) {
+      case arrow::Type::LIST:
+      case arrow::Type::FIXED_SIZE_LIST: {
+        if (!ScalarOf(*type.field(0)->type(), &builder_type, &method) ||
+            (method == "UnescapedString")) {
+          return Status(Error::GenericError,
+                        "Generated parsers do not support field " + field.ToString());
+        }
+        auto is_fixed = type.id() == arrow::Type::FIXED_SIZE_LIST;
+        auto list = AddBuilder(
+            is_fixed ? "arrow::FixedSizeListBuilder" : "arrow::ListBuilder", init);
+        auto values = AddBuilder(builder_type, "result->" + list + "->value_builder()");
+        Line("ARROW_TOE(" + list + "->Append());");
+        if (!is_fixed) {
+          Line("cur->Array([&]() { ARROW_TOE(" + values + "->Append(cur->" + method +
+               "())); });");
+          return Status::OK();
+        }
+        // Unroll fixed-size lists, reserving space for all elements up front.
+        auto size = static_cast<const arrow::FixedSizeListType&>(type).list_size();
+        Line("ARROW_TOE(" + values + "->Reserve(" + std::to_string(size) + "));");
+        Line("cur->Expect('[');");
+        for (int i = 0; i < size; i++) {
+          if (i > 0) {
+            Line("cur->Expect(',');");
+          }
+          Line(values + "->UnsafeAppend(cur->" + method + "());");
+        }
+        Line("cur->Expect(']');");
+        return Status::OK();
+      }
+      case arrow::Type::STRUCT: {
+        auto b = AddBuilder("arrow::StructBuilder", init);
+        Line("ARROW_TOE(" + b + "->Append());");
+        std::vector<std::string> children;
+        for (int i = 0; i < type.num_fields(); i++) {
+          children.push_back("result->" + b + "->child_builder(" + std::to_string(i) +
+                             ").get()");
+        }
+        return Fields(type.fields(), children);
+      }
+      default:
+        return Status(Error::GenericError,
+                      "Generated parsers do not support field " + field.ToString());
+    }
+  }
+
+  /// \brief Emit the dispatch of the members of an object to their values.
+  auto Fields(const arrow::FieldVector& fields, const std::vector<std::string>& inits)
+      -> Status {
+    const size_t o = objects.size();
+    auto d = "d" + std::to_string(o) + "_";
+    auto m = "m" + std::to_string(o);
+    objects.emplace_back();
+    Line(d + ".Object(cur, [&](size_t " + m + ") {");
+    Indent();
+    Line("switch (" + m + ") {");
+    Indent();
+    for (size_t f = 0; f < fields.size(); f++) {
+      const auto& name = fields[f]->name();
+      // Keys are emitted as string literals and compared to the raw JSON.
+      for (char c : name) {
+        if ((c == '"') || (c == '\\') || (static_cast<unsigned char>(c) < 0x20)) {
+          return Status(Error::GenericError,
+                        "Generated parsers do not support field name " + name);
+        }
+      }
+      objects[o].push_back(name);
+      Line("case " + std::to_string(f) + ": {");
+      Indent();
+      BOLSON_ROE(Value(*fields[f], inits[f]));
+      Line("break;");
+      Dedent();
+      Line("}");
+    }
+    Dedent();
+    Line("}");
+    Dedent();
+    Line("});");
+    return Status::OK();
+  }
+};
+
+auto GenerateParser(const arrow::Schema& input, const std::string& name,
+                    GeneratedSources* out) -> Status {
+  // Tagged string fields are parsed as timestamps.
+  std::shared_ptr<arrow::Schema> output;
+  BOLSON_ROE(WithTimestampFields(input, &output));
+  const auto& schema = *output;
+
+  Generator gen;
+  std::vector<std::string> inits;
+  for (int i = 0; i < schema.num_fields(); i++) {
+    inits.push_back("result->builder_->GetField(" + std::to_string(i) + ")");
+  }
+  BOLSON_ROE(gen.Fields(schema.fields(), inits));
+
+  const std::string ns = "bolson::parse::generated::" + name;
+
+  std::stringstream h;
+  h << "// Generated by bolson-codegen. Do not edit.\n"
+       "//\n"
+       "// Parser for schema:\n";
+  for (const auto& field : schema.fields()) {
+    h << "//   " << field->ToString() << "\n";
+  }
+  h << "\n"
+       "#pragma once\n"
+       "\n"
+       "#include <arrow/api.h>\n"
+       "\n"
+       "#include <memory>\n"
+       "#include <vector>\n"
+       "\n"
+       "#include \"bolson/parse/custom/generic.h\"\n"
+       "#include \"bolson/parse/custom/index.h\"\n"
+       "#include \"bolson/parse/custom/members.h\"\n"
+       "#include \"bolson/parse/custom/sizer.h\"\n"
+       "#include \"bolson/parse/parser.h\"\n"
+       "\n"
+       "namespace "
+    << ns
+    << " {\n"
+       "\n"
+       "/// \\brief Return the schema this parser was generated for.\n"
+       "auto schema() -> std::shared_ptr<arrow::Schema>;\n"
+       "\n"
+       "class GeneratedParser : public Parser {\n"
+       " public:\n"
+       "  static auto Make(std::shared_ptr<GeneratedParser>* out) -> Status;\n"
+       "\n"
+       "  auto Parse(const std::vector<illex::JSONBuffer*>& in,\n"
+       "             std::vector<ParsedBatch>* out) -> Status override;\n"
+       "\n"
+       "  auto ParseOne(const illex::JSONBuffer* buffer, ParsedBatch* out) -> Status;\n"
+       "\n"
+       " private:\n"
+       "  GeneratedParser() = default;\n"
+       "  void ParseObject(custom::IndexCursor* cur);\n"
+       "  auto Flush(int64_t num_rows, std::shared_ptr<arrow::RecordBatch>* out) "
+       "-> Status;\n"
+       "\n"
+       "  std::unique_ptr<arrow::RecordBatchBuilder> builder_;\n"
+       "  custom::StructuralIndex index_;\n"
+       "  custom::BuilderSizer sizer_;\n";
+  for (size_t i = 0; i < gen.builders.size(); i++) {
+    h << "  " << gen.builders[i].first << "* b" << i << "_ = nullptr;\n";
+  }
+  for (size_t i = 0; i < gen.objects.size(); i++) {
+    h << "  custom::MemberDispatch d" << i << "_;\n";
+  }
+  h << "};\n"
+       "\n"
+       "class GeneratedParserContext : public ParserContext {\n"
+       " public:\n"
+       "  static auto Make(const custom::GenericOptions& opts, size_t num_parsers,\n"
+       "                   size_t input_size, std::shared_ptr<ParserContext>* out)\n"
+       "      -> Status;\n"
+       "\n"
+       "  auto parsers() -> std::vector<std::shared_ptr<Parser>> override;\n"
+       "\n"
+       "  [[nodiscard]] auto input_schema() const\n"
+       "      -> std::shared_ptr<arrow::Schema> override;\n"
+       "  [[nodiscard]] auto output_schema() const\n"
+       "      -> std::shared_ptr<arrow::Schema> override;\n"
+       "  [[nodiscard]] auto SupportsRingBuffers() const -> bool override {\n"
+       "    return true;\n"
+       "  }\n"
+       "  [[nodiscard]] auto SupportsSplitting() const -> bool override {\n"
+       "    return true;\n"
+       "  }\n"
+       "  [[nodiscard]] auto SupportsNuma() const -> bool override { return true; }\n"
+       "  [[nodiscard]] auto SupportsDeadLetters() const -> bool override {\n"
+       "    return true;\n"
+       "  }\n"
+       "\n"
+       " private:\n"
+       "  std::vector<std::shared_ptr<GeneratedParser>> parsers_;\n"
+       "};\n"
+       "\n"
+       "}  // namespace "
+    << ns << "\n";
+
+  std::stringstream s;
+  s << "// Generated by bolson-codegen. Do not edit.\n"
+       "\n"
+       "#include \"bolson/parse/generated/"
+    << name
+    << ".h\"\n"
+       "\n"
+       "#include <arrow/api.h>\n"
+       "\n"
+       "#include \"bolson/log.h\"\n"
+       "#include \"bolson/parse/custom/ndjson.h\"\n"
+       "\n"
+       "namespace "
+    << ns
+    << " {\n"
+       "\n"
+       "auto schema() -> std::shared_ptr<arrow::Schema> {\n"
+       "  static auto result = arrow::schema({\n";
+  for (const auto& field : schema.fields()) {
+    s << "      " << FieldExpr(*field) << ",\n";
+  }
+  s << "  });\n"
+       "  return result;\n"
+       "}\n"
+       "\n"
+       "auto GeneratedParser::Make(std::shared_ptr<GeneratedParser>* out) -> Status {\n"
+       "  auto result = std::shared_ptr<GeneratedParser>(new GeneratedParser());\n"
+       "  ARROW_ROE(arrow::RecordBatchBuilder::Make(schema(), "
+       "arrow::default_memory_pool(),\n"
+       "                                            &result->builder_));\n";
+  for (size_t i = 0; i < gen.builders.size(); i++) {
+    s << "  result->b" << i << "_ = " << gen.builders[i].second << ";\n";
+  }
+  for (size_t i = 0; i < gen.objects.size(); i++) {
+    s << "  BOLSON_ROE(custom::MemberDispatch::Make(\n"
+         "      {\n";
+    for (const auto& key : gen.objects[i]) {
+      s << "          \"" << key << "\",\n";
+    }
+    s << "      },\n"
+         "      &result->d"
+      << i << "_));\n";
+  }
+  s << "  std::vector<arrow::ArrayBuilder*> builders;\n"
+       "  for (int i = 0; i < result->builder_->num_fields(); i++) {\n"
+       "    builders.push_back(result->builder_->GetField(i));\n"
+       "  }\n"
+       "  result->sizer_ = custom::BuilderSizer(builders);\n"
+       "  *out = std::move(result);\n"
+       "  return Status::OK();\n"
+       "}\n"
+       "\n"
+       "void GeneratedParser::ParseObject(custom::IndexCursor* cur) {\n"
+    << gen.body.str()
+    << "}\n"
+       "\n"
+       "auto GeneratedParser::Flush(int64_t num_rows, "
+       "std::shared_ptr<arrow::RecordBatch>* out)\n"
+       "    -> Status {\n"
+       "  // A malformed object may have left values in some builders but not in "
+       "others,\n"
+       "  // so every builder is finished on its own and cut to the number of rows.\n"
+       "  std::vector<std::shared_ptr<arrow::Array>> columns(builder_->num_fields());\n"
+       "  arrow::Status status;\n"
+       "  for (int i = 0; i < builder_->num_fields(); i++) {\n"
+       "    status &= builder_->GetField(i)->Finish(&columns[i]);\n"
+       "  }\n"
+       "  ARROW_ROE(status);\n"
+       "  if (num_rows < 0) {\n"
+       "    num_rows = columns.empty() ? 0 : columns[0]->length();\n"
+       "  }\n"
+       "  for (auto& column : columns) {\n"
+       "    if (column->length() < num_rows) {\n"
+       "      return Status(Error::GenericError, \"Builder holds fewer values than "
+       "rows.\");\n"
+       "    }\n"
+       "    column = column->Slice(0, num_rows);\n"
+       "  }\n"
+       "  *out = arrow::RecordBatch::Make(builder_->schema(), num_rows, columns);\n"
+       "  return Status::OK();\n"
+       "}\n"
+       "\n"
+       "auto GeneratedParser::ParseOne(const illex::JSONBuffer* buffer, "
+       "ParsedBatch* out)\n"
+       "    -> Status {\n"
+       "  BOLSON_ROE(sizer_.Reserve(buffer->size()));\n"
+       "\n"
+       "  // Batches finished before every malformed JSON, in tolerant mode.\n"
+       "  std::vector<ParsedBatch> parts;\n"
+       "  auto cut = [&](size_t num_parsed) -> Status {\n"
+       "    std::shared_ptr<arrow::RecordBatch> batch;\n"
+       "    BOLSON_ROE(Flush(static_cast<int64_t>(num_parsed), &batch));\n"
+       "    parts.emplace_back(batch, buffer->range());\n"
+       "    return Status::OK();\n"
+       "  };\n"
+       "\n"
+       "  std::vector<illex::Seq> skipped;\n"
+       "  auto status = custom::ParseNDJSONs(\n"
+       "      reinterpret_cast<const char*>(buffer->data()), buffer->size(),\n"
+       "      buffer->range().first, &index_, dead_letters_.get(),\n"
+       "      [&](custom::IndexCursor* cur) { ParseObject(cur); }, cut, &skipped);\n"
+       "  if (!status.ok()) {\n"
+       "    // Reset the builders, discarding any partially parsed objects.\n"
+       "    std::shared_ptr<arrow::RecordBatch> discarded;\n"
+       "    (void)Flush(0, &discarded);\n"
+       "    return status;\n"
+       "  }\n"
+       "  if (parts.empty()) {\n"
+       "    sizer_.Observe(buffer->size());\n"
+       "  }\n"
+       "\n"
+       "  std::shared_ptr<arrow::RecordBatch> batch;\n"
+       "  BOLSON_ROE(Flush(-1, &batch));\n"
+       "  parts.emplace_back(batch, buffer->range());\n"
+       "\n"
+       "  BOLSON_ROE(StitchBatches(parts, out));\n"
+       "  out->seq_range = buffer->range();\n"
+       "  out->skipped = std::move(skipped);\n"
+       "  return Status::OK();\n"
+       "}\n"
+       "\n"
+       "auto GeneratedParser::Parse(const std::vector<illex::JSONBuffer*>& in,\n"
+       "                            std::vector<ParsedBatch>* out) -> Status {\n"
+       "  for (auto* buf : in) {\n"
+       "    ParsedBatch batch;\n"
+       "    BOLSON_ROE(this->ParseOne(buf, &batch));\n"
+       "    out->push_back(batch);\n"
+       "  }\n"
+       "  return Status::OK();\n"
+       "}\n"
+       "\n"
+       "auto GeneratedParserContext::Make(const custom::GenericOptions& opts,\n"
+       "                                  size_t num_parsers, size_t input_size,\n"
+       "                                  std::shared_ptr<ParserContext>* out) -> Status "
+       "{\n"
+       "  auto result = std::make_shared<GeneratedParserContext>();\n"
+       "  result->allocator_ = std::make_shared<buffer::Allocator>();\n"
+       "  for (size_t i = 0; i < num_parsers; i++) {\n"
+       "    std::shared_ptr<GeneratedParser> parser;\n"
+       "    BOLSON_ROE(GeneratedParser::Make(&parser));\n"
+       "    result->parsers_.push_back(parser);\n"
+       "  }\n"
+       "  auto num_buffers = opts.num_buffers == 0 ? num_parsers : opts.num_buffers;\n"
+       "  BOLSON_ROE(\n"
+       "      result->AllocateBuffers(num_buffers, DivideCeil(input_size, "
+       "num_buffers)));\n"
+       "  *out = std::static_pointer_cast<ParserContext>(result);\n"
+       "  return Status::OK();\n"
+       "}\n"
+       "\n"
+       "auto GeneratedParserContext::parsers() "
+       "-> std::vector<std::shared_ptr<Parser>> {\n"
+       "  return CastPtrs<Parser>(parsers_);\n"
+       "}\n"
+       "\n"
+       "auto GeneratedParserContext::input_schema() const\n"
+       "    -> std::shared_ptr<arrow::Schema> {\n"
+       "  return schema();\n"
+       "}\n"
+       "\n"
+       "auto GeneratedParserContext::output_schema() const\n"
+       "    -> std::shared_ptr<arrow::Schema> {\n"
+       "  return schema();\n"
+       "}\n"
+       "\n"
+       "}  // namespace "
+    << ns << "\n";
+
+  out->header = h.str();
+  out->source = s.str();
+  return Status::OK();
+}
+
+}  // namespace bolson::parse::custom
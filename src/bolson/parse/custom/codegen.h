@@ -0,0 +1,51 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+
+#include <string>
+
+#include "bolson/status.h"
+
+namespace bolson::parse::custom {
+
+/// Sources of a generated parser.
+struct GeneratedSources {
+  /// Contents of bolson/parse/generated/<name>.h
+  std::string header;
+  /// Contents of bolson/parse/generated/<name>.cpp
+  std::string source;
+};
+
+/**
+ * \brief Generate the sources of a parser specialized for a schema.
+ *
+ * The generated parser supports the same types as the generic parser, but the parse
+ * plan is emitted as code: members are dispatched through a switch per object, builders
+ * are stored with their concrete types, and fixed-size lists are unrolled.
+ *
+ * The generated code declares GeneratedParser and GeneratedParserContext in namespace
+ * bolson::parse::generated::<name>. The context takes custom::GenericOptions.
+ *
+ * \param schema The Arrow schema of the JSON objects.
+ * \param name   The name of the parser. Must be a valid C++ identifier.
+ * \param out    The generated sources.
+ * \return Status::OK() if successful, an error if the schema has unsupported types.
+ */
+auto GenerateParser(const arrow::Schema& schema, const std::string& name,
+                    GeneratedSources* out) -> Status;
+
+}  // namespace bolson::parse::custom
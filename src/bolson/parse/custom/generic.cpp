@@ -0,0 +1,503 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/parse/custom/generic.h"
+
+#include <arrow/api.h>
+
+#include <sstream>
+
+#include "bolson/log.h"
+#include "bolson/parse/arrow.h"
+#include "bolson/parse/custom/ndjson.h"
+#include "bolson/parse/timestamp.h"
+
+namespace bolson::parse::custom {
+
+static auto ToString(PlanOp op) -> std::string {
+  switch (op) {
+    case PlanOp::OBJECT:
+      return "object";
+    case PlanOp::SCALAR:
+      return "scalar";
+    case PlanOp::LIST:
+      return "list";
+    case PlanOp::FIXED_SIZE_LIST:
+      return "fixed_size_list";
+  }
+  return "Corrupt bolson::parse::custom::PlanOp enum value.";
+}
+
+static auto ToString(ValueKind kind) -> std::string {
+  switch (kind) {
+    case ValueKind::UINT64:
+      return "uint64";
+    case ValueKind::INT64:
+      return "int64";
+    case ValueKind::FLOAT64:
+      return "float64";
+    case ValueKind::BOOL:
+      return "bool";
+    case ValueKind::UTF8:
+      return "utf8";
+    case ValueKind::TIMESTAMP:
+      return "timestamp";
+  }
+  return "Corrupt bolson::parse::custom::ValueKind enum value.";
+}
+
+auto ParsePlan::ToString() const -> std::string {
+  std::stringstream ss;
+  for (size_t i = 0; i < steps.size(); i++) {
+    const auto& s = steps[i];
+    ss << i << ": " << custom::ToString(s.op);
+    if (!s.key.empty()) {
+      ss << " \"" << s.key << "\"";
+    }
+    if (s.nullable) {
+      ss << " nullable";
+    }
+    switch (s.op) {
+      case PlanOp::OBJECT:
+        ss << " {";
+        for (size_t m = 0; m < s.members.size(); m++) {
+          ss << (m > 0 ? ", " : "") << s.members[m];
+        }
+        ss << "}";
+        break;
+      case PlanOp::SCALAR:
+      case PlanOp::LIST:
+        ss << " " << custom::ToString(s.kind);
+        break;
+      case PlanOp::FIXED_SIZE_LIST:
+        ss << " " << custom::ToString(s.kind) << "[" << s.list_size << "]";
+        break;
+    }
+    ss << "\n";
+  }
+  return ss.str();
+}
+
+/// \brief Return the kind of scalar values of an Arrow type.
+static auto KindOf(const arrow::DataType& type, ValueKind* out) -> Status {
+  switch (type.id()) {
+    case arrow::Type::UINT64:
+      *out = ValueKind::UINT64;
+      return Status::OK();
+    case arrow::Type::INT64:
+      *out = ValueKind::INT64;
+      return Status::OK();
+    case arrow::Type::DOUBLE:
+      *out = ValueKind::FLOAT64;
+      return Status::OK();
+    case arrow::Type::BOOL:
+      *out = ValueKind::BOOL;
+      return Status::OK();
+    case arrow::Type::STRING:
+      *out = ValueKind::UTF8;
+      return Status::OK();
+    case arrow::Type::TIMESTAMP:
+      if (static_cast<const arrow::TimestampType&>(type).unit() !=
+          arrow::TimeUnit::NANO) {
+        return Status(Error::GenericError,
+                      "Generic parser only supports timestamps in nanoseconds.");
+      }
+      *out = ValueKind::TIMESTAMP;
+      return Status::OK();
+    default:
+      return Status(Error::GenericError,
+                    "Generic parser does not support type " + type.ToString());
+  }
+}
+
+static auto CompileFields(const arrow::FieldVector& fields,
+                          const std::vector<arrow::ArrayBuilder*>& builders,
+                          size_t object, ParsePlan* out) -> Status;
+
+static auto CompileValue(const arrow::Field& field, arrow::ArrayBuilder* builder,
+                         ParsePlan* out) -> Status {
+  const auto& type = *field.type();
+  PlanStep step;
+  step.builder = builder;
+  step.key = field.name();
+  step.nullable = field.nullable();
+  out->nullable |= step.nullable;
+  switch (type.id()) {
+    case arrow::Type::LIST:
+    case arrow::Type::FIXED_SIZE_LIST: {
+      const auto& value_type = *type.field(0)->type();
+      BOLSON_ROE(KindOf(value_type, &step.kind));
+      if (step.kind == ValueKind::UTF8) {
+        return Status(Error::GenericError,
+                      "Generic parser does not support lists of strings.");
+      }
+      if (type.id() == arrow::Type::LIST) {
+        step.op = PlanOp::LIST;
+        step.values = static_cast<arrow::ListBuilder*>(builder)->value_builder();
+      } else {
+        step.op = PlanOp::FIXED_SIZE_LIST;
+        step.values = static_cast<arrow::FixedSizeListBuilder*>(builder)->value_builder();
+        step.list_size = static_cast<const arrow::FixedSizeListType&>(type).list_size();
+      }
+      out->steps.push_back(std::move(step));
+      return Status::OK();
+    }
+    case arrow::Type::STRUCT: {
+      auto* struct_builder = static_cast<arrow::StructBuilder*>(builder);
+      std::vector<arrow::ArrayBuilder*> children;
+      for (int i = 0; i < struct_builder->num_children(); i++) {
+        children.push_back(struct_builder->child_builder(i).get());
+      }
+      step.op = PlanOp::OBJECT;
+      size_t object = out->steps.size();
+      out->steps.push_back(std::move(step));
+      return CompileFields(type.fields(), children, object, out);
+    }
+    default:
+      step.op = PlanOp::SCALAR;
+      BOLSON_ROE(KindOf(type, &step.kind));
+      out->steps.push_back(std::move(step));
+      return Status::OK();
+  }
+}
+
+static auto CompileFields(const arrow::FieldVector& fields,
+                          const std::vector<arrow::ArrayBuilder*>& builders,
+                          size_t object, ParsePlan* out) -> Status {
+  std::vector<std::string> keys;
+  for (size_t f = 0; f < fields.size(); f++) {
+    out->steps[object].members.push_back(out->steps.size());
+    keys.push_back(fields[f]->name());
+    BOLSON_ROE(CompileValue(*fields[f], builders[f], out));
+  }
+  return MemberDispatch::Make(keys, &out->steps[object].dispatch);
+}
+
+auto CompilePlan(const arrow::Schema& schema, arrow::RecordBatchBuilder* builder,
+                 ParsePlan* out) -> Status {
+  out->steps.clear();
+  out->nullable = false;
+  std::vector<arrow::ArrayBuilder*> builders;
+  for (int i = 0; i < builder->num_fields(); i++) {
+    builders.push_back(builder->GetField(i));
+  }
+  out->steps.emplace_back();
+  return CompileFields(schema.fields(), builders, 0, out);
+}
+
+static inline void AppendScalar(ValueKind kind, arrow::ArrayBuilder* builder,
+                                IndexCursor* cur) {
+  switch (kind) {
+    case ValueKind::UINT64:
+      ARROW_TOE(static_cast<arrow::UInt64Builder*>(builder)->Append(cur->UInt64()));
+      break;
+    case ValueKind::INT64:
+      ARROW_TOE(static_cast<arrow::Int64Builder*>(builder)->Append(cur->Int64()));
+      break;
+    case ValueKind::FLOAT64:
+      ARROW_TOE(static_cast<arrow::DoubleBuilder*>(builder)->Append(cur->Double()));
+      break;
+    case ValueKind::BOOL:
+      ARROW_TOE(static_cast<arrow::BooleanBuilder*>(builder)->Append(cur->Bool()));
+      break;
+    case ValueKind::UTF8:
+      ARROW_TOE(
+          static_cast<arrow::StringBuilder*>(builder)->Append(cur->UnescapedString()));
+      break;
+    case ValueKind::TIMESTAMP:
+      ARROW_TOE(static_cast<arrow::TimestampBuilder*>(builder)->Append(cur->Timestamp()));
+      break;
+  }
+}
+
+/// \brief Append the placeholder value of a null scalar.
+static inline void AppendDefault(ValueKind kind, arrow::ArrayBuilder* builder) {
+  switch (kind) {
+    case ValueKind::UINT64:
+      ARROW_TOE(static_cast<arrow::UInt64Builder*>(builder)->Append(0));
+      break;
+    case ValueKind::INT64:
+      ARROW_TOE(static_cast<arrow::Int64Builder*>(builder)->Append(0));
+      break;
+    case ValueKind::FLOAT64:
+      ARROW_TOE(static_cast<arrow::DoubleBuilder*>(builder)->Append(0.0));
+      break;
+    case ValueKind::BOOL:
+      ARROW_TOE(static_cast<arrow::BooleanBuilder*>(builder)->Append(false));
+      break;
+    case ValueKind::UTF8:
+      ARROW_TOE(static_cast<arrow::StringBuilder*>(builder)->Append("", 0));
+      break;
+    case ValueKind::TIMESTAMP:
+      ARROW_TOE(static_cast<arrow::TimestampBuilder*>(builder)->Append(0));
+      break;
+  }
+}
+
+/// \brief Append all elements of an array, parsing runs of uint64 values at once.
+static inline auto AppendArray(ValueKind kind, arrow::ArrayBuilder* builder,
+                               IndexCursor* cur) -> size_t {
+  if (kind == ValueKind::UINT64) {
+    auto* values = static_cast<arrow::UInt64Builder*>(builder);
+    return cur->UInt64Runs([&](const uint64_t* run, size_t count) {
+      ARROW_TOE(values->AppendValues(run, static_cast<int64_t>(count)));
+    });
+  }
+  return cur->Array([&]() { AppendScalar(kind, builder, cur); });
+}
+
+void GenericParser::AppendEmpty(size_t s) {
+  auto& step = plan_.steps[s];
+  if (step.nullable) {
+    step.validity.Append(false);
+  }
+  switch (step.op) {
+    case PlanOp::OBJECT:
+      ARROW_TOE(static_cast<arrow::StructBuilder*>(step.builder)->Append());
+      for (auto member : step.members) {
+        AppendEmpty(member);
+      }
+      break;
+    case PlanOp::SCALAR:
+      AppendDefault(step.kind, step.builder);
+      break;
+    case PlanOp::LIST:
+      ARROW_TOE(static_cast<arrow::ListBuilder*>(step.builder)->Append());
+      break;
+    case PlanOp::FIXED_SIZE_LIST:
+      ARROW_TOE(static_cast<arrow::FixedSizeListBuilder*>(step.builder)->Append());
+      for (int32_t i = 0; i < step.list_size; i++) {
+        AppendDefault(step.kind, step.values);
+      }
+      break;
+  }
+}
+
+void GenericParser::AppendAbsent(size_t s) {
+  const auto& step = plan_.steps[s];
+  if (!step.nullable) {
+    throw std::runtime_error(fmt::format("Missing member \"{}\"", step.key));
+  }
+  AppendEmpty(s);
+}
+
+void GenericParser::Interpret(size_t s, IndexCursor* cur) {
+  auto& step = plan_.steps[s];
+  if (step.nullable) {
+    if (cur->Null()) {
+      AppendEmpty(s);
+      return;
+    }
+    step.validity.Append(true);
+  }
+  switch (step.op) {
+    case PlanOp::OBJECT:
+      if (step.builder != nullptr) {
+        ARROW_TOE(static_cast<arrow::StructBuilder*>(step.builder)->Append());
+      }
+      step.dispatch.Object(
+          cur, [&](size_t m) { Interpret(step.members[m], cur); },
+          [&](size_t m) { AppendAbsent(step.members[m]); });
+      break;
+    case PlanOp::SCALAR:
+      AppendScalar(step.kind, step.builder, cur);
+      break;
+    case PlanOp::LIST:
+      ARROW_TOE(static_cast<arrow::ListBuilder*>(step.builder)->Append());
+      AppendArray(step.kind, step.values, cur);
+      break;
+    case PlanOp::FIXED_SIZE_LIST: {
+      ARROW_TOE(static_cast<arrow::FixedSizeListBuilder*>(step.builder)->Append());
+      auto count = AppendArray(step.kind, step.values, cur);
+      if (count != static_cast<size_t>(step.list_size)) {
+        throw std::runtime_error(fmt::format("Expected {} list elements, encountered {}",
+                                             step.list_size, count));
+      }
+      break;
+    }
+  }
+}
+
+auto GenericParser::FinishArray(size_t s, int64_t length,
+                                std::shared_ptr<arrow::ArrayData>* data) -> Status {
+  auto& step = plan_.steps[s];
+  if ((*data)->length < length) {
+    return Status(Error::GenericError, "Builder holds fewer values than rows.");
+  }
+  auto result = (*data)->Copy();
+  // Builders of any partially parsed object hold values beyond the last row. Builders
+  // never hold nulls, so only the lengths of the arrays need to be cut.
+  result->length = length;
+  if (step.nullable) {
+    // Builders only hold placeholders for nulls, so their bitmaps are replaced.
+    int64_t null_count = 0;
+    BOLSON_ROE(step.validity.Finish(length, &result->buffers[0], &null_count));
+    result->null_count = null_count;
+  }
+  if (step.op == PlanOp::OBJECT) {
+    for (size_t m = 0; m < step.members.size(); m++) {
+      BOLSON_ROE(FinishArray(step.members[m], length, &result->child_data[m]));
+    }
+  }
+  *data = result;
+  return Status::OK();
+}
+
+auto GenericParser::Flush(int64_t num_rows, std::shared_ptr<arrow::RecordBatch>* out)
+    -> Status {
+  // Finish every builder on its own, as a malformed object may have left values in some
+  // of them but not in others. All builders are finished, also after an error, such
+  // that none of them keeps values for the next buffer.
+  std::vector<std::shared_ptr<arrow::Array>> arrays(builder_->num_fields());
+  arrow::Status finished;
+  for (int i = 0; i < builder_->num_fields(); i++) {
+    finished &= builder_->GetField(i)->Finish(&arrays[i]);
+  }
+  auto status = Status::OK();
+  if (!finished.ok()) {
+    status = Status(Error::ArrowError, finished.ToString());
+  }
+
+  if (num_rows < 0) {
+    num_rows = arrays.empty() || (arrays[0] == nullptr) ? 0 : arrays[0]->length();
+  }
+  arrow::ArrayDataVector columns;
+  const auto& top = plan_.steps[0];
+  for (size_t i = 0; (i < arrays.size()) && status.ok(); i++) {
+    columns.push_back(arrays[i]->data());
+    status = FinishArray(top.members[i], num_rows, &columns.back());
+  }
+  if (!status.ok()) {
+    // Bitmaps of arrays that were not finished would otherwise keep their bits.
+    for (auto& step : plan_.steps) {
+      step.validity.Reset();
+    }
+    return status;
+  }
+  *out = arrow::RecordBatch::Make(builder_->schema(), num_rows, std::move(columns));
+  return Status::OK();
+}
+
+auto GenericParser::ParseOne(const illex::JSONBuffer* buffer, ParsedBatch* out)
+    -> Status {
+  BOLSON_ROE(sizer_.Reserve(buffer->size()));
+
+  // Batches finished before every malformed JSON, in tolerant mode.
+  std::vector<ParsedBatch> parts;
+  auto cut = [&](size_t num_parsed) -> Status {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    BOLSON_ROE(Flush(static_cast<int64_t>(num_parsed), &batch));
+    parts.emplace_back(batch, buffer->range());
+    return Status::OK();
+  };
+
+  std::vector<illex::Seq> skipped;
+  auto status = ParseNDJSONs(
+      reinterpret_cast<const char*>(buffer->data()), buffer->size(),
+      buffer->range().first, &index_, dead_letters_.get(),
+      [&](IndexCursor* cur) { Interpret(0, cur); }, cut, &skipped);
+  if (!status.ok()) {
+    // Reset the builders, discarding any partially parsed objects.
+    std::shared_ptr<arrow::RecordBatch> discarded;
+    (void)Flush(0, &discarded);
+    return status;
+  }
+  if (parts.empty()) {
+    sizer_.Observe(buffer->size());
+  }
+
+  std::shared_ptr<arrow::RecordBatch> batch;
+  BOLSON_ROE(Flush(-1, &batch));
+  parts.emplace_back(batch, buffer->range());
+
+  BOLSON_ROE(StitchBatches(parts, out));
+  out->seq_range = buffer->range();
+  out->skipped = std::move(skipped);
+  return Status::OK();
+}
+
+auto GenericParser::Parse(const std::vector<illex::JSONBuffer*>& in,
+                          std::vector<ParsedBatch>* out) -> Status {
+  for (auto* buf : in) {
+    ParsedBatch batch;
+    BOLSON_ROE(this->ParseOne(buf, &batch));
+    out->push_back(batch);
+  }
+
+  return Status::OK();
+}
+
+auto GenericParser::Make(const std::shared_ptr<arrow::Schema>& schema,
+                         std::shared_ptr<GenericParser>* out) -> Status {
+  auto result = std::shared_ptr<GenericParser>(new GenericParser());
+  std::shared_ptr<arrow::Schema> output_schema;
+  BOLSON_ROE(WithTimestampFields(*schema, &output_schema));
+  ARROW_ROE(arrow::RecordBatchBuilder::Make(output_schema, arrow::default_memory_pool(),
+                                            &result->builder_));
+  BOLSON_ROE(CompilePlan(*output_schema, result->builder_.get(), &result->plan_));
+  std::vector<arrow::ArrayBuilder*> builders;
+  for (int i = 0; i < result->builder_->num_fields(); i++) {
+    builders.push_back(result->builder_->GetField(i));
+  }
+  result->sizer_ = BuilderSizer(builders);
+  *out = std::move(result);
+  return Status::OK();
+}
+
+auto GenericParserContext::Make(const GenericOptions& opts, size_t num_parsers,
+                                size_t input_size, std::shared_ptr<ParserContext>* out)
+    -> Status {
+  auto result = std::make_shared<GenericParserContext>();
+
+  // Use default allocator.
+  result->allocator_ = std::make_shared<buffer::Allocator>();
+
+  if (opts.schema == nullptr) {
+    BOLSON_ROE(ReadSchemaFromFile(opts.schema_path, &result->input_schema_));
+  } else {
+    result->input_schema_ = opts.schema;
+  }
+
+  // Initialize all parsers. Every parser has its own builders, so it compiles its own
+  // plan.
+  for (size_t i = 0; i < num_parsers; i++) {
+    std::shared_ptr<GenericParser> parser;
+    BOLSON_ROE(GenericParser::Make(result->input_schema_, &parser));
+    result->parsers_.push_back(parser);
+  }
+  result->output_schema_ = result->parsers_.front()->output_schema();
+  SPDLOG_DEBUG("Generic parser plan:\n{}", result->parsers_.front()->plan().ToString());
+
+  // Allocate buffers. Use number of parsers if number of buffers is 0 in options.
+  auto num_buffers = opts.num_buffers == 0 ? num_parsers : opts.num_buffers;
+  BOLSON_ROE(result->AllocateBuffers(num_buffers, DivideCeil(input_size, num_buffers)));
+
+  *out = std::static_pointer_cast<ParserContext>(result);
+
+  return Status::OK();
+}
+
+auto GenericParserContext::parsers() -> std::vector<std::shared_ptr<Parser>> {
+  return CastPtrs<Parser>(parsers_);
+}
+
+auto GenericParserContext::input_schema() const -> std::shared_ptr<arrow::Schema> {
+  return input_schema_;
+}
+
+auto GenericParserContext::output_schema() const -> std::shared_ptr<arrow::Schema> {
+  return output_schema_;
+}
+
+}  // namespace bolson::parse::custom
@@ -0,0 +1,179 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bolson/parse/custom/index.h"
+#include "bolson/parse/custom/members.h"
+#include "bolson/parse/custom/sizer.h"
+#include "bolson/parse/custom/validity.h"
+#include "bolson/parse/parser.h"
+#include "bolson/utils.h"
+
+namespace bolson::parse::custom {
+
+struct GenericOptions {
+  /// Number of input buffers to use, when set to 0, it will be equal to the number of
+  /// threads.
+  size_t num_buffers = 0;
+  /// Arrow schema. If not set, the schema is read from schema_path.
+  std::shared_ptr<arrow::Schema> schema = nullptr;
+  /// Path to Arrow schema. Shared with the Arrow parser input option.
+  std::string schema_path;
+};
+
+/// Operations of a parse plan.
+enum class PlanOp : uint8_t {
+  OBJECT,           ///< Parse an object, appending to a struct builder unless top-level.
+  SCALAR,           ///< Append a scalar value.
+  LIST,             ///< Append a list of scalar values.
+  FIXED_SIZE_LIST,  ///< Append a fixed-size list of scalar values.
+};
+
+/// Kinds of scalar values a parse plan can convert.
+enum class ValueKind : uint8_t { UINT64, INT64, FLOAT64, BOOL, UTF8, TIMESTAMP };
+
+/// A single step of a parse plan.
+struct PlanStep {
+  PlanOp op = PlanOp::OBJECT;
+  /// The kind of the value, or of the list elements.
+  ValueKind kind = ValueKind::UINT64;
+  /// The builder to append to. The list or struct builder for nested types.
+  arrow::ArrayBuilder* builder = nullptr;
+  /// The builder of list elements.
+  arrow::ArrayBuilder* values = nullptr;
+  /// The number of elements of a fixed-size list.
+  int32_t list_size = 0;
+  /// The member key, empty for the top-level object.
+  std::string key;
+  /// Whether the value may be null or absent.
+  bool nullable = false;
+  /// Validity of the values of a nullable step.
+  ValidityBitmap validity;
+  /// The steps of the members of an object, in schema order.
+  std::vector<size_t> members;
+  /// Dispatches the members of an object, which may appear in any order, to their steps.
+  MemberDispatch dispatch;
+};
+
+/**
+ * \brief A parse plan for JSON objects of some Arrow schema.
+ *
+ * The plan holds a step for every value of a JSON object, starting with the top-level
+ * object. Object steps refer to the steps of their members, and steps refer directly to
+ * the Arrow builders the values are appended to.
+ */
+struct ParsePlan {
+  std::vector<PlanStep> steps;
+  /// Whether any step is nullable.
+  bool nullable = false;
+
+  /// \brief Return a human-readable listing of the plan.
+  [[nodiscard]] auto ToString() const -> std::string;
+};
+
+/**
+ * \brief Compile a parse plan for a schema.
+ * \param schema  The Arrow schema of the JSON objects.
+ * \param builder The record batch builder of the schema, which steps will refer to.
+ * \param out     The parse plan.
+ * \return Status::OK() if successful, an error if the schema has unsupported types.
+ */
+auto CompilePlan(const arrow::Schema& schema, arrow::RecordBatchBuilder* builder,
+                 ParsePlan* out) -> Status;
+
+/**
+ * \brief Parser for arbitrary schemas, interpreting a parse plan compiled from it.
+ *
+ * Supports fields of type uint64, int64, float64, bool, utf8 and timestamp[ns], lists
+ * and fixed-size lists of the numeric types, and structs thereof. Timestamps are parsed
+ * from ISO-8601 strings, and top-level utf8 fields tagged with kTimestampMetaKey are
+ * output as timestamps. Object members may appear in any order. Members of nullable
+ * fields may be absent or null, other members are required. List elements may not be
+ * null.
+ */
+class GenericParser : public Parser {
+ public:
+  /// \brief Construct a generic parser for a schema.
+  static auto Make(const std::shared_ptr<arrow::Schema>& schema,
+                   std::shared_ptr<GenericParser>* out) -> Status;
+
+  auto Parse(const std::vector<illex::JSONBuffer*>& in, std::vector<ParsedBatch>* out)
+      -> Status override;
+
+  auto ParseOne(const illex::JSONBuffer* buffer, ParsedBatch* out) -> Status;
+
+  /// \brief Return the schema of the parsed batches.
+  [[nodiscard]] auto output_schema() const -> std::shared_ptr<arrow::Schema> {
+    return builder_->schema();
+  }
+
+  /// \brief Return the parse plan.
+  [[nodiscard]] auto plan() const -> const ParsePlan& { return plan_; }
+
+ private:
+  GenericParser() = default;
+  /// \brief Run a step of the plan over a JSON value, throwing if it is malformed.
+  void Interpret(size_t step, IndexCursor* cur);
+  /// \brief Append a null value for an absent member, or throw if it is required.
+  void AppendAbsent(size_t step);
+  /// \brief Append placeholder values for a step, of which the validity bit is unset.
+  void AppendEmpty(size_t step);
+  /**
+   * \brief Flush the builders, setting the validity bitmaps of nullable steps.
+   * \param num_rows The number of rows to keep, or -1 to keep all of them.
+   * \param out      The flushed batch.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  auto Flush(int64_t num_rows, std::shared_ptr<arrow::RecordBatch>* out) -> Status;
+  /// \brief Cut the arrays of a step and its members to a length, and replace their
+  /// validity bitmaps.
+  auto FinishArray(size_t step, int64_t length, std::shared_ptr<arrow::ArrayData>* data)
+      -> Status;
+
+  std::unique_ptr<arrow::RecordBatchBuilder> builder_;
+  ParsePlan plan_;
+  /// Pre-sizes the builders for every buffer.
+  BuilderSizer sizer_;
+  /// Structural index of the buffer being parsed, reused between buffers.
+  StructuralIndex index_;
+};
+
+class GenericParserContext : public ParserContext {
+ public:
+  static auto Make(const GenericOptions& opts, size_t num_parsers, size_t input_size,
+                   std::shared_ptr<ParserContext>* out) -> Status;
+
+  auto parsers() -> std::vector<std::shared_ptr<Parser>> override;
+
+  [[nodiscard]] auto input_schema() const -> std::shared_ptr<arrow::Schema> override;
+  [[nodiscard]] auto output_schema() const -> std::shared_ptr<arrow::Schema> override;
+  [[nodiscard]] auto SupportsRingBuffers() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsSplitting() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsNuma() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsDeadLetters() const -> bool override { return true; }
+
+ private:
+  std::shared_ptr<arrow::Schema> input_schema_;
+  std::shared_ptr<arrow::Schema> output_schema_;
+  std::vector<std::shared_ptr<GenericParser>> parsers_;
+};
+
+}  // namespace bolson::parse::custom
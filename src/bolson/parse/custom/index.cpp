@@ -0,0 +1,258 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/parse/custom/index.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BOLSON_INDEX_X86
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace bolson::parse::custom {
+
+/// Bitmasks of a block of 64 bytes, one bit per byte.
+struct BlockMasks {
+  uint64_t quote = 0;
+  uint64_t backslash = 0;
+  /// { } [ ] : ,
+  uint64_t structural = 0;
+  uint64_t newline = 0;
+};
+
+static void ClassifyScalar(const char* block, BlockMasks* out) {
+  BlockMasks m;
+  // Most bytes are not classified, so runs of them are skipped at once.
+  const char* end = block + 64;
+  for (const char* p = FindIndexed(block, end); p < end; p = FindIndexed(p + 1, end)) {
+    const uint64_t bit = uint64_t{1} << static_cast<uint64_t>(p - block);
+    switch (*p) {
+      case '"':
+        m.quote |= bit;
+        break;
+      case '\\':
+        m.backslash |= bit;
+        break;
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ':':
+      case ',':
+        m.structural |= bit;
+        break;
+      case '\n':
+        m.newline |= bit;
+        break;
+      default:
+        break;
+    }
+  }
+  *out = m;
+}
+
+#ifdef BOLSON_INDEX_X86
+
+__attribute__((target("sse4.2"))) static void ClassifySSE42(const char* block,
+                                                             BlockMasks* out) {
+  // Explicit-length string compares, such that NUL bytes are not treated as terminators.
+  const __m128i structurals = _mm_setr_epi8('{', '}', '[', ']', ':', ',', 0, 0, 0, 0, 0,
+                                            0, 0, 0, 0, 0);
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i newline = _mm_set1_epi8('\n');
+  BlockMasks m;
+  for (int i = 0; i < 4; i++) {
+    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+    const __m128i s =
+        _mm_cmpestrm(structurals, 6, in, 16,
+                     _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+    const auto shift = static_cast<uint64_t>(16 * i);
+    m.structural |= static_cast<uint64_t>(_mm_cvtsi128_si32(s) & 0xFFFF) << shift;
+    m.quote |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(in, quote)))
+               << shift;
+    m.backslash |=
+        static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(in, backslash))) << shift;
+    m.newline |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(in, newline)))
+                 << shift;
+  }
+  *out = m;
+}
+
+__attribute__((target("avx2"))) static void ClassifyAVX2(const char* block,
+                                                          BlockMasks* out) {
+  const __m256i open_brace = _mm256_set1_epi8('{');
+  const __m256i close_brace = _mm256_set1_epi8('}');
+  const __m256i open_bracket = _mm256_set1_epi8('[');
+  const __m256i close_bracket = _mm256_set1_epi8(']');
+  const __m256i colon = _mm256_set1_epi8(':');
+  const __m256i comma = _mm256_set1_epi8(',');
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i newline = _mm256_set1_epi8('\n');
+  BlockMasks m;
+  for (int i = 0; i < 2; i++) {
+    const __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+    const __m256i braces = _mm256_or_si256(_mm256_cmpeq_epi8(in, open_brace),
+                                           _mm256_cmpeq_epi8(in, close_brace));
+    const __m256i brackets = _mm256_or_si256(_mm256_cmpeq_epi8(in, open_bracket),
+                                             _mm256_cmpeq_epi8(in, close_bracket));
+    const __m256i separators =
+        _mm256_or_si256(_mm256_cmpeq_epi8(in, colon), _mm256_cmpeq_epi8(in, comma));
+    const __m256i s = _mm256_or_si256(_mm256_or_si256(braces, brackets), separators);
+    const auto shift = static_cast<uint64_t>(32 * i);
+    m.structural |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(s)))
+                    << shift;
+    m.quote |= static_cast<uint64_t>(static_cast<uint32_t>(
+                   _mm256_movemask_epi8(_mm256_cmpeq_epi8(in, quote))))
+               << shift;
+    m.backslash |= static_cast<uint64_t>(static_cast<uint32_t>(
+                       _mm256_movemask_epi8(_mm256_cmpeq_epi8(in, backslash))))
+                   << shift;
+    m.newline |= static_cast<uint64_t>(static_cast<uint32_t>(
+                     _mm256_movemask_epi8(_mm256_cmpeq_epi8(in, newline))))
+                 << shift;
+  }
+  *out = m;
+}
+
+#endif
+
+auto ToString(SimdLevel level) -> std::string {
+  switch (level) {
+    case SimdLevel::SCALAR:
+      return "scalar";
+    case SimdLevel::SSE42:
+      return "SSE4.2";
+    case SimdLevel::AVX2:
+      return "AVX2";
+  }
+  return "Corrupt bolson::parse::custom::SimdLevel enum value.";
+}
+
+auto DetectSimdLevel() -> SimdLevel {
+#ifdef BOLSON_INDEX_X86
+  static const SimdLevel result = []() {
+    if (__builtin_cpu_supports("avx2")) {
+      return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+      return SimdLevel::SSE42;
+    }
+    return SimdLevel::SCALAR;
+  }();
+  return result;
+#else
+  return SimdLevel::SCALAR;
+#endif
+}
+
+/**
+ * \brief Return the bytes escaped by a backslash.
+ *
+ * A byte is escaped when it is preceded by an odd-length sequence of backslashes.
+ * Sequences may cross block boundaries, which is tracked through prev_escaped.
+ */
+static inline auto FindEscaped(uint64_t backslash, uint64_t* prev_escaped) -> uint64_t {
+  constexpr uint64_t even_bits = 0x5555555555555555ULL;
+  backslash &= ~*prev_escaped;
+  const uint64_t follows_escape = (backslash << 1) | *prev_escaped;
+  const uint64_t odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+  uint64_t sequences_starting_on_even_bits = 0;
+  *prev_escaped = __builtin_add_overflow(odd_sequence_starts, backslash,
+                                         &sequences_starting_on_even_bits)
+                      ? 1
+                      : 0;
+  const uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+  return (even_bits ^ invert_mask) & follows_escape;
+}
+
+/// \brief Return a mask with every bit set from a set bit up to the next set bit.
+static inline auto PrefixXor(uint64_t x) -> uint64_t {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+auto BuildStructuralIndex(const char* data, size_t size, StructuralIndex* out,
+                          SimdLevel level) -> Status {
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    return Status(Error::GenericError,
+                  "Buffers larger than 4 GiB cannot be indexed by custom parsers.");
+  }
+
+  void (*classify)(const char*, BlockMasks*) = ClassifyScalar;
+#ifdef BOLSON_INDEX_X86
+  if (level == SimdLevel::AVX2) {
+    classify = ClassifyAVX2;
+  } else if (level == SimdLevel::SSE42) {
+    classify = ClassifySSE42;
+  }
+#endif
+
+  // Every byte may be structural in the worst case. Grow the storage per block, such
+  // that its size follows the actual density of structural characters.
+  auto& positions = out->positions;
+  size_t count = 0;
+  uint64_t prev_escaped = 0;
+  uint64_t prev_in_string = 0;
+  char tail[64];
+
+  for (size_t offset = 0; offset < size; offset += 64) {
+    const char* block = data + offset;
+    // Pad the last partial block with whitespace.
+    if (size - offset < 64) {
+      std::memset(tail, ' ', 64);
+      std::memcpy(tail, block, size - offset);
+      block = tail;
+    }
+
+    BlockMasks m;
+    classify(block, &m);
+
+    const uint64_t quote = m.quote & ~FindEscaped(m.backslash, &prev_escaped);
+    // Bytes inside strings, including the opening but excluding the closing quote.
+    const uint64_t in_string = PrefixXor(quote) ^ prev_in_string;
+    prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+    uint64_t structural = ((m.structural | m.newline) & ~in_string) | quote;
+
+    if (count + 64 > positions.size()) {
+      positions.resize(std::max(2 * positions.size(), count + 64));
+    }
+    uint32_t* dst = positions.data() + count;
+    const auto base = static_cast<uint32_t>(offset);
+    while (structural != 0) {
+      *dst++ = base + static_cast<uint32_t>(__builtin_ctzll(structural));
+      structural &= structural - 1;
+    }
+    count = dst - positions.data();
+  }
+
+  out->num_positions = count;
+
+  if (prev_in_string != 0) {
+    return Status(Error::GenericError, "Unterminated string in JSON data.");
+  }
+  return Status::OK();
+}
+
+}  // namespace bolson::parse::custom
@@ -0,0 +1,348 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <spdlog/fmt/fmt.h>
+
+#include <charconv>
+#include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bolson/parse/custom/numbers.h"
+#include "bolson/parse/custom/skip.h"
+#include "bolson/parse/custom/strings.h"
+#include "bolson/parse/iso8601.h"
+#include "bolson/status.h"
+
+namespace bolson::parse::custom {
+
+/// Instruction sets that can be used to build structural indices.
+enum class SimdLevel {
+  SCALAR,  ///< Portable classification, skipping other bytes with SSE2 if available.
+  SSE42,   ///< 16 bytes at a time using SSE4.2 string compares.
+  AVX2     ///< 32 bytes at a time using AVX2 compares.
+};
+
+/// \brief Return a human-readable name of a SIMD level.
+auto ToString(SimdLevel level) -> std::string;
+
+/// \brief Return the widest instruction set supported by the CPU.
+auto DetectSimdLevel() -> SimdLevel;
+
+/**
+ * \brief Positions of the structural characters in a buffer with JSONs.
+ *
+ * Structural characters are { } [ ] : , and newlines outside of strings, and the
+ * opening and closing quotes of strings. Escaped quotes are not structural.
+ */
+struct StructuralIndex {
+  /// Storage of the positions. Only the first num_positions entries are valid.
+  std::vector<uint32_t> positions;
+  /// Number of structural characters.
+  size_t num_positions = 0;
+};
+
+/**
+ * \brief Build the structural index of a buffer.
+ *
+ * The buffer is classified 64 bytes at a time into quote, backslash, structural and
+ * newline bitmasks using the widest available instruction set. Escaped quotes are
+ * removed from the quote mask, and a prefix XOR over the remaining quotes yields the
+ * bytes inside strings, which are removed from the structural mask.
+ *
+ * \param data  The JSON data.
+ * \param size  The size of the data in bytes. At most 4 GiB.
+ * \param out   The structural index. Its storage is reused between calls.
+ * \param level The instruction set to use.
+ * \return Status::OK() if successful, some error otherwise.
+ */
+auto BuildStructuralIndex(const char* data, size_t size, StructuralIndex* out,
+                          SimdLevel level = DetectSimdLevel()) -> Status;
+
+/**
+ * \brief Walks over the structural characters of an indexed buffer.
+ *
+ * Scalar values are the bytes between two consecutive structural characters, with
+ * surrounding whitespace removed. Other bytes between structural characters must be
+ * whitespace, which is checked when consuming the next structural character. Like the
+ * Eat* functions, methods throw on unexpected input.
+ */
+class IndexCursor {
+ public:
+  IndexCursor(const char* data, size_t size, const StructuralIndex& index)
+      : data_(data),
+        size_(size),
+        pos_(index.positions.data()),
+        end_(index.positions.data() + index.num_positions) {}
+
+  /// \brief Return true if all structural characters were consumed.
+  [[nodiscard]] inline auto done() const -> bool { return pos_ == end_; }
+
+  /// \brief Return the next structural character.
+  [[nodiscard]] inline auto peek() const -> char { return data_[*pos_]; }
+
+  /// \brief Return the offset of the first byte after the last consumed character.
+  [[nodiscard]] inline auto offset() const -> uint32_t {
+    return static_cast<uint32_t>(prev_ + 1);
+  }
+
+  /// \brief Skip all structural characters before an offset.
+  inline void SkipTo(uint32_t offset) {
+    while (!done() && (*pos_ < offset)) {
+      pos_++;
+    }
+    prev_ = offset - 1;
+    value_ = false;
+  }
+
+  /// \brief Consume structural character c.
+  inline void Expect(char c) {
+    if (done()) {
+      throw std::runtime_error(
+          fmt::format("Expected '{}', encountered end of JSON data", c));
+    }
+    if (peek() != c) {
+      throw std::runtime_error(fmt::format("Expected '{}', encountered '{}'", c, peek()));
+    }
+    // Bytes that were not consumed as a value must be whitespace.
+    if (!value_) {
+      const char* gap = data_ + *pos_;
+      const char* p = SkipWhitespace(data_ + static_cast<uint32_t>(prev_ + 1), gap);
+      if (p != gap) {
+        throw std::runtime_error(fmt::format("Expected '{}', encountered '{}'", c, *p));
+      }
+    }
+    value_ = false;
+    prev_ = *pos_;
+    pos_++;
+  }
+
+  /// \brief Consume a string, returning its raw contents, i.e. with any escapes.
+  inline auto String() -> std::string_view {
+    Expect('"');
+    auto first = prev_ + 1;
+    value_ = true;
+    Expect('"');
+    return {data_ + first, prev_ - first};
+  }
+
+  /**
+   * \brief Consume a string, returning its unescaped contents.
+   *
+   * Strings without escapes are returned without copying. Other strings are unescaped
+   * into storage of the cursor, which is valid until the next call.
+   */
+  inline auto UnescapedString() -> std::string_view { return Unescape(String()); }
+
+  /**
+   * \brief Unescape the raw contents of a string, as returned by String().
+   *
+   * Like UnescapedString(), the result is only copied if the string has escapes.
+   */
+  inline auto Unescape(std::string_view raw) -> std::string_view {
+    const char* last = raw.data() + raw.size();
+    if (FindQuoteOrBackslash(raw.data(), last) == last) {
+      return raw;
+    }
+    UnescapeString(raw, &scratch_);
+    return scratch_;
+  }
+
+  /// \brief Consume an ISO-8601 timestamp string, returning nanoseconds since the epoch.
+  inline auto Timestamp() -> int64_t { return ParseISO8601(UnescapedString()); }
+
+  /// \brief Consume a member key and the key-value separator.
+  inline void Key(std::string_view key) {
+    auto k = String();
+    if ((k != key) && (Unescape(k) != key)) {
+      throw std::runtime_error(
+          fmt::format("Expected \"{}\", encountered \"{}\"", key, k));
+    }
+    Expect(':');
+  }
+
+  /**
+   * \brief Return the scalar value before the next structural character.
+   *
+   * The value is consumed along with the next structural character.
+   */
+  inline auto Value() const -> std::string_view {
+    value_ = true;
+    const char* first = data_ + static_cast<uint32_t>(prev_ + 1);
+    const char* last = done() ? data_ + size_ : data_ + *pos_;
+    first = SkipWhitespace(first, last);
+    while ((last > first) && IsWhitespace(*(last - 1))) {
+      last--;
+    }
+    return {first, static_cast<size_t>(last - first)};
+  }
+
+  /**
+   * \brief Return true if the next value is the null literal.
+   *
+   * Like other scalar values, a null value is not consumed.
+   */
+  [[nodiscard]] inline auto Null() const -> bool {
+    if (!done() && (peek() != ',') && (peek() != '}') && (peek() != ']')) {
+      return false;
+    }
+    return Value() == "null";
+  }
+
+  /// \brief Return the scalar value before the next structural character as uint64.
+  inline auto UInt64() const -> uint64_t {
+    auto v = Value();
+    const char* p = v.data();
+    auto result = ParseUInt64Digits(&p, data_ + size_);
+    if (p != v.data() + v.size()) {
+      throw std::runtime_error("Cannot parse value as primitive: " + std::string(v));
+    }
+    return result;
+  }
+
+  /// \brief Return the scalar value before the next structural character as int64.
+  inline auto Int64() const -> int64_t {
+    auto v = Value();
+    int64_t result = 0;
+    auto fc_result = std::from_chars(v.data(), v.data() + v.size(), result);
+    if ((fc_result.ec == std::errc::invalid_argument) ||
+        (fc_result.ptr != v.data() + v.size())) {
+      throw std::runtime_error("Cannot parse value as primitive: " + std::string(v));
+    }
+    if (fc_result.ec == std::errc::result_out_of_range) {
+      throw std::runtime_error("Value out of range:" + std::string(v));
+    }
+    return result;
+  }
+
+  /// \brief Return the scalar value before the next structural character as double.
+  inline auto Double() const -> double {
+    auto v = Value();
+    // The value is followed by a structural character, so strtod cannot run past it.
+    char* last = nullptr;
+    double result = std::strtod(v.data(), &last);
+    if (v.empty() || (last != v.data() + v.size())) {
+      throw std::runtime_error("Cannot parse value as primitive: " + std::string(v));
+    }
+    return result;
+  }
+
+  /// \brief Return the scalar value before the next structural character as bool.
+  inline auto Bool() const -> bool {
+    auto v = Value();
+    if (v == "true") {
+      return true;
+    }
+    if (v == "false") {
+      return false;
+    }
+    throw std::runtime_error("Cannot parse value as bool: " + std::string(v));
+  }
+
+  /**
+   * \brief Consume an array of scalar values.
+   * \param element Called for every element, to parse it through one of the scalar
+   *                value functions.
+   * \return The number of elements in the array.
+   */
+  template <typename Element>
+  inline auto Array(Element&& element) -> size_t {
+    Expect('[');
+    if ((!done()) && (peek() == ']') && Value().empty()) {
+      Expect(']');
+      return 0;
+    }
+    size_t count = 0;
+    while (true) {
+      element();
+      count++;
+      if (!done() && (peek() == ',')) {
+        Expect(',');
+      } else {
+        Expect(']');
+        return count;
+      }
+    }
+  }
+
+  /**
+   * \brief Consume an array of uint64 values, parsing runs of values at once.
+   *
+   * The elements of an array of numbers are only separated by commas, so the closing
+   * bracket is found in the index, after which all values in between are parsed by
+   * ParseUInt64Run without going through the cursor for every value.
+   *
+   * \param append Called with runs of values: (const uint64_t* values, size_t count).
+   * \return The number of elements in the array.
+   */
+  template <typename AppendRun>
+  inline auto UInt64Runs(AppendRun&& append) -> size_t {
+    Expect('[');
+    const uint32_t* close = pos_;
+    while ((close != end_) && (data_[*close] == ',')) {
+      close++;
+    }
+    const char* p = data_ + static_cast<uint32_t>(prev_ + 1);
+    pos_ = close;
+    value_ = true;
+    Expect(']');
+    const char* last = data_ + prev_;
+
+    p = SkipWhitespace(p, last);
+    uint64_t run[kUInt64RunSize];
+    size_t count = 0;
+    while (p != last) {
+      auto n = ParseUInt64Run(&p, last, data_ + size_, run, kUInt64RunSize);
+      append(run, n);
+      count += n;
+    }
+    return count;
+  }
+
+  /**
+   * \brief Consume an array of uint64 values.
+   * \param append Called with every value in the array.
+   */
+  template <typename Append>
+  inline void UInt64Array(Append&& append) {
+    UInt64Runs([&](const uint64_t* values, size_t count) {
+      for (size_t i = 0; i < count; i++) {
+        append(values[i]);
+      }
+    });
+  }
+
+ private:
+  /// The JSON data.
+  const char* data_;
+  /// The size of the JSON data.
+  size_t size_;
+  /// The next structural character.
+  const uint32_t* pos_;
+  /// One past the last structural character.
+  const uint32_t* end_;
+  /// Position of the last consumed structural character, or one before the data.
+  uint32_t prev_ = static_cast<uint32_t>(-1);
+  /// Whether the bytes before the next structural character were taken as a value.
+  mutable bool value_ = false;
+  /// Storage for unescaped strings.
+  std::string scratch_;
+};
+
+}  // namespace bolson::parse::custom
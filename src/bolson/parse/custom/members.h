@@ -0,0 +1,230 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bolson/parse/custom/index.h"
+#include "bolson/status.h"
+
+namespace bolson::parse::custom {
+
+/// \brief Hash a member key, FNV-1a with a seed.
+inline auto HashKey(uint32_t seed, std::string_view key) -> uint32_t {
+  uint32_t h = 2166136261U ^ seed;
+  for (char c : key) {
+    h = (h ^ static_cast<uint8_t>(c)) * 16777619U;
+  }
+  return h;
+}
+
+/**
+ * \brief A perfect hash table of the member keys of a JSON object.
+ *
+ * A seed is searched for such that all keys hash to different slots, so a lookup takes
+ * a single hash and key comparison.
+ */
+class KeyTable {
+ public:
+  KeyTable() = default;
+
+  /// \brief Build a table for a set of keys, returning an error on duplicate keys.
+  static auto Make(std::vector<std::string> keys, KeyTable* out) -> Status {
+    auto sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    auto dup = std::adjacent_find(sorted.begin(), sorted.end());
+    if (dup != sorted.end()) {
+      return Status(Error::GenericError, "Duplicate member key \"" + *dup + "\"");
+    }
+    KeyTable result;
+    result.keys_ = std::move(keys);
+    // Start at twice the number of keys. Every doubling makes collisions less likely.
+    uint32_t num_slots = 2;
+    while (num_slots < 2 * result.keys_.size()) {
+      num_slots *= 2;
+    }
+    for (; num_slots <= kMaxSlots; num_slots *= 2) {
+      result.mask_ = num_slots - 1;
+      for (uint32_t seed = 0; seed < kSeedsPerSize; seed++) {
+        result.seed_ = seed;
+        if (result.Fill(num_slots)) {
+          *out = std::move(result);
+          return Status::OK();
+        }
+      }
+    }
+    return Status(Error::GenericError, "Unable to build perfect hash table for keys.");
+  }
+
+  /// \brief Return the index of a key, or the number of keys if it is no key.
+  [[nodiscard]] inline auto Find(std::string_view key) const -> size_t {
+    uint32_t k = slots_[HashKey(seed_, key) & mask_];
+    if ((k == kEmpty) || (keys_[k] != key)) {
+      return keys_.size();
+    }
+    return k;
+  }
+
+  /// \brief Return the key with some index.
+  [[nodiscard]] inline auto key(size_t i) const -> std::string_view { return keys_[i]; }
+
+  /// \brief Return the number of keys.
+  [[nodiscard]] inline auto size() const -> size_t { return keys_.size(); }
+
+ private:
+  static constexpr uint32_t kEmpty = static_cast<uint32_t>(-1);
+  static constexpr uint32_t kMaxSlots = 1U << 20U;
+  static constexpr uint32_t kSeedsPerSize = 1024;
+
+  /// \brief Fill the slots with the current seed, returning false on a collision.
+  auto Fill(uint32_t num_slots) -> bool {
+    slots_.assign(num_slots, kEmpty);
+    for (size_t i = 0; i < keys_.size(); i++) {
+      auto& slot = slots_[HashKey(seed_, keys_[i]) & mask_];
+      if (slot != kEmpty) {
+        return false;
+      }
+      slot = static_cast<uint32_t>(i);
+    }
+    return true;
+  }
+
+  std::vector<std::string> keys_;
+  std::vector<uint32_t> slots_;
+  uint32_t seed_ = 0;
+  uint32_t mask_ = 0;
+};
+
+/**
+ * \brief Parses the members of JSON objects with a fixed set of keys, in any order.
+ *
+ * The members of an object are speculated to appear in the order of the previous
+ * object, which starts out as the order of the keys. A key that matches the speculated
+ * one costs a single comparison. On a miss, the member is found through the perfect hash
+ * of all keys, and the order is updated, such that producers with another but consistent
+ * order only miss on their first object. Duplicate members are rejected.
+ */
+class MemberDispatch {
+ public:
+  MemberDispatch() = default;
+
+  /// \brief Construct a member dispatcher for the keys of an object.
+  static auto Make(std::vector<std::string> keys, MemberDispatch* out) -> Status {
+    MemberDispatch result;
+    BOLSON_ROE(KeyTable::Make(std::move(keys), &result.keys_));
+    result.order_.resize(result.keys_.size());
+    std::iota(result.order_.begin(), result.order_.end(), 0);
+    result.seen_.resize(result.keys_.size(), 0);
+    // A backslash in a key must be escaped in JSON, so the raw keys of such an object
+    // never match. Its keys are always unescaped.
+    for (size_t k = 0; k < result.keys_.size(); k++) {
+      result.escaped_keys_ |= result.keys_.key(k).find('\\') != std::string_view::npos;
+    }
+    *out = std::move(result);
+    return Status::OK();
+  }
+
+  /**
+   * \brief Consume an object.
+   * \param cur    The cursor, at the opening brace of the object.
+   * \param member Called with the index of the key of every member, to consume its
+   *               value: (size_t index).
+   * \param absent Called with the index of every key without member, after the object
+   *               was consumed: (size_t index).
+   */
+  template <typename Member, typename Absent>
+  inline void Object(IndexCursor* cur, Member&& member, Absent&& absent) {
+    cur->Expect('{');
+    object_++;
+    size_t i = 0;
+    if ((cur->done()) || (cur->peek() != '}') || !cur->Value().empty()) {
+      while (true) {
+        auto key = cur->String();
+        cur->Expect(':');
+        size_t m = i < order_.size() ? order_[i] : keys_.size();
+        if ((m == keys_.size()) || (key != keys_.key(m)) || escaped_keys_) {
+          // Keys may have escapes, e.g. "v\u0069n", so they are unescaped before the
+          // lookup.
+          key = cur->Unescape(key);
+          m = Miss(key, i);
+        }
+        // A malformed object may have left the order with duplicates, so always check.
+        if (seen_[m] == object_) {
+          throw std::runtime_error(fmt::format("Duplicate member \"{}\"", key));
+        }
+        seen_[m] = object_;
+        member(m);
+        i++;
+        if (cur->done() || (cur->peek() != ',')) {
+          break;
+        }
+        cur->Expect(',');
+      }
+    }
+    cur->Expect('}');
+    if (i != keys_.size()) {
+      for (size_t m = 0; m < keys_.size(); m++) {
+        if (seen_[m] != object_) {
+          absent(m);
+        }
+      }
+    }
+  }
+
+  /// \brief Consume an object of which all members are required.
+  template <typename Member>
+  inline void Object(IndexCursor* cur, Member&& member) {
+    Object(cur, std::forward<Member>(member), [&](size_t m) {
+      throw std::runtime_error(fmt::format("Missing member \"{}\"", keys_.key(m)));
+    });
+  }
+
+  /// \brief Return the keys.
+  [[nodiscard]] auto keys() const -> const KeyTable& { return keys_; }
+
+ private:
+  /// \brief Look up a key that was not speculated, updating the order.
+  auto Miss(std::string_view key, size_t i) -> size_t {
+    size_t m = keys_.Find(key);
+    if (m == keys_.size()) {
+      throw std::runtime_error(fmt::format("Unexpected member \"{}\"", key));
+    }
+    if (i < order_.size()) {
+      order_[i] = static_cast<uint32_t>(m);
+    }
+    return m;
+  }
+
+  KeyTable keys_;
+  /// Speculated key index of every member.
+  std::vector<uint32_t> order_;
+  /// Number of the last object in which every key was seen.
+  std::vector<uint64_t> seen_;
+  /// Number of the current object.
+  uint64_t object_ = 0;
+  /// Whether any key has a backslash, which is escaped in the raw keys.
+  bool escaped_keys_ = false;
+};
+
+}  // namespace bolson::parse::custom
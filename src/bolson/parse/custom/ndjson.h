@@ -0,0 +1,134 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <illex/protocol.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "bolson/parse/custom/index.h"
+#include "bolson/parse/dead_letter.h"
+#include "bolson/status.h"
+
+namespace bolson::parse::custom {
+
+/// \brief Return true if a line leaves a string open, i.e. has an odd number of quotes.
+inline auto HasOpenString(const char* line, size_t length) -> bool {
+  bool open = false;
+  bool escaped = false;
+  for (size_t i = 0; i < length; i++) {
+    if (escaped) {
+      escaped = false;
+    } else if (line[i] == '\\') {
+      escaped = true;
+    } else if (line[i] == '"') {
+      open = !open;
+    }
+  }
+  return open;
+}
+
+/**
+ * \brief Parse all newline-separated JSON objects of a buffer.
+ *
+ * The buffer is indexed, after which parse is called for every object. Without
+ * dead-letter sink, a malformed object fails the whole buffer.
+ *
+ * With a dead-letter sink, a malformed object is sent to the sink with its sequence
+ * number, and parsing resumes at the next newline. The exception thrown for it is only
+ * caught on this cold path; valid objects are parsed exactly as without sink. Because
+ * the builders may hold part of the malformed object, cut is called first to finish
+ * the builders, keeping only the objects parsed since the previous cut.
+ *
+ * \param data         The JSON data.
+ * \param size         The size of the JSON data.
+ * \param first_seq    The sequence number of the first JSON.
+ * \param index        The structural index, reused between buffers.
+ * \param dead_letters The dead-letter sink, or nullptr.
+ * \param parse        Parses one object at an IndexCursor*, throwing on malformed input.
+ * \param cut          Finishes the builders, keeping the first N objects: (size_t N).
+ * \param skipped      The sequence number of every malformed object is appended to this.
+ * \return Status::OK() if successful, some error otherwise.
+ */
+template <typename Parse, typename Cut>
+auto ParseNDJSONs(const char* data, size_t size, illex::Seq first_seq,
+                  StructuralIndex* index, DeadLetterSink* dead_letters, Parse&& parse,
+                  Cut&& cut, std::vector<illex::Seq>* skipped) -> Status {
+  // Index all structural characters in a vectorized first pass. In tolerant mode, an
+  // unterminated string is handled as any other malformed object.
+  auto status = BuildStructuralIndex(data, size, index);
+  if (!status.ok() && ((dead_letters == nullptr) || (index->num_positions == 0))) {
+    return status;
+  }
+  IndexCursor cur(data, size, *index);
+
+  if (dead_letters == nullptr) {
+    try {
+      while (!cur.done()) {
+        parse(&cur);
+        // The newline may be missing after the last object.
+        if (!cur.done()) {
+          cur.Expect('\n');
+        }
+      }
+    } catch (const std::runtime_error& e) {
+      return Status(Error::GenericError,
+                    std::string("Unable to parse JSONs: ") + e.what());
+    }
+    return Status::OK();
+  }
+
+  illex::Seq seq = first_seq;
+  size_t num_parsed = 0;
+  while (!cur.done()) {
+    const size_t start = cur.offset();
+    try {
+      parse(&cur);
+      if (!cur.done()) {
+        cur.Expect('\n');
+      }
+      num_parsed++;
+    } catch (const std::runtime_error& e) {
+      BOLSON_ROE(cut(num_parsed));
+      num_parsed = 0;
+
+      // An object ends at the first newline, as strings cannot contain raw newlines.
+      const char* line = data + start;
+      const auto* newline =
+          static_cast<const char*>(std::memchr(line, '\n', size - start));
+      const size_t length = newline == nullptr ? size - start : newline - line;
+      dead_letters->Push(seq, {line, length}, e.what());
+      skipped->push_back(seq);
+
+      const size_t next = std::min(start + length + 1, size);
+      if (HasOpenString(line, length)) {
+        // The quotes of the rest of the buffer were paired up wrongly, so re-index it.
+        data += next;
+        size -= next;
+        (void)BuildStructuralIndex(data, size, index);
+        cur = IndexCursor(data, size, *index);
+      } else {
+        cur.SkipTo(static_cast<uint32_t>(next));
+      }
+    }
+    seq++;
+  }
+  return Status::OK();
+}
+
+}  // namespace bolson::parse::custom
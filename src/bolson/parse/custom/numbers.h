@@ -0,0 +1,178 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <spdlog/fmt/fmt.h>
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace bolson::parse::custom {
+
+/// Maximum number of values parsed by ParseUInt64Run before they are appended.
+constexpr size_t kUInt64RunSize = 32;
+
+/// \brief Parse a uint64 with std::from_chars, throwing if [first, last) is no uint64.
+inline auto ParseUInt64Chars(const char* first, const char* last) -> uint64_t {
+  uint64_t result = 0;
+  auto fc_result = std::from_chars(first, last, result);
+  if ((fc_result.ec == std::errc::invalid_argument) || (fc_result.ptr != last)) {
+    throw std::runtime_error("Cannot parse value as primitive: " +
+                             std::string(first, last));
+  }
+  if (fc_result.ec == std::errc::result_out_of_range) {
+    throw std::runtime_error("Value out of range:" + std::string(first, last));
+  }
+  return result;
+}
+
+namespace detail {
+
+/// Eight ASCII zeroes.
+constexpr uint64_t kZeroes = 0x3030303030303030ULL;
+
+/// Powers of ten up to 10^8.
+constexpr uint64_t kPow10[] = {1,       10,       100,       1000,     10000,
+                               100000,  1000000,  10000000,  100000000};
+
+inline auto Load8(const char* pos) -> uint64_t {
+  uint64_t result;
+  std::memcpy(&result, pos, sizeof(result));
+  return result;
+}
+
+/// \brief Return the number of leading digits of eight little-endian characters.
+inline auto NumDigits8(uint64_t chunk) -> size_t {
+  // Digits become 0-9. Adding 0x76 sets the high bit of larger bytes, and bytes that
+  // had their high bit set already are caught by the or. A carry out of a non-digit
+  // may only flag later bytes, so the lowest flagged byte is exact.
+  uint64_t c = chunk ^ kZeroes;
+  uint64_t non_digits = ((c + 0x7676767676767676ULL) | c) & 0x8080808080808080ULL;
+  if (non_digits == 0) {
+    return 8;
+  }
+  return static_cast<size_t>(__builtin_ctzll(non_digits)) / 8;
+}
+
+/// \brief Convert eight little-endian ASCII digits to their value.
+inline auto Convert8(uint64_t chunk) -> uint64_t {
+  // Combine pairs of digits, then pairs of pairs, then pairs of quadruples.
+  chunk -= kZeroes;
+  chunk = (chunk * 10) + (chunk >> 8);
+  chunk = (((chunk & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+           (((chunk >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >>
+          32;
+  return chunk;
+}
+
+}  // namespace detail
+
+/**
+ * \brief Parse the digits at *pos as uint64, advancing *pos past them.
+ *
+ * Up to sixteen digits are converted eight at a time with SWAR (SIMD within a
+ * register) arithmetic, any further digits one at a time with overflow checks.
+ *
+ * \param pos The position of the first digit, advanced past the last digit.
+ * \param end The end of the readable data. Eight-byte loads never cross it.
+ * \return The value.
+ */
+inline auto ParseUInt64Digits(const char** pos, const char* end) -> uint64_t {
+  const char* first = *pos;
+  const char* p = first;
+  uint64_t result = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (p + 8 <= end) {
+    uint64_t chunk = detail::Load8(p);
+    size_t n = detail::NumDigits8(chunk);
+    if (n == 0) {
+      break;
+    }
+    if (n < 8) {
+      // Shift the digits to the most significant bytes, behind leading zeroes.
+      chunk = (chunk << (8 * (8 - n))) | (detail::kZeroes >> (8 * n));
+    }
+    result = result * detail::kPow10[n] + detail::Convert8(chunk);
+    p += n;
+    if ((n < 8) || (p - first >= 16)) {
+      break;
+    }
+  }
+#endif
+  // Digits near the end of the data, or beyond the first sixteen.
+  bool overflow = false;
+  while ((p < end) && (static_cast<unsigned char>(*p - '0') < 10)) {
+    overflow |= __builtin_mul_overflow(result, 10, &result);
+    overflow |= __builtin_add_overflow(result, static_cast<uint64_t>(*p - '0'), &result);
+    p++;
+  }
+  if (p == first) {
+    if (p == end) {
+      throw std::runtime_error("Cannot parse value as uint64, encountered end of data");
+    }
+    throw std::runtime_error(
+        fmt::format("Cannot parse value as uint64, encountered '{}'", *p));
+  }
+  if (overflow) {
+    throw std::runtime_error("Value out of range:" + std::string(first, p));
+  }
+  *pos = p;
+  return result;
+}
+
+/**
+ * \brief Parse a run of comma-separated uint64 values, e.g. the elements of an array.
+ *
+ * \param pos  The position of the first value, advanced past the parsed values. It is
+ *             equal to last when all values were parsed, and points after a comma
+ *             otherwise.
+ * \param last The end of the values.
+ * \param end  The end of the readable data.
+ * \param out  Values output.
+ * \param max  The maximum number of values to parse.
+ * \return The number of values parsed.
+ */
+inline auto ParseUInt64Run(const char** pos, const char* last, const char* end,
+                           uint64_t* out, size_t max) -> size_t {
+  auto is_space = [](char c) { return (c == ' ') || (c == '\t') || (c == '\r'); };
+  const char* p = *pos;
+  size_t count = 0;
+  while (count < max) {
+    while ((p < last) && is_space(*p)) {
+      p++;
+    }
+    out[count++] = ParseUInt64Digits(&p, end);
+    while ((p < last) && is_space(*p)) {
+      p++;
+    }
+    if (p >= last) {
+      break;
+    }
+    if (*p != ',') {
+      throw std::runtime_error(fmt::format("Expected ',', encountered '{}'", *p));
+    }
+    p++;
+    if (p == last) {
+      throw std::runtime_error("Expected value after ','");
+    }
+  }
+  *pos = p;
+  return count;
+}
+
+}  // namespace bolson::parse::custom
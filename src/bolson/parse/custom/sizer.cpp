@@ -0,0 +1,87 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/parse/custom/sizer.h"
+
+#include <arrow/api.h>
+
+#include <cmath>
+
+namespace bolson::parse::custom {
+
+/// Weight of the latest buffer in the running estimates.
+static constexpr double kWeight = 0.25;
+/// Reserve slightly more than expected, as buffers with a few more rows are common.
+static constexpr double kHeadroom = 1.125;
+
+static auto Blend(double estimate, double observed, bool first) -> double {
+  return first ? observed : estimate + kWeight * (observed - estimate);
+}
+
+BuilderSizer::BuilderSizer(const std::vector<arrow::ArrayBuilder*>& builders) {
+  for (auto* b : builders) {
+    Track(b);
+  }
+}
+
+void BuilderSizer::Track(arrow::ArrayBuilder* builder) {
+  Entry entry;
+  entry.builder = builder;
+  auto id = builder->type()->id();
+  if ((id == arrow::Type::STRING) || (id == arrow::Type::BINARY)) {
+    entry.binary = static_cast<arrow::BinaryBuilder*>(builder);
+  }
+  entries_.push_back(entry);
+  for (int i = 0; i < builder->num_children(); i++) {
+    Track(builder->child(i));
+  }
+}
+
+auto BuilderSizer::Reserve(size_t bytes) -> Status {
+  if ((rows_per_byte_ == 0.0) || entries_.empty()) {
+    return Status::OK();
+  }
+  double rows = rows_per_byte_ * static_cast<double>(bytes) * kHeadroom;
+  for (auto& e : entries_) {
+    auto elements = static_cast<int64_t>(std::ceil(rows * e.elements_per_row));
+    ARROW_ROE(e.builder->Reserve(elements));
+    if (e.binary != nullptr) {
+      auto data = static_cast<int64_t>(std::ceil(rows * e.data_per_row));
+      ARROW_ROE(e.binary->ReserveData(data));
+    }
+  }
+  return Status::OK();
+}
+
+void BuilderSizer::Observe(size_t bytes) {
+  if (entries_.empty() || (bytes == 0)) {
+    return;
+  }
+  auto rows = static_cast<double>(entries_.front().builder->length());
+  if (rows == 0.0) {
+    return;
+  }
+  bool first = rows_per_byte_ == 0.0;
+  rows_per_byte_ = Blend(rows_per_byte_, rows / static_cast<double>(bytes), first);
+  for (auto& e : entries_) {
+    auto elements = static_cast<double>(e.builder->length());
+    e.elements_per_row = Blend(e.elements_per_row, elements / rows, first);
+    if (e.binary != nullptr) {
+      auto data = static_cast<double>(e.binary->value_data_length());
+      e.data_per_row = Blend(e.data_per_row, data / rows, first);
+    }
+  }
+}
+
+}  // namespace bolson::parse::custom
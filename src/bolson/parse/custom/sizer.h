@@ -0,0 +1,71 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+
+#include <vector>
+
+#include "bolson/status.h"
+
+namespace bolson::parse::custom {
+
+/**
+ * \brief Pre-sizes Arrow builders from statistics of previously parsed buffers.
+ *
+ * The sizer keeps running estimates of the number of rows per input byte, and of the
+ * number of elements per row of every builder, including the children of list and
+ * struct builders, and the number of value bytes per row of string builders. Before a
+ * buffer is parsed, capacity for its expected contents is reserved in all builders,
+ * so they are not grown while parsing. The builders must outlive the sizer.
+ */
+class BuilderSizer {
+ public:
+  BuilderSizer() = default;
+
+  /// \brief Track a set of builders. The first one determines the number of rows.
+  explicit BuilderSizer(const std::vector<arrow::ArrayBuilder*>& builders);
+
+  /// \brief Reserve capacity in all builders for a buffer of some size in bytes.
+  auto Reserve(size_t bytes) -> Status;
+
+  /**
+   * \brief Update the estimates from the contents of the builders.
+   *
+   * Must be called after a buffer of some size was parsed, before finishing the
+   * builders.
+   */
+  void Observe(size_t bytes);
+
+ private:
+  /// Statistics of a single builder.
+  struct Entry {
+    arrow::ArrayBuilder* builder = nullptr;
+    /// The builder as binary builder, if it holds variable-length values.
+    arrow::BinaryBuilder* binary = nullptr;
+    /// Estimated number of elements per row.
+    double elements_per_row = 0.0;
+    /// Estimated number of value bytes per row.
+    double data_per_row = 0.0;
+  };
+
+  void Track(arrow::ArrayBuilder* builder);
+
+  std::vector<Entry> entries_;
+  /// Estimated number of rows per input byte, zero until the first observation.
+  double rows_per_byte_ = 0.0;
+};
+
+}  // namespace bolson::parse::custom
@@ -0,0 +1,159 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// SSE2 is part of the x86-64 baseline, so no runtime dispatch is required.
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define BOLSON_SKIP_SSE2
+#endif
+
+#include <cstdint>
+#include <initializer_list>
+
+namespace bolson::parse::custom {
+
+/// \brief Return true if c is JSON whitespace, i.e. space, tab, line feed or return.
+inline auto IsWhitespace(char c) -> bool {
+  return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+}
+
+/// \brief Return true if c is classified by the structural index: { } [ ] : , a quote,
+/// a backslash or a line feed.
+inline auto IsIndexed(char c) -> bool {
+  switch (c) {
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+    case '"':
+    case '\\':
+    case '\n':
+      return true;
+    default:
+      return false;
+  }
+}
+
+#ifdef BOLSON_SKIP_SSE2
+namespace detail {
+
+inline auto WhitespaceMask(__m128i v) -> uint32_t {
+  const __m128i ws = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+  return static_cast<uint32_t>(_mm_movemask_epi8(ws));
+}
+
+inline auto IndexedMask(__m128i v) -> uint32_t {
+  __m128i s = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+  for (char c : {'{', '}', '[', ']', ':', ',', '\\', '\n'}) {
+    s = _mm_or_si128(s, _mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+  }
+  return static_cast<uint32_t>(_mm_movemask_epi8(s));
+}
+
+}  // namespace detail
+#endif
+
+/**
+ * \brief Skip a run of whitespace.
+ *
+ * Most runs are empty or a single space, so the first byte is checked on its own before
+ * any longer run is skipped 16 bytes at a time.
+ *
+ * \param pos The first character.
+ * \param end The end of the data. Loads never cross it.
+ * \return The first non-whitespace character, or end.
+ */
+inline auto SkipWhitespace(const char* pos, const char* end) -> const char* {
+  if ((pos >= end) || !IsWhitespace(*pos)) {
+    return pos;
+  }
+  pos++;
+#ifdef BOLSON_SKIP_SSE2
+  while (pos + 16 <= end) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+    const uint32_t other = ~detail::WhitespaceMask(v) & 0xFFFFU;
+    if (other != 0) {
+      return pos + __builtin_ctz(other);
+    }
+    pos += 16;
+  }
+#endif
+  while ((pos < end) && IsWhitespace(*pos)) {
+    pos++;
+  }
+  return pos;
+}
+
+/**
+ * \brief Find the next character classified by the structural index.
+ *
+ * Escapes and strings are not taken into account; that is left to the index.
+ *
+ * \param pos The first character.
+ * \param end The end of the data. Loads never cross it.
+ * \return The first character for which IsIndexed holds, or end.
+ */
+inline auto FindIndexed(const char* pos, const char* end) -> const char* {
+#ifdef BOLSON_SKIP_SSE2
+  while (pos + 16 <= end) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+    const uint32_t mask = detail::IndexedMask(v);
+    if (mask != 0) {
+      return pos + __builtin_ctz(mask);
+    }
+    pos += 16;
+  }
+#endif
+  while ((pos < end) && !IsIndexed(*pos)) {
+    pos++;
+  }
+  return pos;
+}
+
+/**
+ * \brief Find the last newline of [begin, end), scanning backwards 16 bytes at a time.
+ * \return The last newline, or nullptr if there is none.
+ */
+inline auto FindLastNewline(const char* begin, const char* end) -> const char* {
+  const char* pos = end;
+#ifdef BOLSON_SKIP_SSE2
+  const __m128i newline = _mm_set1_epi8('\n');
+  while (pos - begin >= 16) {
+    pos -= 16;
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+    const auto mask =
+        static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)));
+    if (mask != 0) {
+      return pos + (31 - __builtin_clz(mask));
+    }
+  }
+#endif
+  while (pos > begin) {
+    pos--;
+    if (*pos == '\n') {
+      return pos;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace bolson::parse::custom
@@ -0,0 +1,172 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <spdlog/fmt/fmt.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "bolson/parse/custom/skip.h"
+
+namespace bolson::parse::custom {
+
+/**
+ * \brief Find the next quote or backslash, 16 bytes at a time.
+ * \param pos The first character.
+ * \param end The end of the data. Loads never cross it.
+ * \return The first quote or backslash, or end.
+ */
+inline auto FindQuoteOrBackslash(const char* pos, const char* end) -> const char* {
+#ifdef BOLSON_SKIP_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  while (pos + 16 <= end) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+    const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash))));
+    if (mask != 0) {
+      return pos + __builtin_ctz(mask);
+    }
+    pos += 16;
+  }
+#endif
+  while ((pos < end) && (*pos != '"') && (*pos != '\\')) {
+    pos++;
+  }
+  return pos;
+}
+
+namespace detail {
+
+/// \brief Parse the four hex digits of a \u escape.
+inline auto Hex4(const char* pos, const char* end) -> uint32_t {
+  if (end - pos < 4) {
+    throw std::runtime_error("Unexpected end of string in \\u escape");
+  }
+  uint32_t result = 0;
+  for (int i = 0; i < 4; i++) {
+    const char c = pos[i];
+    uint32_t digit;
+    if ((c >= '0') && (c <= '9')) {
+      digit = c - '0';
+    } else if ((c >= 'a') && (c <= 'f')) {
+      digit = c - 'a' + 10;
+    } else if ((c >= 'A') && (c <= 'F')) {
+      digit = c - 'A' + 10;
+    } else {
+      throw std::runtime_error(fmt::format("Invalid hex digit '{}' in \\u escape", c));
+    }
+    result = (result << 4U) | digit;
+  }
+  return result;
+}
+
+/// \brief Append a code point as UTF-8.
+inline void AppendUTF8(uint32_t cp, std::string* out) {
+  if (cp < 0x80) {
+    out->push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out->push_back(static_cast<char>(0xC0 | (cp >> 6U)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3FU)));
+  } else if (cp < 0x10000) {
+    out->push_back(static_cast<char>(0xE0 | (cp >> 12U)));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 6U) & 0x3FU)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3FU)));
+  } else {
+    out->push_back(static_cast<char>(0xF0 | (cp >> 18U)));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 12U) & 0x3FU)));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 6U) & 0x3FU)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3FU)));
+  }
+}
+
+}  // namespace detail
+
+/**
+ * \brief Unescape the raw contents of a JSON string.
+ *
+ * Runs without escapes are copied at once. \u escapes are converted to UTF-8, where
+ * surrogate pairs are combined. Throws on invalid escapes.
+ *
+ * \param raw The contents of the string between its quotes.
+ * \param out The unescaped string. Cleared first.
+ */
+inline void UnescapeString(std::string_view raw, std::string* out) {
+  out->clear();
+  const char* pos = raw.data();
+  const char* end = raw.data() + raw.size();
+  while (true) {
+    const char* esc = FindQuoteOrBackslash(pos, end);
+    out->append(pos, esc);
+    if (esc == end) {
+      return;
+    }
+    if (*esc == '"') {
+      throw std::runtime_error("Unescaped quote in string");
+    }
+    if (esc + 1 == end) {
+      throw std::runtime_error("Unexpected end of string after backslash");
+    }
+    pos = esc + 2;
+    switch (esc[1]) {
+      case '"':
+      case '\\':
+      case '/':
+        out->push_back(esc[1]);
+        break;
+      case 'b':
+        out->push_back('\b');
+        break;
+      case 'f':
+        out->push_back('\f');
+        break;
+      case 'n':
+        out->push_back('\n');
+        break;
+      case 'r':
+        out->push_back('\r');
+        break;
+      case 't':
+        out->push_back('\t');
+        break;
+      case 'u': {
+        uint32_t cp = detail::Hex4(pos, end);
+        pos += 4;
+        if ((cp >= 0xD800) && (cp < 0xDC00)) {
+          if ((end - pos < 2) || (pos[0] != '\\') || (pos[1] != 'u')) {
+            throw std::runtime_error("Expected low surrogate after high surrogate");
+          }
+          uint32_t low = detail::Hex4(pos + 2, end);
+          if ((low < 0xDC00) || (low >= 0xE000)) {
+            throw std::runtime_error("Expected low surrogate after high surrogate");
+          }
+          pos += 6;
+          cp = 0x10000 + ((cp - 0xD800) << 10U) + (low - 0xDC00);
+        } else if ((cp >= 0xDC00) && (cp < 0xE000)) {
+          throw std::runtime_error("Unexpected low surrogate");
+        }
+        detail::AppendUTF8(cp, out);
+        break;
+      }
+      default:
+        throw std::runtime_error(fmt::format("Invalid escape '\\{}'", esc[1]));
+    }
+  }
+}
+
+}  // namespace bolson::parse::custom
@@ -22,7 +22,8 @@
 
 #include "bolson/latency.h"
 #include "bolson/log.h"
-#include "bolson/parse/custom/common.h"
+#include "bolson/parse/custom/index.h"
+#include "bolson/parse/custom/ndjson.h"
 #include "bolson/parse/parser.h"
 
 namespace bolson::parse::custom {
@@ -81,94 +82,131 @@ static auto schema_trip() -> std::shared_ptr<arrow::Schema> {
   return result;
 }
 
-auto TripParser::ParseOne(const illex::JSONBuffer* buffer, ParsedBatch* out) -> Status {
-  const auto* pos = reinterpret_cast<const char*>(buffer->data());
-  const auto* end = pos + buffer->size();
+/// \brief Return the trip schema with timestamps as nanoseconds since the epoch.
+static auto schema_trip_ns() -> std::shared_ptr<arrow::Schema> {
+  static auto type = arrow::timestamp(arrow::TimeUnit::NANO, "UTC");
+  static auto result =
+      schema_trip()->SetField(0, arrow::field("timestamp", type, false)).ValueOrDie();
+  return result;
+}
+
+static inline void UInt64FixedSizeArray(IndexCursor* cur,
+                                        arrow::FixedSizeListBuilder* list_builder) {
+  auto* values_builder =
+      reinterpret_cast<arrow::UInt64Builder*>(list_builder->value_builder());
+  ARROW_TOE(list_builder->Append());
+  cur->UInt64Runs([&](const uint64_t* values, size_t count) {
+    ARROW_TOE(values_builder->AppendValues(values, static_cast<int64_t>(count)));
+  });
+}
+
+/// \brief Consume the value of a member, given the index of its field in the schema.
+static inline void TripMember(IndexCursor* cur, TripBuilder* b, size_t field) {
+  switch (field) {
+    case 0:
+      if (b->timestamp_ns != nullptr) {
+        ARROW_TOE(b->timestamp_ns->Append(cur->Timestamp()));
+      } else {
+        ARROW_TOE(b->timestamp->Append(cur->UnescapedString()));
+      }
+      break;
+    case 1:
+      ARROW_TOE(b->timezone->Append(cur->UInt64()));
+      break;
+    case 2:
+      ARROW_TOE(b->vin->Append(cur->UInt64()));
+      break;
+    case 3:
+      ARROW_TOE(b->odometer->Append(cur->UInt64()));
+      break;
+    case 4:
+      ARROW_TOE(b->hypermiling->Append(cur->Bool()));
+      break;
+    case 5:
+      ARROW_TOE(b->avgspeed->Append(cur->UInt64()));
+      break;
+    case 6:
+      UInt64FixedSizeArray(cur, b->sec_in_band.get());
+      break;
+    case 7:
+      UInt64FixedSizeArray(cur, b->miles_in_time_range.get());
+      break;
+    case 8:
+      UInt64FixedSizeArray(cur, b->const_speed_miles_in_band.get());
+      break;
+    case 9:
+      UInt64FixedSizeArray(cur, b->vary_speed_miles_in_band.get());
+      break;
+    case 10:
+      UInt64FixedSizeArray(cur, b->sec_decel.get());
+      break;
+    case 11:
+      UInt64FixedSizeArray(cur, b->sec_accel.get());
+      break;
+    case 12:
+      UInt64FixedSizeArray(cur, b->braking.get());
+      break;
+    case 13:
+      UInt64FixedSizeArray(cur, b->accel.get());
+      break;
+    case 14:
+      ARROW_TOE(b->orientation->Append(cur->Bool()));
+      break;
+    case 15:
+      UInt64FixedSizeArray(cur, b->small_speed_var.get());
+      break;
+    case 16:
+      UInt64FixedSizeArray(cur, b->large_speed_var.get());
+      break;
+    case 17:
+      ARROW_TOE(b->accel_decel->Append(cur->UInt64()));
+      break;
+    case 18:
+      ARROW_TOE(b->speed_changes->Append(cur->UInt64()));
+      break;
+    default:
+      throw std::runtime_error("Corrupt trip field index.");
+  }
+}
 
-  // Eat any initial whitespace.
-  pos = EatWhitespace(pos, end);
+auto TripParser::ParseOne(const illex::JSONBuffer* buffer, ParsedBatch* out) -> Status {
+  // Reserve capacity for the expected number of trip reports.
+  BOLSON_ROE(sizer_.Reserve(buffer->size()));
 
-  // Start parsing objects
-  while ((pos < end) && (pos != nullptr)) {
+  auto parse = [&](IndexCursor* cur) {
     SPDLOG_DEBUG("Builder status:\n{}", builder.ToString());
-    pos = EatObjectStart(pos, end);  // {
-    pos = EatWhitespace(pos, end);
-
-    pos = EatMemberKey(pos, end, "timestamp");
-    pos = EatWhitespace(pos, end);
-    pos = EatMemberKeyValueSeperator(pos, end);
-    pos = EatWhitespace(pos, end);
-    pos = EatStringWithoutEscapes(pos, end, builder.timestamp.get());
-    pos = EatWhitespace(pos, end);
-    pos = EatChar(pos, end, ',');
-
-    pos = EatUInt64Member(pos, end, "timezone", builder.timezone.get(), true);
-    pos = EatUInt64Member(pos, end, "vin", builder.vin.get(), true);
-    pos = EatUInt64Member(pos, end, "odometer", builder.odometer.get(), true);
-    pos = EatBoolMember(pos, end, "hypermiling", builder.hypermiling.get(), true);
-    pos = EatUInt64Member(pos, end, "avgspeed", builder.avgspeed.get(), true);
-
-    // todo: make macros
-    pos = EatUInt64FixedSizeArrayMember(
-        pos, end, "sec_in_band", builder.sec_in_band.get(),
-        reinterpret_cast<arrow::UInt64Builder*>(builder.sec_in_band->value_builder()),
-        true);
-    pos = EatUInt64FixedSizeArrayMember(pos, end, "miles_in_time_range",
-                                        builder.miles_in_time_range.get(),
-                                        reinterpret_cast<arrow::UInt64Builder*>(
-                                            builder.miles_in_time_range->value_builder()),
-                                        true);
-    pos = EatUInt64FixedSizeArrayMember(
-        pos, end, "const_speed_miles_in_band", builder.const_speed_miles_in_band.get(),
-        reinterpret_cast<arrow::UInt64Builder*>(
-            builder.const_speed_miles_in_band->value_builder()),
-        true);
-    pos = EatUInt64FixedSizeArrayMember(
-        pos, end, "vary_speed_miles_in_band", builder.vary_speed_miles_in_band.get(),
-        reinterpret_cast<arrow::UInt64Builder*>(
-            builder.vary_speed_miles_in_band->value_builder()),
-        true);
-    pos = EatUInt64FixedSizeArrayMember(
-        pos, end, "sec_decel", builder.sec_decel.get(),
-        reinterpret_cast<arrow::UInt64Builder*>(builder.sec_decel->value_builder()),
-        true);
-    pos = EatUInt64FixedSizeArrayMember(
-        pos, end, "sec_accel", builder.sec_accel.get(),
-        reinterpret_cast<arrow::UInt64Builder*>(builder.sec_accel->value_builder()),
-        true);
-    pos = EatUInt64FixedSizeArrayMember(
-        pos, end, "braking", builder.braking.get(),
-        reinterpret_cast<arrow::UInt64Builder*>(builder.braking->value_builder()), true);
-    pos = EatUInt64FixedSizeArrayMember(
-        pos, end, "accel", builder.accel.get(),
-        reinterpret_cast<arrow::UInt64Builder*>(builder.accel->value_builder()), true);
-    pos = EatBoolMember(pos, end, "orientation", builder.orientation.get(), true);
-    pos = EatUInt64FixedSizeArrayMember(
-        pos, end, "small_speed_var", builder.small_speed_var.get(),
-        reinterpret_cast<arrow::UInt64Builder*>(builder.small_speed_var->value_builder()),
-        true);
-    pos = EatUInt64FixedSizeArrayMember(
-        pos, end, "large_speed_var", builder.large_speed_var.get(),
-        reinterpret_cast<arrow::UInt64Builder*>(builder.large_speed_var->value_builder()),
-        true);
-
-    pos = EatUInt64Member(pos, end, "accel_decel", builder.accel_decel.get(), true);
-    pos = EatUInt64Member(pos, end, "speed_changes", builder.speed_changes.get(), false);
-
-    pos = EatWhitespace(pos, end);
-    pos = EatObjectEnd(pos, end);  // }
-    pos = EatWhitespace(pos, end);
-    pos = EatChar(pos, end, '\n');
-
-    // The newline may be the last byte, check if we didn't reach end of input before
-    // continuing.
-    if ((pos < end) && (pos != nullptr)) {
-      pos = EatWhitespace(pos, end);
-    }
+    members_.Object(cur, [&](size_t field) { TripMember(cur, &builder, field); });
+  };
+
+  // Batches finished before every malformed JSON, in tolerant mode.
+  std::vector<ParsedBatch> parts;
+  auto cut = [&](size_t num_parsed) -> Status {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    BOLSON_ROE(builder.Finish(static_cast<int64_t>(num_parsed), &batch));
+    parts.emplace_back(batch, buffer->range());
+    return Status::OK();
+  };
+
+  std::vector<illex::Seq> skipped;
+  auto status = ParseNDJSONs(reinterpret_cast<const char*>(buffer->data()),
+                             buffer->size(), buffer->range().first, &index_,
+                             dead_letters_.get(), parse, cut, &skipped);
+  if (!status.ok()) {
+    // Reset the builders, discarding any partially parsed objects.
+    std::shared_ptr<arrow::RecordBatch> discarded;
+    (void)builder.Finish(0, &discarded);
+    return status;
+  }
+  if (parts.empty()) {
+    sizer_.Observe(buffer->size());
   }
+  std::shared_ptr<arrow::RecordBatch> batch;
+  BOLSON_ROE(builder.Finish(-1, &batch));
+  parts.emplace_back(batch, buffer->range());
 
+  BOLSON_ROE(StitchBatches(parts, out));
   out->seq_range = buffer->range();
-  out->batch = builder.Finish();
+  out->skipped = std::move(skipped);
   return Status::OK();
 }
 
@@ -193,11 +231,41 @@ auto TripParser::input_schema() -> std::shared_ptr<arrow::Schema> {
   return result;
 }
 auto TripParser::output_schema() const -> std::shared_ptr<arrow::Schema> {
-  return schema_trip();
+  return builder.timestamp_ns != nullptr ? schema_trip_ns() : schema_trip();
 }
 
-TripParser::TripParser(size_t pre_alloc_records, size_t pre_alloc_timestamp_values)
-    : builder(TripBuilder(pre_alloc_records, pre_alloc_timestamp_values)) {}
+TripParser::TripParser(bool convert_timestamps)
+    : builder(convert_timestamps), sizer_(builder.builders()) {}
+
+auto TripParser::Make(bool convert_timestamps, std::shared_ptr<TripParser>* out)
+    -> Status {
+  auto result = std::shared_ptr<TripParser>(new TripParser(convert_timestamps));
+  BOLSON_ROE(MemberDispatch::Make(schema_trip()->field_names(), &result->members_));
+  *out = std::move(result);
+  return Status::OK();
+}
+
+auto TripBuilder::builders() const -> std::vector<arrow::ArrayBuilder*> {
+  return {timestamp_builder(),
+          timezone.get(),
+          vin.get(),
+          odometer.get(),
+          hypermiling.get(),
+          avgspeed.get(),
+          sec_in_band.get(),
+          miles_in_time_range.get(),
+          const_speed_miles_in_band.get(),
+          vary_speed_miles_in_band.get(),
+          sec_decel.get(),
+          sec_accel.get(),
+          braking.get(),
+          accel.get(),
+          orientation.get(),
+          small_speed_var.get(),
+          large_speed_var.get(),
+          accel_decel.get(),
+          speed_changes.get()};
+}
 
 auto TripParserContext::Make(const TripOptions& opts, size_t num_parsers,
                              size_t input_size, std::shared_ptr<ParserContext>* out)
@@ -209,8 +277,9 @@ auto TripParserContext::Make(const TripOptions& opts, size_t num_parsers,
 
   // Initialize all parsers.
   for (size_t i = 0; i < num_parsers; i++) {
-    result->parsers_.push_back(std::make_shared<TripParser>(
-        opts.pre_alloc_records, opts.pre_alloc_timestamp_values));
+    std::shared_ptr<TripParser> parser;
+    BOLSON_ROE(TripParser::Make(opts.timestamp_ns, &parser));
+    result->parsers_.push_back(parser);
   }
 
   // Allocate buffers. Use number of parsers if number of buffers is 0 in options.
@@ -233,8 +302,13 @@ auto TripParserContext::output_schema() const -> std::shared_ptr<arrow::Schema>
   return parsers_.front()->output_schema();
 }
 
-TripBuilder::TripBuilder(int64_t pre_alloc_rows, int64_t pre_alloc_ts_values)
+TripBuilder::TripBuilder(bool convert_timestamps)
     : timestamp(std::make_shared<arrow::StringBuilder>()),
+      timestamp_ns(convert_timestamps
+                       ? std::make_shared<arrow::TimestampBuilder>(
+                             arrow::timestamp(arrow::TimeUnit::NANO, "UTC"),
+                             arrow::default_memory_pool())
+                       : nullptr),
       timezone(std::make_shared<arrow::UInt64Builder>()),
       vin(std::make_shared<arrow::UInt64Builder>()),
       odometer(std::make_shared<arrow::UInt64Builder>()),
@@ -262,63 +336,45 @@ TripBuilder::TripBuilder(int64_t pre_alloc_rows, int64_t pre_alloc_ts_values)
       large_speed_var(std::make_shared<arrow::FixedSizeListBuilder>(
           arrow::default_memory_pool(), std::make_shared<arrow::UInt64Builder>(), 13)),
       accel_decel(std::make_shared<arrow::UInt64Builder>()),
-      speed_changes(std::make_shared<arrow::UInt64Builder>()) {
-  //  timestamp->Reserve(pre_alloc_rows);
-  //  timestamp->ReserveData(pre_alloc_ts_values);
-  //  timezone->Reserve(pre_alloc_rows);
-  //  vin->Reserve(pre_alloc_rows);
-  //  odometer->Reserve(pre_alloc_rows);
-  //  hypermiling->Reserve(pre_alloc_rows);
-  //  avgspeed->Reserve(pre_alloc_rows);
-  //  sec_in_band->value_builder()->Reserve(pre_alloc_rows * 12);
-  //  miles_in_time_range->value_builder()->Reserve(pre_alloc_rows * 24);
-  //  const_speed_miles_in_band->value_builder()->Reserve(pre_alloc_rows * 12);
-  //  vary_speed_miles_in_band->value_builder()->Reserve(pre_alloc_rows * 12);
-  //  sec_decel->value_builder()->Reserve(pre_alloc_rows * 10);
-  //  sec_accel->value_builder()->Reserve(pre_alloc_rows * 10);
-  //  braking->value_builder()->Reserve(pre_alloc_rows * 6);
-  //  accel->value_builder()->Reserve(pre_alloc_rows * 6);
-  //  orientation->Reserve(pre_alloc_rows);
-  //  small_speed_var->value_builder()->Reserve(pre_alloc_rows * 13);
-  //  large_speed_var->value_builder()->Reserve(pre_alloc_rows * 13);
-  //  accel_decel->Reserve(pre_alloc_rows);
-  //  speed_changes->Reserve(pre_alloc_rows);
-}
+      speed_changes(std::make_shared<arrow::UInt64Builder>()) {}
 
-auto TripBuilder::Finish() -> std::shared_ptr<arrow::RecordBatch> {
-  std::vector<std::shared_ptr<arrow::Array>> arrays = {
-      timestamp->Finish().ValueOrDie(),
-      timezone->Finish().ValueOrDie(),
-      vin->Finish().ValueOrDie(),
-      odometer->Finish().ValueOrDie(),
-      hypermiling->Finish().ValueOrDie(),
-      avgspeed->Finish().ValueOrDie(),
-      sec_in_band->Finish().ValueOrDie(),
-      miles_in_time_range->Finish().ValueOrDie(),
-      const_speed_miles_in_band->Finish().ValueOrDie(),
-      vary_speed_miles_in_band->Finish().ValueOrDie(),
-      sec_decel->Finish().ValueOrDie(),
-      sec_accel->Finish().ValueOrDie(),
-      braking->Finish().ValueOrDie(),
-      accel->Finish().ValueOrDie(),
-      orientation->Finish().ValueOrDie(),
-      small_speed_var->Finish().ValueOrDie(),
-      large_speed_var->Finish().ValueOrDie(),
-      accel_decel->Finish().ValueOrDie(),
-      speed_changes->Finish().ValueOrDie()};
-
-  auto result = arrow::RecordBatch::Make(schema_trip(), arrays[0]->length(), arrays);
-  assert(result != nullptr);
+auto TripBuilder::Finish(int64_t num_rows, std::shared_ptr<arrow::RecordBatch>* out)
+    -> Status {
+  // Finish every builder, also after an error, so all of them are reset. A malformed
+  // trip may have left values in some of the builders but not in others, so the arrays
+  // are cut to the number of rows.
+  auto builders = this->builders();
+  std::vector<std::shared_ptr<arrow::Array>> arrays(builders.size());
+  arrow::Status status;
+  for (size_t i = 0; i < builders.size(); i++) {
+    status &= builders[i]->Finish(&arrays[i]);
+  }
+  ARROW_ROE(status);
+  if (num_rows < 0) {
+    num_rows = arrays[0]->length();
+  }
+  for (auto& array : arrays) {
+    if (array->length() < num_rows) {
+      return Status(Error::GenericError, "Trip builder holds fewer values than rows.");
+    }
+    if (array->length() > num_rows) {
+      array = array->Slice(0, num_rows);
+    }
+  }
 
-  return result;
+  auto schema = timestamp_ns != nullptr ? schema_trip_ns() : schema_trip();
+  *out = arrow::RecordBatch::Make(schema, num_rows, arrays);
+  return Status::OK();
 }
 
 auto TripBuilder::ToString() -> std::string {
   std::stringstream ss;
-  ss << "timestamp                 : " << timestamp->length() << "/"
-     << timestamp->capacity() << "\n";
-  ss << "- values                  : " << timestamp->value_data_length() << "/"
-     << timestamp->value_data_capacity() << "\n";
+  ss << "timestamp                 : " << timestamp_builder()->length() << "/"
+     << timestamp_builder()->capacity() << "\n";
+  if (timestamp_ns == nullptr) {
+    ss << "- values                  : " << timestamp->value_data_length() << "/"
+       << timestamp->value_data_capacity() << "\n";
+  }
   ss << "timezone                  : " << timezone->length() << "/"
      << timezone->capacity() << "\n";
   ss << "vin                       : " << vin->length() << "/" << vin->capacity() << "\n";
@@ -380,14 +436,10 @@ auto TripBuilder::ToString() -> std::string {
 }
 
 void AddTripOptionsToCLI(CLI::App* sub, TripOptions* out) {
-  sub->add_option("--custom-trip-pre-alloc-records", out->pre_alloc_records,
-                  "Pre-allocate this many records.")
-      ->default_val(1024);
-  sub->add_option("--custom-trip-pre-alloc-timestamp-values",
-                  out->pre_alloc_timestamp_values,
-                  "Pre-allocate this many values in the string values buffer for the "
-                  "timestamp field.")
-      ->default_val(1024 * 10);
+  sub->add_flag("--custom-trip-timestamp-ns", out->timestamp_ns,
+                "Convert trip report timestamps to timestamp(ns, UTC) instead of keeping "
+                "them as strings.")
+      ->default_val(false);
 }
 
 }  // namespace bolson::parse::custom
@@ -21,6 +21,9 @@
 #include <memory>
 #include <utility>
 
+#include "bolson/parse/custom/index.h"
+#include "bolson/parse/custom/members.h"
+#include "bolson/parse/custom/sizer.h"
 #include "bolson/parse/parser.h"
 #include "bolson/utils.h"
 
@@ -30,19 +33,36 @@ struct TripOptions {
   /// Number of input buffers to use, when set to 0, it will be equal to the number of
   /// threads.
   size_t num_buffers = 0;
-
-  size_t pre_alloc_records = 0;
-  size_t pre_alloc_timestamp_values = 0;
+  /// Whether to convert timestamps to timestamp(ns, UTC) rather than keeping strings.
+  bool timestamp_ns = false;
 };
 
+/// \brief Add the custom trip parser options to a CLI subcommand.
 void AddTripOptionsToCLI(CLI::App* sub, TripOptions* out);
 
 struct TripBuilder {
-  explicit TripBuilder(int64_t pre_alloc_rows = 0, int64_t pre_alloc_ts_values = 0);
+  explicit TripBuilder(bool convert_timestamps = false);
+
+  /**
+   * \brief Finish the builders into a batch, and reset them.
+   * \param num_rows The number of rows to keep, or -1 to keep all of them.
+   * \param out      The finished batch.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  auto Finish(int64_t num_rows, std::shared_ptr<arrow::RecordBatch>* out) -> Status;
 
-  auto Finish() -> std::shared_ptr<arrow::RecordBatch>;
+  /// \brief Return all top-level builders, in schema order.
+  [[nodiscard]] auto builders() const -> std::vector<arrow::ArrayBuilder*>;
+
+  /// \brief Return the builder of the timestamp column in use.
+  [[nodiscard]] auto timestamp_builder() const -> arrow::ArrayBuilder* {
+    return timestamp_ns != nullptr ? static_cast<arrow::ArrayBuilder*>(timestamp_ns.get())
+                                   : timestamp.get();
+  }
 
   std::shared_ptr<arrow::StringBuilder> timestamp;
+  /// Builder of converted timestamps, or nullptr if timestamps are kept as strings.
+  std::shared_ptr<arrow::TimestampBuilder> timestamp_ns;
   std::shared_ptr<arrow::UInt64Builder> timezone;
   std::shared_ptr<arrow::UInt64Builder> vin;
   std::shared_ptr<arrow::UInt64Builder> odometer;
@@ -67,7 +87,13 @@ struct TripBuilder {
 
 class TripParser : public Parser {
  public:
-  TripParser(size_t pre_alloc_records, size_t pre_alloc_timestamp_values);
+  /**
+   * \brief Make a new trip parser.
+   * \param convert_timestamps Whether to convert timestamps to timestamp(ns, UTC).
+   * \param out                The parser.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  static auto Make(bool convert_timestamps, std::shared_ptr<TripParser>* out) -> Status;
 
   auto Parse(const std::vector<illex::JSONBuffer*>& in, std::vector<ParsedBatch>* out)
       -> Status override;
@@ -78,7 +104,15 @@ class TripParser : public Parser {
   [[nodiscard]] auto output_schema() const -> std::shared_ptr<arrow::Schema>;
 
  private:
+  explicit TripParser(bool convert_timestamps);
+
   TripBuilder builder;
+  /// Structural index of the buffer being parsed, reused between buffers.
+  StructuralIndex index_;
+  /// Pre-sizes the builders for every buffer.
+  BuilderSizer sizer_;
+  /// Dispatches members, which may appear in any order, to their builders.
+  MemberDispatch members_;
 };
 
 class TripParserContext : public ParserContext {
@@ -90,6 +124,10 @@ class TripParserContext : public ParserContext {
 
   [[nodiscard]] auto input_schema() const -> std::shared_ptr<arrow::Schema> override;
   [[nodiscard]] auto output_schema() const -> std::shared_ptr<arrow::Schema> override;
+  [[nodiscard]] auto SupportsRingBuffers() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsSplitting() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsNuma() const -> bool override { return true; }
+  [[nodiscard]] auto SupportsDeadLetters() const -> bool override { return true; }
 
  private:
   std::vector<std::shared_ptr<TripParser>> parsers_;
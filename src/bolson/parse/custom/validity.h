@@ -0,0 +1,115 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "bolson/status.h"
+
+namespace bolson::parse::custom {
+
+/**
+ * \brief Builds an Arrow validity bitmap a 64-bit word at a time.
+ *
+ * Bits are shifted into a word in a register, which is stored once it is full, so
+ * appending a bit never touches memory otherwise. Builders of nullable columns append
+ * placeholder values for nulls, after which their validity bitmap is replaced by this
+ * one.
+ */
+class ValidityBitmap {
+ public:
+  /// \brief Append the validity bit of a value.
+  inline void Append(bool valid) {
+    word_ |= static_cast<uint64_t>(valid) << bit_;
+    if (++bit_ == 64) {
+      words_.push_back(word_);
+      word_ = 0;
+      bit_ = 0;
+    }
+  }
+
+  /// \brief Return the number of appended bits.
+  [[nodiscard]] inline auto length() const -> int64_t {
+    return static_cast<int64_t>(64 * words_.size() + bit_);
+  }
+
+  /**
+   * \brief Finish the first bits of the bitmap, and reset it.
+   * \param length     The number of bits to finish. Any further bits are discarded.
+   * \param out        The bitmap, or nullptr if all bits are set.
+   * \param null_count The number of unset bits.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  auto Finish(int64_t length, std::shared_ptr<arrow::Buffer>* out, int64_t* null_count)
+      -> Status {
+    if (length > this->length()) {
+      return Status(Error::GenericError, "Validity bitmap is shorter than its array.");
+    }
+    words_.push_back(word_);
+    // Count set bits a word at a time, masking the bits beyond the length.
+    const auto full = static_cast<size_t>(length / 64);
+    int64_t num_valid = 0;
+    for (size_t w = 0; w < full; w++) {
+      num_valid += __builtin_popcountll(words_[w]);
+    }
+    if (length % 64 != 0) {
+      words_[full] &= (uint64_t{1} << static_cast<uint64_t>(length % 64)) - 1;
+      num_valid += __builtin_popcountll(words_[full]);
+    }
+    *null_count = length - num_valid;
+    *out = nullptr;
+    if (*null_count > 0) {
+      const int64_t num_bytes = (length + 7) / 8;
+      auto result = arrow::AllocateBuffer(num_bytes);
+      if (!result.ok()) {
+        return Status(Error::ArrowError, result.status().message());
+      }
+      std::shared_ptr<arrow::Buffer> buffer = std::move(result).ValueOrDie();
+      uint8_t* dst = buffer->mutable_data();
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      std::memcpy(dst, words_.data(), num_bytes);
+#else
+      for (int64_t b = 0; b < num_bytes; b++) {
+        dst[b] = static_cast<uint8_t>(words_[b / 8] >> (8 * (b % 8)));
+      }
+#endif
+      *out = std::move(buffer);
+    }
+    Reset();
+    return Status::OK();
+  }
+
+  /// \brief Discard all bits.
+  inline void Reset() {
+    words_.clear();
+    word_ = 0;
+    bit_ = 0;
+  }
+
+ private:
+  /// Full words.
+  std::vector<uint64_t> words_;
+  /// The word being filled.
+  uint64_t word_ = 0;
+  /// The number of bits in the word being filled.
+  uint32_t bit_ = 0;
+};
+
+}  // namespace bolson::parse::custom
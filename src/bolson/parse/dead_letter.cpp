@@ -0,0 +1,83 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/parse/dead_letter.h"
+
+#include <algorithm>
+
+#include "bolson/log.h"
+
+namespace bolson::parse {
+
+void AddDeadLetterOptionsToCLI(CLI::App* sub, DeadLetterOptions* out) {
+  sub->add_flag("--tolerant", out->tolerant,
+                "Skip malformed JSONs instead of failing. Supported by CPU parsers.")
+      ->default_val(false);
+  sub->add_option("--dead-letter", out->file,
+                  "Append JSONs skipped by --tolerant to this file, as tab-separated "
+                  "sequence number, error and JSON. Implies --tolerant.");
+}
+
+auto DeadLetterSink::Make(const DeadLetterOptions& opts,
+                          std::shared_ptr<DeadLetterSink>* out) -> Status {
+  auto result = std::shared_ptr<DeadLetterSink>(new DeadLetterSink());
+  result->queue_size_ = opts.queue_size;
+  if (!opts.file.empty()) {
+    result->file_.open(opts.file, std::ios::app);
+    if (!result->file_.good()) {
+      return Status(Error::IOError, "Unable to open dead-letter file " + opts.file);
+    }
+  }
+  *out = result;
+  return Status::OK();
+}
+
+void DeadLetterSink::Push(illex::Seq seq, std::string_view json,
+                          std::string_view error) {
+  count_++;
+  SPDLOG_DEBUG("Skipping JSON {}: {}", seq, error);
+
+  if (file_.is_open()) {
+    // Errors may quote the offending character, which must not break up the line.
+    std::string err(error);
+    std::replace_if(
+        err.begin(), err.end(), [](char c) { return (c == '\n') || (c == '\t'); }, ' ');
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    file_ << seq << '\t' << err << '\t' << json << '\n';
+  } else if (queue_.size_approx() < queue_size_) {
+    queue_.enqueue(DeadLetter{seq, std::string(json), std::string(error)});
+  }
+}
+
+auto DeadLetterSink::TryPop(DeadLetter* out) -> bool { return queue_.try_dequeue(*out); }
+
+void LogDeadLetters(DeadLetterSink* sink) {
+  if (sink->count() == 0) {
+    return;
+  }
+  spdlog::warn("Skipped {} malformed JSON(s).", sink->count());
+  size_t num_logged = 0;
+  DeadLetter letter;
+  while (sink->TryPop(&letter)) {
+    spdlog::warn("  JSON {}: {}: {}", letter.seq, letter.error, letter.json);
+    num_logged++;
+  }
+  // Without a file, dead letters beyond the size of the queue are only counted.
+  if ((num_logged > 0) && (num_logged < sink->count())) {
+    spdlog::warn("  ... {} more not shown, use --dead-letter to keep all of them.",
+                 sink->count() - num_logged);
+  }
+}
+
+}  // namespace bolson::parse
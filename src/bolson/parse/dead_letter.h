@@ -0,0 +1,94 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <concurrentqueue.h>
+#include <illex/protocol.h>
+
+#include <CLI/CLI.hpp>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "bolson/status.h"
+
+namespace bolson::parse {
+
+/// Default maximum number of dead letters held in memory when not writing to a file.
+#define BOLSON_DEAD_LETTER_QUEUE_SIZE 1024
+
+/// Options for tolerant parsing.
+struct DeadLetterOptions {
+  /// Whether to skip malformed JSONs rather than failing on them.
+  bool tolerant = false;
+  /// File to append skipped JSONs to. When empty, they are held in a bounded queue and
+  /// logged when the stream ends.
+  std::string file;
+  /// Maximum number of dead letters held in memory when not writing to a file.
+  size_t queue_size = BOLSON_DEAD_LETTER_QUEUE_SIZE;
+};
+
+/// \brief Add the tolerant parsing options to a CLI subcommand.
+void AddDeadLetterOptionsToCLI(CLI::App* sub, DeadLetterOptions* out);
+
+/// A JSON that could not be parsed.
+struct DeadLetter {
+  /// Sequence number of the JSON.
+  illex::Seq seq = 0;
+  /// The raw JSON, without its newline.
+  std::string json;
+  /// Why it could not be parsed.
+  std::string error;
+};
+
+/**
+ * \brief A sink for JSONs that could not be parsed.
+ *
+ * Dead letters are appended to a file as tab-separated sequence number, error and raw
+ * JSON, or held in a bounded queue. When the queue is full, further dead letters are
+ * only counted. The sink may be shared by all parsers.
+ */
+class DeadLetterSink {
+ public:
+  static auto Make(const DeadLetterOptions& opts, std::shared_ptr<DeadLetterSink>* out)
+      -> Status;
+
+  /// \brief Push a JSON that could not be parsed.
+  void Push(illex::Seq seq, std::string_view json, std::string_view error);
+
+  /// \brief Pop a dead letter from the queue, returns false if there is none.
+  auto TryPop(DeadLetter* out) -> bool;
+
+  /// \brief Return the number of dead letters pushed.
+  [[nodiscard]] auto count() const -> size_t { return count_.load(); }
+
+ private:
+  DeadLetterSink() = default;
+
+  std::atomic<size_t> count_ = 0;
+  size_t queue_size_ = BOLSON_DEAD_LETTER_QUEUE_SIZE;
+  moodycamel::ConcurrentQueue<DeadLetter> queue_;
+  /// The file, if any, and a mutex serializing writes of all parsers.
+  std::ofstream file_;
+  std::mutex file_mutex_;
+};
+
+/// \brief Log the number of dead letters, and drain and log the queued dead letters.
+void LogDeadLetters(DeadLetterSink* sink);
+
+}  // namespace bolson::parse
@@ -135,7 +135,7 @@ auto BatteryParserContext::PrepareParsers() -> Status {
   for (size_t i = 0; i < num_parsers_; i++) {
     auto parser = std::make_shared<BatteryParser>(
         platform.get(), context.get(), kernel.get(), i, num_parsers_, raw_out_offsets[i],
-        raw_out_values[i], &platform_mutex, seq_column);
+        raw_out_values[i], &platform_mutex, seq_column, wait_);
     parser->Init();
     parsers_.push_back(parser);
   }
@@ -163,7 +163,7 @@ auto BatteryParserContext::output_schema() const -> std::shared_ptr<arrow::Schem
 }
 
 BatteryParserContext::BatteryParserContext(const BatteryOptions& opts)
-    : num_parsers_(opts.num_parsers), seq_column(opts.seq_column) {
+    : num_parsers_(opts.num_parsers), seq_column(opts.seq_column), wait_(opts.wait) {
   allocator_ = std::make_shared<buffer::FpgaAllocator>();
 }
 
@@ -261,10 +261,13 @@ auto BatteryParser::ParseOne(illex::JSONBuffer* in, ParsedBatch* out) -> Status
     done = (status & stat_done) == stat_done;
 
     platform_mutex->unlock();
-    std::this_thread::sleep_for(std::chrono::microseconds(BOLSON_QUEUE_WAIT_US));
+    if (!done) {
+      waiter_.Wait();
+    }
     platform_mutex->lock();
 #endif
   } while (!done);
+  waiter_.Reset();
 
   ReadMMIO(p, result_rows_offset_lo(idx_), &num_rows.lo, idx_, "rows lo");
   ReadMMIO(p, result_rows_offset_hi(idx_), &num_rows.hi, idx_, "rows hi");
@@ -24,6 +24,7 @@
 #include "bolson/buffer/fpga_allocator.h"
 #include "bolson/parse/parser.h"
 #include "bolson/utils.h"
+#include "bolson/wait.h"
 
 #define BOLSON_DEFAULT_FLETCHER_BATTERY_PARSERS 8
 
@@ -34,6 +35,7 @@ struct BatteryOptions {
   size_t out_values_buffer_capacity = 1024 * 1024 * 1024;
   size_t num_parsers;
   bool seq_column;
+  WaitOptions wait;
 };
 
 void AddBatteryOptionsToCLI(CLI::App* sub, BatteryOptions* out);
@@ -47,7 +49,7 @@ class BatteryParser : public Parser {
   BatteryParser(::fletcher::Platform* platform, ::fletcher::Context* context,
                 ::fletcher::Kernel* kernel, size_t parser_idx, size_t num_parsers,
                 std::byte* raw_out_offsets, std::byte* raw_out_values,
-                std::mutex* platform_mutex, bool seq_column)
+                std::mutex* platform_mutex, bool seq_column, const WaitOptions& wait)
       : platform_(platform),
         context_(context),
         kernel_(kernel),
@@ -56,7 +58,8 @@ class BatteryParser : public Parser {
         raw_out_offsets(raw_out_offsets),
         raw_out_values(raw_out_values),
         platform_mutex(platform_mutex),
-        seq_column(seq_column) {}
+        seq_column(seq_column),
+        waiter_(wait) {}
 
   auto Init() -> Status;
 
@@ -129,6 +132,7 @@ class BatteryParser : public Parser {
   std::byte* raw_out_values;
   std::mutex* platform_mutex;
   bool seq_column;
+  Waiter waiter_;
 };
 
 class BatteryParserContext : public ParserContext {
@@ -168,6 +172,7 @@ class BatteryParserContext : public ParserContext {
   std::shared_ptr<arrow::Schema> output_schema_;
 
   bool seq_column;
+  WaitOptions wait_;
 };
 
 }  // namespace bolson::parse::fpga
@@ -579,9 +579,12 @@ static auto FixResult(const std::shared_ptr<arrow::RecordBatch>& batch,
     SPDLOG_DEBUG("TripParser | Total bytes consumed: {}/{}", bytes_consumed, bytes_total);
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
 #else
-    std::this_thread::sleep_for(std::chrono::microseconds(BOLSON_QUEUE_WAIT_US));
+    if ((status & stat_done) != stat_done) {
+      waiter_.Wait();
+    }
 #endif
   } while ((status & stat_done) != stat_done);
+  waiter_.Reset();
 
   // Grab the return value (number of parsed JSON objects) and wrap the output Batch.
   FLETCHER_ROE(kernel_->GetReturn(&ret_val.lo, &ret_val.hi));
@@ -626,12 +629,13 @@ auto TripParser::WriteInputMetaData(fletcher::Platform* platform, illex::JSONBuf
 TripParser::TripParser(fletcher::Platform* platform, fletcher::Context* context,
                        fletcher::Kernel* kernel,
                        std::vector<std::shared_ptr<arrow::Array>>* output_arrays,
-                       size_t num_parsers)
+                       size_t num_parsers, const WaitOptions& wait)
     : platform_(platform),
       context_(context),
       kernel_(kernel),
       output_arrays_sw_(output_arrays),
-      num_hardware_parsers_(num_parsers) {}
+      num_hardware_parsers_(num_parsers),
+      waiter_(wait) {}
 
 auto ToString(const illex::JSONBuffer& buffer, bool show_contents) -> std::string {
   std::stringstream ss;
@@ -758,13 +762,13 @@ auto TripParserContext::parsers() -> std::vector<std::shared_ptr<Parser>> {
 }
 
 TripParserContext::TripParserContext(const TripOptions& opts)
-    : num_parsers_(opts.num_parsers) {
+    : num_parsers_(opts.num_parsers), wait_(opts.wait) {
   allocator_ = std::make_shared<buffer::FpgaAllocator>();
 }
 
 auto TripParserContext::PrepareParser() -> Status {
   parser = std::make_shared<TripParser>(platform.get(), context.get(), kernel.get(),
-                                        &output_arrays_sw, num_parsers_);
+                                        &output_arrays_sw, num_parsers_, wait_);
   return Status::OK();
 }
 
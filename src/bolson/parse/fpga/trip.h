@@ -23,6 +23,7 @@
 
 #include "bolson/buffer/fpga_allocator.h"
 #include "bolson/parse/parser.h"
+#include "bolson/wait.h"
 
 #define BOLSON_DEFAULT_FPGA_TRIP_PARSERS 8
 
@@ -32,6 +33,7 @@ struct TripOptions {
   size_t num_parsers = BOLSON_DEFAULT_FPGA_TRIP_PARSERS;
   size_t num_output_rows = 1024 * 1024;
   size_t num_string_value_bytes = 1024 * 1024 * 1024;
+  WaitOptions wait;
 };
 
 void AddTripOptionsToCLI(CLI::App* sub, TripOptions* out);
@@ -45,7 +47,7 @@ class TripParser : public Parser {
   TripParser(fletcher::Platform* platform, fletcher::Context* context,
              fletcher::Kernel* kernel,
              std::vector<std::shared_ptr<arrow::Array>>* output_arrays,
-             size_t num_parsers);
+             size_t num_parsers, const WaitOptions& wait);
 
   auto Parse(const std::vector<illex::JSONBuffer*>& in, std::vector<ParsedBatch>* out)
       -> Status override;
@@ -77,6 +79,7 @@ class TripParser : public Parser {
   fletcher::Context* context_;
   fletcher::Kernel* kernel_;
   std::vector<std::shared_ptr<arrow::Array>>* output_arrays_sw_{};
+  Waiter waiter_;
 };
 
 /**
@@ -102,6 +105,7 @@ class TripParserContext : public ParserContext {
   [[nodiscard]] auto PrepareParser() -> Status;
 
   size_t num_parsers_;
+  WaitOptions wait_;
 
   buffer::FpgaAllocator allocator;
 
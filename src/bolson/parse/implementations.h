@@ -18,9 +18,12 @@
 
 #include "bolson/parse/arrow.h"
 #include "bolson/parse/custom/battery.h"
+#include "bolson/parse/custom/generic.h"
 #include "bolson/parse/custom/trip.h"
+#include "bolson/parse/dead_letter.h"
 #include "bolson/parse/fpga/battery.h"
 #include "bolson/parse/fpga/trip.h"
+#include "bolson/parse/generated/registry.h"
 #include "bolson/parse/opae/battery.h"
 #include "bolson/parse/opae/trip.h"
 
@@ -35,6 +38,11 @@ enum class Impl {
   CUSTOM_TRIP,     ///< A hand-optimized CPU converter for the "battery status" schema
   FPGA_BATTERY,    ///< An FPGA version for the "battery status" schema using Fletcher.
   FPGA_TRIP,       ///< An FPGA version for the "trip report" schema using Fletcher.
+  CUSTOM_GENERIC,  ///< A CPU converter for any supported schema, driven by a parse plan.
+// CPU converters generated at build time for the schemas in BOLSON_GENERATED_PARSERS.
+#define BOLSON_GENERATED_IMPL(name, NAME) GENERATED_##NAME,
+  BOLSON_GENERATED_PARSERS(BOLSON_GENERATED_IMPL)
+#undef BOLSON_GENERATED_IMPL
 };
 
 /// All parser options.
@@ -46,8 +54,10 @@ struct ParserOptions {
   opae::TripOptions opae_trip;
   custom::BatteryOptions custom_battery;
   custom::TripOptions custom_trip;
+  custom::GenericOptions custom_generic;
   fpga::BatteryOptions fpga_battery;
   fpga::TripOptions fpga_trip;
+  DeadLetterOptions dead_letter;
 
   static auto impls_map() -> std::map<std::string, parse::Impl> {
     static std::map<std::string, parse::Impl> result = {
@@ -56,8 +66,14 @@ struct ParserOptions {
         {"opae-trip", parse::Impl::OPAE_TRIP},
         {"custom-battery", parse::Impl::CUSTOM_BATTERY},
         {"custom-trip", parse::Impl::CUSTOM_TRIP},
+        {"custom-generic", parse::Impl::CUSTOM_GENERIC},
         {"fpga-battery", parse::Impl::FPGA_BATTERY},
-        {"fpga-trip", parse::Impl::FPGA_TRIP}};
+        {"fpga-trip", parse::Impl::FPGA_TRIP},
+#define BOLSON_GENERATED_IMPL(name, NAME) \
+  {"generated-" #name, parse::Impl::GENERATED_##NAME},
+        BOLSON_GENERATED_PARSERS(BOLSON_GENERATED_IMPL)
+#undef BOLSON_GENERATED_IMPL
+    };
     return result;
   }
 };
@@ -75,6 +91,7 @@ inline void AddParserOptions(CLI::App* sub, ParserOptions* opts) {
   parse::custom::AddTripOptionsToCLI(sub, &opts->custom_trip);
   parse::fpga::AddBatteryOptionsToCLI(sub, &opts->fpga_battery);
   parse::fpga::AddTripOptionsToCLI(sub, &opts->fpga_trip);
+  parse::AddDeadLetterOptionsToCLI(sub, &opts->dead_letter);
 }
 
 inline auto ToString(const Impl& impl) -> std::string {
@@ -93,6 +110,13 @@ inline auto ToString(const Impl& impl) -> std::string {
       return "Fletcher battery status (FPGA)";
     case Impl::FPGA_TRIP:
       return "Fletcher trip report (FPGA)";
+    case Impl::CUSTOM_GENERIC:
+      return "Custom generic schema (CPU)";
+#define BOLSON_GENERATED_IMPL(name, NAME) \
+  case Impl::GENERATED_##NAME:            \
+    return "Generated " #name " (CPU)";
+      BOLSON_GENERATED_PARSERS(BOLSON_GENERATED_IMPL)
+#undef BOLSON_GENERATED_IMPL
   }
   // C++ why
   return "Corrupt bolson::parse::Impl enum value.";
@@ -0,0 +1,151 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace bolson::parse {
+
+namespace detail {
+
+/// \brief Parse n digits at s[i], throwing if any of them is no digit.
+inline auto ParseDigits(std::string_view s, size_t i, size_t n) -> int64_t {
+  int64_t result = 0;
+  for (size_t j = i; j < i + n; j++) {
+    auto d = static_cast<unsigned char>(s[j] - '0');
+    if (d > 9) {
+      throw std::runtime_error("Cannot parse timestamp: " + std::string(s));
+    }
+    result = result * 10 + d;
+  }
+  return result;
+}
+
+/// \brief Return the number of days since 1970-01-01 of a date in the Gregorian calendar.
+inline auto DaysFromCivil(int64_t y, int64_t m, int64_t d) -> int64_t {
+  // Count from March, such that the leap day is the last day of a year.
+  y -= static_cast<int64_t>(m <= 2);
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const int64_t yoe = y - era * 400;
+  const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+inline auto DaysInMonth(int64_t y, int64_t m) -> int64_t {
+  constexpr int64_t days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  const bool leap = ((y % 4 == 0) && (y % 100 != 0)) || (y % 400 == 0);
+  return days[m - 1] + static_cast<int64_t>(leap && (m == 2));
+}
+
+}  // namespace detail
+
+/**
+ * \brief Parse an ISO-8601 timestamp to nanoseconds since the UNIX epoch, in UTC.
+ *
+ * The fixed format YYYY-MM-DDTHH:MM:SS is followed by an optional fraction of up to
+ * nine digits and an optional UTC offset: Z, +HH:MM, +HHMM or +HH. Timestamps without
+ * offset are taken to be in UTC. Throws on any other input, or if the timestamp is out
+ * of the range of 64-bit nanoseconds, i.e. roughly the years 1677 to 2262.
+ *
+ * \param s The timestamp.
+ * \return Nanoseconds since 1970-01-01T00:00:00Z.
+ */
+inline auto ParseISO8601(std::string_view s) -> int64_t {
+  using detail::ParseDigits;
+  auto fail = [&]() {
+    throw std::runtime_error("Cannot parse timestamp: " + std::string(s));
+  };
+
+  if ((s.size() < 19) || (s[4] != '-') || (s[7] != '-') ||
+      ((s[10] != 'T') && (s[10] != 't') && (s[10] != ' ')) || (s[13] != ':') ||
+      (s[16] != ':')) {
+    fail();
+  }
+  const int64_t year = ParseDigits(s, 0, 4);
+  const int64_t month = ParseDigits(s, 5, 2);
+  const int64_t day = ParseDigits(s, 8, 2);
+  const int64_t hour = ParseDigits(s, 11, 2);
+  const int64_t minute = ParseDigits(s, 14, 2);
+  const int64_t second = ParseDigits(s, 17, 2);
+  if ((month < 1) || (month > 12) || (day < 1) ||
+      (day > detail::DaysInMonth(year, month)) || (hour > 23) || (minute > 59) ||
+      (second > 59)) {
+    fail();
+  }
+
+  size_t i = 19;
+  int64_t fraction = 0;
+  if ((i < s.size()) && ((s[i] == '.') || (s[i] == ','))) {
+    i++;
+    const size_t first = i;
+    while ((i < s.size()) && (static_cast<unsigned char>(s[i] - '0') <= 9)) {
+      // Digits beyond nanoseconds are truncated.
+      if (i - first < 9) {
+        fraction = fraction * 10 + (s[i] - '0');
+      }
+      i++;
+    }
+    if (i == first) {
+      fail();
+    }
+    for (size_t n = i - first; n < 9; n++) {
+      fraction *= 10;
+    }
+  }
+
+  int64_t offset = 0;
+  if (i < s.size()) {
+    if ((s[i] == 'Z') || (s[i] == 'z')) {
+      i++;
+    } else if ((s[i] == '+') || (s[i] == '-')) {
+      const int64_t sign = s[i] == '-' ? -1 : 1;
+      i++;
+      if (s.size() - i < 2) {
+        fail();
+      }
+      int64_t offset_minutes = ParseDigits(s, i, 2) * 60;
+      i += 2;
+      if ((i < s.size()) && (s[i] == ':')) {
+        i++;
+        if (s.size() - i < 2) {
+          fail();
+        }
+      }
+      if (s.size() - i >= 2) {
+        offset_minutes += ParseDigits(s, i, 2);
+        i += 2;
+      }
+      offset = sign * offset_minutes * 60;
+    }
+  }
+  if (i != s.size()) {
+    fail();
+  }
+
+  const int64_t seconds = detail::DaysFromCivil(year, month, day) * 86400 +
+                          hour * 3600 + minute * 60 + second - offset;
+  int64_t result = 0;
+  if (__builtin_mul_overflow(seconds, 1000000000, &result) ||
+      __builtin_add_overflow(result, fraction, &result)) {
+    throw std::runtime_error("Timestamp out of range: " + std::string(s));
+  }
+  return result;
+}
+
+}  // namespace bolson::parse
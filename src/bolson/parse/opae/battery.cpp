@@ -149,7 +149,7 @@ auto BatteryParserContext::PrepareParsers() -> Status {
   for (size_t i = 0; i < num_parsers_; i++) {
     parsers_.push_back(std::make_shared<BatteryParser>(
         platform.get(), context.get(), kernel.get(), &h2d_addr_map, i, num_parsers_,
-        raw_out_offsets[i], raw_out_values[i], &platform_mutex, seq_column));
+        raw_out_offsets[i], raw_out_values[i], &platform_mutex, seq_column, wait_));
   }
   return Status::OK();
 }
@@ -175,7 +175,10 @@ auto BatteryParserContext::output_schema() const -> std::shared_ptr<arrow::Schem
 }
 
 BatteryParserContext::BatteryParserContext(const BatteryOptions& opts)
-    : num_parsers_(opts.num_parsers), afu_id_(opts.afu_id), seq_column(opts.seq_column) {
+    : num_parsers_(opts.num_parsers),
+      afu_id_(opts.afu_id),
+      seq_column(opts.seq_column),
+      wait_(opts.wait) {
   allocator_ = std::make_shared<buffer::OpaeAllocator>();
 }
 
@@ -277,10 +280,13 @@ auto BatteryParser::ParseOne(illex::JSONBuffer* in, ParsedBatch* out) -> Status
     done = (status & stat_done) == stat_done;
 
     platform_mutex->unlock();
-    std::this_thread::sleep_for(std::chrono::microseconds(BOLSON_QUEUE_WAIT_US));
+    if (!done) {
+      waiter_.Wait();
+    }
     platform_mutex->lock();
 #endif
   } while (!done);
+  waiter_.Reset();
 
   ReadMMIO(p, result_rows_offset_lo(idx_), &num_rows.lo, idx_,
            "rows lo");
@@ -25,6 +25,7 @@
 #include "bolson/parse/opae/opae.h"
 #include "bolson/parse/parser.h"
 #include "bolson/utils.h"
+#include "bolson/wait.h"
 
 #define BOLSON_DEFAULT_OPAE_BATTERY_PARSERS 8
 #define BOLSON_DEFAULT_OPAE_BATTERY_AFUID "9ca43fb0-c340-4908-b79b-5c89b4ef5e"
@@ -35,6 +36,7 @@ struct BatteryOptions {
   std::string afu_id;  // left empty to auto-derive by default.
   size_t num_parsers = BOLSON_DEFAULT_OPAE_BATTERY_PARSERS;
   bool seq_column = true;
+  WaitOptions wait;
 };
 
 void AddBatteryOptionsToCLI(CLI::App* sub, BatteryOptions* out);
@@ -48,7 +50,7 @@ class BatteryParser : public Parser {
   BatteryParser(fletcher::Platform* platform, fletcher::Context* context,
                 fletcher::Kernel* kernel, AddrMap* addr_map, size_t parser_idx,
                 size_t num_parsers, std::byte* raw_out_offsets, std::byte* raw_out_values,
-                std::mutex* platform_mutex, bool seq_column)
+                std::mutex* platform_mutex, bool seq_column, const WaitOptions& wait)
       : platform_(platform),
         context_(context),
         kernel_(kernel),
@@ -58,7 +60,8 @@ class BatteryParser : public Parser {
         raw_out_offsets(raw_out_offsets),
         raw_out_values(raw_out_values),
         platform_mutex(platform_mutex),
-        seq_column(seq_column) {}
+        seq_column(seq_column),
+        waiter_(wait) {}
 
   auto Parse(const std::vector<illex::JSONBuffer*>& in, std::vector<ParsedBatch>* out)
       -> Status override;
@@ -125,6 +128,7 @@ class BatteryParser : public Parser {
   std::byte* raw_out_values;
   std::mutex* platform_mutex;
   bool seq_column;
+  Waiter waiter_;
 };
 
 class BatteryParserContext : public ParserContext {
@@ -167,6 +171,7 @@ class BatteryParserContext : public ParserContext {
   std::shared_ptr<arrow::Schema> output_schema_;
 
   bool seq_column;
+  WaitOptions wait_;
 };
 
 }  // namespace bolson::parse::opae
@@ -23,6 +23,7 @@
 
 #include "bolson/buffer/opae_allocator.h"
 #include "bolson/parse/parser.h"
+#include "bolson/wait.h"
 
 #define BOLSON_DEFAULT_OPAE_TRIP_PARSERS 4
 #define BOLSON_DEFAULT_OPAE_TRIP_AFUID "5d2f9dba-e8d0-44f8-943d-36b25c2d40"
@@ -32,6 +33,7 @@ namespace bolson::parse::opae {
 struct TripOptions {
   std::string afu_id;
   size_t num_parsers = BOLSON_DEFAULT_OPAE_TRIP_PARSERS;
+  WaitOptions wait;
 };
 
 void AddTripOptionsToCLI(CLI::App* sub, TripOptions* out);
@@ -47,7 +49,7 @@ class TripParser : public Parser {
   TripParser(fletcher::Platform* platform, fletcher::Context* context,
              fletcher::Kernel* kernel, AddrMap* addr_map,
              std::vector<std::shared_ptr<arrow::Array>>* output_arrays,
-             size_t num_parsers);
+             size_t num_parsers, const WaitOptions& wait);
 
   auto Parse(const std::vector<illex::JSONBuffer*>& in, std::vector<ParsedBatch>* out)
       -> Status override;
@@ -80,6 +82,7 @@ class TripParser : public Parser {
   fletcher::Kernel* kernel_;
   AddrMap* h2d_addr_map;
   std::vector<std::shared_ptr<arrow::Array>>* output_arrays_sw_{};
+  Waiter waiter_;
 };
 
 /**
@@ -105,6 +108,7 @@ class TripParserContext : public ParserContext {
 
   size_t num_parsers_;
   std::string afu_id_;
+  WaitOptions wait_;
 
   buffer::OpaeAllocator allocator;
 
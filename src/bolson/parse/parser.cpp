@@ -14,6 +14,12 @@
 
 #include "bolson/parse/parser.h"
 
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include "bolson/log.h"
 #include "bolson/status.h"
 
 namespace bolson::parse {
@@ -85,6 +91,10 @@ auto ParserContext::FreeBuffers() -> Status {
     return Status(Error::GenericError,
                   "Parser context has no allocator to free buffers.");
   }
+  // Buffers backed by rings are released together with the rings.
+  if (!rings_.empty()) {
+    return Status::OK();
+  }
   // Free all buffers.
   for (auto& buffer : buffers_) {
     BOLSON_ROE(allocator_->Free(buffer.mutable_data()));
@@ -110,4 +120,276 @@ auto ParserContext::mutable_buffers() -> std::vector<illex::JSONBuffer*> {
 
 auto ParserContext::mutexes() -> std::vector<std::mutex*> { return ToPointers(mutexes_); }
 
+auto ParserContext::ready_queue(size_t node) -> ReadyQueue* {
+  return &ready_queues_[node];
+}
+
+auto ParserContext::buffer_node(size_t b) const -> size_t {
+  if (numa_nodes_.empty()) {
+    return 0;
+  }
+  return b % numa_nodes_.size();
+}
+
+auto ParserContext::EnableNuma(const std::vector<NumaNode>& nodes) -> Status {
+  if (!SupportsNuma()) {
+    return Status(Error::GenericError,
+                  "Parser implementation does not support NUMA buffer placement.");
+  }
+  if (nodes.empty() || (nodes.size() > buffers_.size())) {
+    return Status(Error::GenericError,
+                  "Number of NUMA nodes must be between one and the number of input "
+                  "buffers (" +
+                      std::to_string(buffers_.size()) + ").");
+  }
+  if (!numa_nodes_.empty() || !rings_.empty()) {
+    return Status(Error::GenericError,
+                  "NUMA placement must be enabled before any other buffer placement.");
+  }
+
+  std::vector<size_t> capacities;
+  for (const auto& buffer : buffers_) {
+    capacities.push_back(buffer.capacity());
+  }
+  BOLSON_ROE(FreeBuffers());
+  numa_nodes_ = nodes;
+  while (ready_queues_.size() < nodes.size()) {
+    ready_queues_.emplace_back();
+  }
+
+  // Allocate the buffers of each node from a thread pinned to that node.
+  MultiThreadStatus statuses(nodes.size(), Status::OK());
+  std::vector<std::thread> threads;
+  for (size_t n = 0; n < nodes.size(); n++) {
+    threads.emplace_back([this, n, &nodes, &capacities, &statuses]() {
+      statuses[n] = PinThread(nodes[n].cpus);
+      for (size_t b = n; statuses[n].ok() && (b < buffers_.size()); b += nodes.size()) {
+        std::byte* raw = nullptr;
+        statuses[n] = allocator_->Allocate(capacities[b], &raw);
+        if (statuses[n].ok()) {
+          auto created = illex::JSONBuffer::Create(raw, capacities[b], &buffers_[b]);
+          if (!created.ok()) {
+            statuses[n] = Status(Error::IllexError, created.msg());
+          }
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  return Aggregate(statuses, "NUMA node ");
+}
+
+auto ParserContext::EnableRingBuffers(size_t num_rings, bool hugepages) -> Status {
+  if (!SupportsRingBuffers()) {
+    return Status(Error::GenericError,
+                  "Parser implementation does not support ring buffer input.");
+  }
+  if ((num_rings == 0) || (num_rings > buffers_.size())) {
+    return Status(Error::GenericError,
+                  "Number of ring buffers must be between one and the number of input "
+                  "buffers (" +
+                      std::to_string(buffers_.size()) + ").");
+  }
+  if (!rings_.empty()) {
+    return Status(Error::GenericError, "Ring buffers are already enabled.");
+  }
+
+  // Distribute the total capacity of all input buffers over the rings.
+  size_t total_capacity = 0;
+  for (const auto& buffer : buffers_) {
+    total_capacity += buffer.capacity();
+  }
+  BOLSON_ROE(FreeBuffers());
+
+  const size_t ring_capacity = DivideCeil(total_capacity, num_rings);
+  if (numa_nodes_.empty()) {
+    for (size_t r = 0; r < num_rings; r++) {
+      std::shared_ptr<buffer::RingBuffer> ring;
+      BOLSON_ROE(buffer::RingBuffer::Make(ring_capacity, hugepages, &ring));
+      rings_.push_back(ring);
+    }
+  } else {
+    // Ring r is placed on node r % nodes, by first-touching its pages from a thread
+    // pinned to that node. Buffers keep the node assigned by EnableNuma(), which only
+    // matches the node of their ring if the number of rings is a multiple of the number
+    // of nodes.
+    const size_t num_nodes = numa_nodes_.size();
+    if (num_rings % num_nodes != 0) {
+      spdlog::warn("Number of ring buffers ({}) is not a multiple of the number of NUMA "
+                   "nodes ({}), some input buffers are parsed on a remote node.",
+                   num_rings, num_nodes);
+    }
+    rings_.resize(num_rings);
+    MultiThreadStatus statuses(num_nodes, Status::OK());
+    std::vector<std::thread> threads;
+    for (size_t n = 0; n < num_nodes; n++) {
+      threads.emplace_back([this, n, num_nodes, num_rings, ring_capacity, hugepages,
+                            &statuses]() {
+        statuses[n] = PinThread(numa_nodes_[n].cpus);
+        for (size_t r = n; statuses[n].ok() && (r < num_rings); r += num_nodes) {
+          statuses[n] = buffer::RingBuffer::Make(ring_capacity, hugepages, &rings_[r]);
+          if (statuses[n].ok()) {
+            std::memset(rings_[r]->write_ptr(), 0, rings_[r]->capacity());
+          }
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    BOLSON_ROE(Aggregate(statuses, "NUMA node "));
+  }
+
+  // Point all buffers to the start of their ring.
+  for (size_t b = 0; b < buffers_.size(); b++) {
+    auto* ring = rings_[b % num_rings].get();
+    BILLEX_ROE(
+        illex::JSONBuffer::Create(ring->write_ptr(), ring->capacity(), &buffers_[b]));
+  }
+
+  return Status::OK();
+}
+
+auto ParserContext::ring(size_t b) -> buffer::RingBuffer* {
+  if (rings_.empty()) {
+    return nullptr;
+  }
+  return rings_[b % rings_.size()].get();
+}
+
+void ParserContext::SignalFilledBuffers() {
+  for (size_t b = 0; b < buffers_.size(); b++) {
+    if (!buffers_[b].empty()) {
+      ready_queues_[buffer_node(b)].enqueue(b);
+    }
+  }
+}
+
+auto SplitBuffer(illex::JSONBuffer* in, size_t num_chunks, size_t min_chunk_size,
+                 std::vector<illex::JSONBuffer>* out) -> Status {
+  const size_t size = in->size();
+  auto* data = in->mutable_data();
+  auto* chars = reinterpret_cast<const char*>(data);
+  const size_t chunk_size = std::max(DivideCeil(size, std::max<size_t>(num_chunks, 1)),
+                                     std::max<size_t>(min_chunk_size, 1));
+
+  out->clear();
+  uint64_t seq = in->range().first;
+  size_t start = 0;
+  while (start < size) {
+    // End the chunk after the first newline at or beyond the desired chunk size.
+    size_t end = size;
+    if (start + chunk_size < size) {
+      const size_t from = start + chunk_size - 1;
+      auto* nl = static_cast<const char*>(std::memchr(chars + from, '\n', size - from));
+      if (nl != nullptr) {
+        end = nl - chars + 1;
+      }
+      // Do not leave a tail without JSONs behind.
+      if (std::memchr(chars + end, '\n', size - end) == nullptr) {
+        end = size;
+      }
+    }
+
+    uint64_t last = in->range().last;
+    if (end < size) {
+      last = seq + std::count(chars + start, chars + end, '\n') - 1;
+    }
+
+    illex::JSONBuffer chunk;
+    BILLEX_ROE(illex::JSONBuffer::Create(data + start, end - start, &chunk));
+    BILLEX_ROE(chunk.SetSize(end - start));
+    chunk.SetRange({seq, last});
+    chunk.SetRecvTime(in->recv_time());
+    out->push_back(chunk);
+
+    seq = last + 1;
+    start = end;
+  }
+  return Status::OK();
+}
+
+/// \brief Return the sequence number of a row of a parsed batch.
+static auto SeqOfRow(const ParsedBatch& batch, int64_t row) -> illex::Seq {
+  illex::Seq seq = batch.seq_range.first + row;
+  for (auto skipped : batch.skipped) {
+    if (skipped > seq) break;
+    seq++;
+  }
+  return seq;
+}
+
+auto SliceParsed(const ParsedBatch& in, int64_t offset, int64_t length) -> ParsedBatch {
+  const int64_t end = offset + length;
+  illex::SeqRange range = in.seq_range;
+  if (offset > 0) {
+    range.first = SeqOfRow(in, offset - 1) + 1;
+  }
+  if (end < in.batch->num_rows()) {
+    range.last = SeqOfRow(in, end - 1);
+  }
+  ParsedBatch result(AddSeqAsSchemaMeta(in.batch->Slice(offset, length), range), range);
+  for (auto skipped : in.skipped) {
+    if ((skipped >= range.first) && (skipped <= range.last)) {
+      result.skipped.push_back(skipped);
+    }
+  }
+  return result;
+}
+
+auto StitchBatches(const std::vector<ParsedBatch>& parts, ParsedBatch* out) -> Status {
+  if (parts.size() == 1) {
+    *out = parts[0];
+    return Status::OK();
+  }
+
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  std::vector<illex::Seq> skipped;
+  int64_t num_rows = 0;
+  for (const auto& p : parts) {
+    if (p.batch->num_rows() > 0) {
+      batches.push_back(p.batch);
+    }
+    skipped.insert(skipped.end(), p.skipped.begin(), p.skipped.end());
+    num_rows += p.batch->num_rows();
+  }
+  illex::SeqRange range = {parts.front().seq_range.first, parts.back().seq_range.last};
+
+  // Concatenate the columns of the parts with rows directly, without going through a
+  // table. If only one part has rows, its batch is used as is.
+  std::shared_ptr<arrow::RecordBatch> batch = parts[0].batch;
+  if (batches.size() == 1) {
+    batch = batches[0];
+  } else if (batches.size() > 1) {
+    arrow::ArrayVector columns;
+    for (int c = 0; c < batch->num_columns(); c++) {
+      arrow::ArrayVector chunks;
+      for (const auto& b : batches) {
+        chunks.push_back(b->column(c));
+      }
+      auto concat_result = arrow::Concatenate(chunks);
+      if (!concat_result.ok()) {
+        return Status(Error::ArrowError, concat_result.status().message());
+      }
+      columns.push_back(concat_result.ValueOrDie());
+    }
+    batch = arrow::RecordBatch::Make(batches[0]->schema(), num_rows, columns);
+  }
+
+  // The schema of a part may hold its own sequence number range as metadata.
+  auto meta = batch->schema()->metadata();
+  if ((meta != nullptr) && (meta->FindKey("bolson_seq_first") != -1)) {
+    auto new_meta = meta->Copy();
+    ARROW_ROE(new_meta->Set("bolson_seq_first", std::to_string(range.first)));
+    ARROW_ROE(new_meta->Set("bolson_seq_last", std::to_string(range.last)));
+    batch = batch->ReplaceSchemaMetadata(new_meta);
+  }
+
+  *out = ParsedBatch(batch, range);
+  out->skipped = std::move(skipped);
+  return Status::OK();
+}
+
 }  // namespace bolson::parse
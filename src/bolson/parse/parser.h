@@ -15,15 +15,22 @@
 #pragma once
 
 #include <arrow/api.h>
+#include <blockingconcurrentqueue.h>
 #include <illex/client_buffering.h>
 
+#include <deque>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "bolson/buffer/allocator.h"
+#include "bolson/buffer/ring.h"
 #include "bolson/latency.h"
+#include "bolson/parse/dead_letter.h"
 #include "bolson/status.h"
+#include "bolson/topology.h"
 #include "bolson/utils.h"
+#include "bolson/wait.h"
 
 /// Contains all constructs to parse JSONs to Arrow RecordBatches
 namespace bolson::parse {
@@ -39,6 +46,9 @@ struct ParsedBatch {
   std::shared_ptr<arrow::RecordBatch> batch = nullptr;
   /// Range of sequence numbers in batch.
   illex::SeqRange seq_range = {0, 0};
+  /// Sequence numbers of JSONs in the range that were skipped and sent to the dead-letter
+  /// sink, in ascending order. The rows hold the other sequence numbers, in order.
+  std::vector<illex::Seq> skipped;
 };
 
 /**
@@ -60,8 +70,31 @@ class Parser {
    */
   virtual auto Parse(const std::vector<illex::JSONBuffer*>& buffers_in,
                      std::vector<ParsedBatch>* batches_out) -> Status = 0;
+
+  /**
+   * \brief Skip malformed JSONs, sending them to a dead-letter sink.
+   *
+   * Only has effect on parsers of contexts that support dead letters. Without a sink,
+   * a malformed JSON fails the whole buffer.
+   */
+  void set_dead_letters(std::shared_ptr<DeadLetterSink> sink) {
+    dead_letters_ = std::move(sink);
+  }
+
+ protected:
+  /// Sink for malformed JSONs in tolerant mode, nullptr otherwise.
+  std::shared_ptr<DeadLetterSink> dead_letters_ = nullptr;
 };
 
+/**
+ * \brief A queue holding indices of input buffers that are ready to be parsed.
+ *
+ * Whoever fills an input buffer pushes its index onto this queue after unlocking the
+ * buffer, so that converter threads can block on the queue rather than polling all
+ * buffer mutexes.
+ */
+using ReadyQueue = moodycamel::BlockingConcurrentQueue<size_t>;
+
 /**
  * \brief Abstract class for implementations to define contexts around parsers.
  */
@@ -80,6 +113,18 @@ class ParserContext {
     return num_buffers;
   }
 
+  /// \brief Return true if the parsers can operate on ring buffer input.
+  [[nodiscard]] virtual auto SupportsRingBuffers() const -> bool { return false; }
+
+  /// \brief Return true if the parsers can operate on chunks of an input buffer.
+  [[nodiscard]] virtual auto SupportsSplitting() const -> bool { return false; }
+
+  /// \brief Return true if input buffers may be re-allocated on specific NUMA nodes.
+  [[nodiscard]] virtual auto SupportsNuma() const -> bool { return false; }
+
+  /// \brief Return true if the parsers can skip malformed JSONs.
+  [[nodiscard]] virtual auto SupportsDeadLetters() const -> bool { return false; }
+
   /// \brief Return the Arrow input schema used by the parsers to convert JSONS.
   [[nodiscard]] virtual auto input_schema() const -> std::shared_ptr<arrow::Schema> = 0;
 
@@ -102,6 +147,67 @@ class ParserContext {
   /// \brief Unlock all mutexes of all buffers.
   void UnlockBuffers();
 
+  /**
+   * \brief Return the queue with indices of filled buffers of a NUMA node.
+   *
+   * Without NUMA placement, there is only one queue for all buffers.
+   */
+  auto ready_queue(size_t node = 0) -> ReadyQueue*;
+
+  /**
+   * \brief Return the signal notified whenever a buffer is reset and unlocked.
+   *
+   * Clients that park while all buffers are occupied wait on this signal.
+   */
+  auto free_signal() -> WakeSignal* { return &free_signal_; }
+
+  /// \brief Return the index of the NUMA node of buffer b in numa_nodes(), 0 if none.
+  [[nodiscard]] auto buffer_node(size_t b) const -> size_t;
+
+  /// \brief Return the NUMA nodes buffers are placed on, empty if not enabled.
+  [[nodiscard]] auto numa_nodes() const -> const std::vector<NumaNode>& {
+    return numa_nodes_;
+  }
+
+  /// \brief Mark all non-empty buffers as ready to be parsed.
+  void SignalFilledBuffers();
+
+  /**
+   * \brief Re-allocate the input buffers, partitioned over NUMA nodes.
+   *
+   * Buffer b is placed on node b % nodes.size(). The buffers of each node are allocated
+   * and zero-initialized by a thread pinned to that node, such that the pages are
+   * first-touched on, and thus backed by memory of, that node. Buffers of each node are
+   * signalled on their own ready queue.
+   *
+   * This must be called before any buffer is filled.
+   *
+   * \param nodes The NUMA nodes to place buffers on.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  auto EnableNuma(const std::vector<NumaNode>& nodes) -> Status;
+
+  /**
+   * \brief Back the input buffers with double-mapped ring buffers.
+   *
+   * The memory of the input buffers is replaced by num_rings ring buffers, sharing the
+   * total capacity of all input buffers. Input buffer b is backed by ring b % num_rings.
+   * Afterwards, the input buffers act as views into their ring, and must be re-created
+   * onto a region of the ring every time they are filled.
+   *
+   * With NUMA placement, ring r is placed on node r % numa_nodes().size().
+   *
+   * This must be called before any buffer is filled.
+   *
+   * \param num_rings The number of ring buffers.
+   * \param hugepages Whether to back the rings with huge pages.
+   * \return Status::OK() if successful, some error otherwise.
+   */
+  auto EnableRingBuffers(size_t num_rings, bool hugepages) -> Status;
+
+  /// \brief Return the ring backing buffer b, or nullptr if ring buffers are not used.
+  auto ring(size_t b) -> buffer::RingBuffer*;
+
  protected:
   virtual auto AllocateBuffers(size_t num_buffers, size_t size) -> Status;
   virtual auto FreeBuffers() -> Status;
@@ -112,6 +218,14 @@ class ParserContext {
   std::vector<illex::JSONBuffer> buffers_;
   /// The mutexes for the input buffers.
   std::vector<std::mutex> mutexes_;
+  /// Indices of input buffers that are filled and ready to be parsed, per NUMA node.
+  std::deque<ReadyQueue> ready_queues_ = std::deque<ReadyQueue>(1);
+  /// Notified whenever a buffer is freed.
+  WakeSignal free_signal_;
+  /// NUMA nodes the buffers are placed on, if enabled.
+  std::vector<NumaNode> numa_nodes_;
+  /// Ring buffers backing the input buffers, if enabled.
+  std::vector<std::shared_ptr<buffer::RingBuffer>> rings_;
 };
 
 /// \brief Print properties of the buffer in human-readable format.
@@ -121,6 +235,48 @@ auto ToString(const illex::JSONBuffer& buffer, bool show_contents = true) -> std
 auto AddSeqAsSchemaMeta(const std::shared_ptr<arrow::RecordBatch>& batch,
                         illex::SeqRange seq_range) -> std::shared_ptr<arrow::RecordBatch>;
 
+/**
+ * \brief Slice a parsed batch, with the range of sequence numbers of the slice.
+ *
+ * Rows are mapped to sequence numbers around the skipped JSONs. The ranges of the slices
+ * of a batch are contiguous: skipped JSONs belong to the slice of the row that follows
+ * them, or to the last slice if no row follows them.
+ *
+ * \param in     The parsed batch.
+ * \param offset The first row of the slice.
+ * \param length The number of rows of the slice.
+ * \return The slice, with its sequence number range added as schema metadata.
+ */
+auto SliceParsed(const ParsedBatch& in, int64_t offset, int64_t length) -> ParsedBatch;
+
+/**
+ * \brief Split a buffer into at most num_chunks newline-aligned chunks.
+ *
+ * The chunks are views onto the memory of the input buffer, each holding a discrete
+ * number of JSONs and the matching sub-range of sequence numbers. Chunks are at least
+ * min_chunk_size bytes, except for the last chunk.
+ *
+ * \param in             The buffer to split.
+ * \param num_chunks     The desired number of chunks.
+ * \param min_chunk_size The minimum size of a chunk in bytes.
+ * \param out            The resulting chunks.
+ * \return Status::OK() if successful, some error otherwise.
+ */
+auto SplitBuffer(illex::JSONBuffer* in, size_t num_chunks, size_t min_chunk_size,
+                 std::vector<illex::JSONBuffer>* out) -> Status;
+
+/**
+ * \brief Concatenate batches parsed from consecutive chunks of a buffer into one batch.
+ *
+ * The columns of parts with rows are concatenated. If at most one part has rows, no
+ * data is copied.
+ *
+ * \param parts The parsed chunks, in order of their sequence numbers.
+ * \param out   The resulting batch, spanning the sequence numbers of all parts.
+ * \return Status::OK() if successful, some error otherwise.
+ */
+auto StitchBatches(const std::vector<ParsedBatch>& parts, ParsedBatch* out) -> Status;
+
 /// \brief Return a new schema with the sequence number field added.
 auto WithSeqField(const arrow::Schema& schema, std::shared_ptr<arrow::Schema>* output)
     -> Status;
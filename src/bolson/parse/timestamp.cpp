@@ -0,0 +1,77 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/parse/timestamp.h"
+
+#include <arrow/api.h>
+
+#include <stdexcept>
+
+namespace bolson::parse {
+
+auto WithTimestampFields(const arrow::Schema& schema, std::shared_ptr<arrow::Schema>* out)
+    -> Status {
+  arrow::FieldVector fields;
+  for (const auto& field : schema.fields()) {
+    auto meta = field->metadata();
+    int key = meta == nullptr ? -1 : meta->FindKey(kTimestampMetaKey);
+    if (key == -1) {
+      fields.push_back(field);
+      continue;
+    }
+    if (field->type()->id() != arrow::Type::STRING) {
+      return Status(Error::GenericError, "Field " + field->name() + " is tagged with " +
+                                             kTimestampMetaKey + " but is not utf8.");
+    }
+    auto type = arrow::timestamp(arrow::TimeUnit::NANO, meta->value(key));
+    auto rest = meta->Copy();
+    ARROW_ROE(rest->Delete(key));
+    fields.push_back(field->WithType(type)->WithMetadata(rest));
+  }
+  *out = arrow::schema(fields, schema.metadata());
+  return Status::OK();
+}
+
+auto ConvertTimestampColumns(const std::shared_ptr<arrow::RecordBatch>& batch,
+                             const std::shared_ptr<arrow::Schema>& schema,
+                             std::shared_ptr<arrow::RecordBatch>* out) -> Status {
+  auto columns = batch->columns();
+  for (int c = 0; c < batch->num_columns(); c++) {
+    const auto& type = schema->field(c)->type();
+    if ((type->id() != arrow::Type::TIMESTAMP) ||
+        (columns[c]->type_id() != arrow::Type::STRING)) {
+      continue;
+    }
+    const auto& strings = static_cast<const arrow::StringArray&>(*columns[c]);
+    arrow::TimestampBuilder builder(type, arrow::default_memory_pool());
+    ARROW_ROE(builder.Reserve(strings.length()));
+    try {
+      for (int64_t i = 0; i < strings.length(); i++) {
+        if (strings.IsNull(i)) {
+          builder.UnsafeAppendNull();
+        } else {
+          auto value = strings.GetView(i);
+          builder.UnsafeAppend(ParseISO8601({value.data(), value.size()}));
+        }
+      }
+    } catch (const std::runtime_error& e) {
+      return Status(Error::GenericError, e.what());
+    }
+    ARROW_ROE(builder.Finish(&columns[c]));
+  }
+  *out = arrow::RecordBatch::Make(schema, batch->num_rows(), columns);
+  return Status::OK();
+}
+
+}  // namespace bolson::parse
@@ -0,0 +1,57 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <arrow/api.h>
+
+#include <memory>
+#include <string>
+
+#include "bolson/parse/iso8601.h"
+#include "bolson/status.h"
+
+namespace bolson::parse {
+
+/**
+ * Field metadata key tagging utf8 fields that hold ISO-8601 timestamps. Such fields are
+ * converted to timestamp(ns, tz) columns while parsing, where the time zone is the value
+ * of this key, e.g. "UTC". Values are always stored as UTC, as Arrow prescribes.
+ */
+constexpr const char* kTimestampMetaKey = "bolson_timestamp";
+
+/**
+ * \brief Replace tagged utf8 fields of a schema with timestamp(ns, tz) fields.
+ *
+ * Only top-level fields are replaced. The tag is removed from the field metadata.
+ *
+ * \param schema The input schema, i.e. the schema of the JSONs.
+ * \param out    The output schema.
+ * \return Status::OK() if successful, some error otherwise.
+ */
+auto WithTimestampFields(const arrow::Schema& schema, std::shared_ptr<arrow::Schema>* out)
+    -> Status;
+
+/**
+ * \brief Convert the utf8 columns of a batch to the timestamp fields of a schema.
+ * \param batch  The batch, as parsed with the input schema.
+ * \param schema The output schema, as returned by WithTimestampFields.
+ * \param out    The batch with converted columns.
+ * \return Status::OK() if successful, an error if a value is no ISO-8601 timestamp.
+ */
+auto ConvertTimestampColumns(const std::shared_ptr<arrow::RecordBatch>& batch,
+                             const std::shared_ptr<arrow::Schema>& schema,
+                             std::shared_ptr<arrow::RecordBatch>* out) -> Status;
+
+}  // namespace bolson::parse
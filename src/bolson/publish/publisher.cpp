@@ -44,8 +44,13 @@ auto ConcurrentPublisher::Make(const Options& opts, IpcQueue* ipc_queue,
   return Status::OK();
 }
 
-void ConcurrentPublisher::Start(std::atomic<bool>* shutdown) {
+auto ConcurrentPublisher::Start(std::atomic<bool>* shutdown,
+                                const AffinityOptions& affinity) -> Status {
   shutdown_ = shutdown;
+  for (size_t t = 0; t < threads.size(); t++) {
+    BOLSON_ROE(PlaceThread(&threads[t], ThreadRole::PUBLISHER, t, affinity));
+  }
+  return Status::OK();
 }
 
 auto ConcurrentPublisher::Finish() -> MultiThreadStatus {
@@ -24,26 +24,19 @@
 #include <future>
 #include <memory>
 
+#include "bolson/affinity.h"
 #include "bolson/convert/serializer.h"
 #include "bolson/log.h"
 #include "bolson/publish/metrics.h"
+#include "bolson/publish/queue.h"
 #include "bolson/status.h"
 
 namespace bolson::publish {
 
-/// Initial IPC queue reservation.
-#define BOLSON_PUBLISH_IPC_QUEUE_SIZE 1024
-
 /// Default max. message size.
 // From Pulsar sources.
 #define BOLSON_DEFAULT_PULSAR_MAX_MSG_SIZE (5 * 1024 * 1024 - 10 * 1024)
 
-/// An item in the IPC queue.
-using IpcQueueItem = convert::SerializedBatch;
-
-/// A queue with Arrow IPC messages.
-using IpcQueue = moodycamel::BlockingConcurrentQueue<IpcQueueItem>;
-
 /// Pulsar batching producer options.
 struct BatchingOptions {
   /// Whether to enable batching.
@@ -108,8 +101,11 @@ struct ConcurrentPublisher {
   /**
    * \brief Start Pulsar producer threads.
    * \param[in] shutdown Shutdown signal.
+   * \param[in] affinity CPU affinity of the producer threads.
+   * \return Status::OK() if successful, some error otherwise.
    */
-  void Start(std::atomic<bool>* shutdown);
+  auto Start(std::atomic<bool>* shutdown, const AffinityOptions& affinity = {})
+      -> Status;
 
   /**
    * \brief Finish producing, shutting down all threads and closing client and producers.
@@ -0,0 +1,112 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/publish/queue.h"
+
+#include <putong/timer.h>
+
+#include <algorithm>
+
+#include "bolson/latency.h"
+#include "bolson/log.h"
+
+namespace bolson::publish {
+
+auto IpcQueueMetrics::mean_bytes() const -> double {
+  return enqueued == 0 ? 0.0 : static_cast<double>(sum_bytes) / enqueued;
+}
+
+auto IpcQueueMetrics::mean_items() const -> double {
+  return enqueued == 0 ? 0.0 : static_cast<double>(sum_items) / enqueued;
+}
+
+void LogIpcQueueMetrics(const IpcQueueMetrics& metrics, size_t max_bytes,
+                        const std::string& t) {
+  spdlog::info("{}IPC queue:", t);
+  if (max_bytes == 0) {
+    spdlog::info("{}  Max. bytes            : unbounded", t);
+  } else {
+    spdlog::info("{}  Max. bytes            : {} B", t, max_bytes);
+  }
+  spdlog::info("{}  Peak occupancy        : {} B, {} messages", t, metrics.peak_bytes,
+               metrics.peak_items);
+  spdlog::info("{}  Mean occupancy        : {:.0f} B, {:.2f} messages", t,
+               metrics.mean_bytes(), metrics.mean_items());
+  spdlog::info("{}  Blocked enqueues      : {}", t, metrics.blocked);
+  spdlog::info("{}  Blocked time          : {} s", t, metrics.blocked_time);
+}
+
+IpcQueue::IpcQueue(size_t max_bytes, size_t reserve)
+    : queue_(reserve), max_bytes_(max_bytes) {}
+
+auto IpcQueue::SizeOf(const IpcQueueItem& item) -> size_t {
+  return item.message == nullptr ? 0 : static_cast<size_t>(item.message->size());
+}
+
+auto IpcQueue::enqueue(IpcQueueItem item, const std::atomic<bool>* shutdown) -> bool {
+  const size_t size = SizeOf(item);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto full = [&]() {
+      return (max_bytes_ > 0) && (bytes_ > 0) && (bytes_ + size > max_bytes_);
+    };
+    if (full()) {
+      putong::Timer<> t(true);
+      metrics_.blocked++;
+      // Wake up regularly to check the shutdown signal.
+      while (full()) {
+        if ((shutdown != nullptr) && shutdown->load()) {
+          t.Stop();
+          metrics_.blocked_time += t.seconds();
+          return false;
+        }
+        not_full_.wait_for(lock, std::chrono::microseconds(100 * BOLSON_QUEUE_WAIT_US));
+      }
+      t.Stop();
+      metrics_.blocked_time += t.seconds();
+    }
+    bytes_ += size;
+    items_++;
+    metrics_.enqueued++;
+    metrics_.sum_bytes += bytes_;
+    metrics_.sum_items += items_;
+    metrics_.peak_bytes = std::max<size_t>(metrics_.peak_bytes, bytes_);
+    metrics_.peak_items = std::max<size_t>(metrics_.peak_items, items_);
+  }
+  return queue_.enqueue(std::move(item));
+}
+
+auto IpcQueue::try_dequeue(IpcQueueItem& item) -> bool {
+  if (queue_.try_dequeue(item)) {
+    Release(item);
+    return true;
+  }
+  return false;
+}
+
+void IpcQueue::Release(const IpcQueueItem& item) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytes_ -= SizeOf(item);
+    items_--;
+  }
+  not_full_.notify_all();
+}
+
+auto IpcQueue::metrics() const -> IpcQueueMetrics {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return metrics_;
+}
+
+}  // namespace bolson::publish
@@ -0,0 +1,145 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <blockingconcurrentqueue.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+#include "bolson/convert/serializer.h"
+
+/// Initial IPC queue reservation.
+#define BOLSON_PUBLISH_IPC_QUEUE_SIZE 1024
+
+/// Default maximum number of bytes of IPC messages in the IPC queue.
+#define BOLSON_PUBLISH_IPC_QUEUE_MAX_BYTES "2Gi"
+
+namespace bolson::publish {
+
+/// An item in the IPC queue.
+using IpcQueueItem = convert::SerializedBatch;
+
+/// Occupancy statistics of the IPC queue.
+struct IpcQueueMetrics {
+  /// Maximum number of bytes of IPC messages in the queue at any time.
+  size_t peak_bytes = 0;
+  /// Maximum number of IPC messages in the queue at any time.
+  size_t peak_items = 0;
+  /// Sum of the number of bytes in the queue, sampled at every enqueue.
+  size_t sum_bytes = 0;
+  /// Sum of the number of items in the queue, sampled at every enqueue.
+  size_t sum_items = 0;
+  /// Number of enqueued IPC messages.
+  size_t enqueued = 0;
+  /// Number of enqueues that blocked because the queue was full.
+  size_t blocked = 0;
+  /// Total time enqueues were blocked in seconds.
+  double blocked_time = 0.0;
+
+  /// \brief Return the mean number of bytes in the queue.
+  [[nodiscard]] auto mean_bytes() const -> double;
+  /// \brief Return the mean number of items in the queue.
+  [[nodiscard]] auto mean_items() const -> double;
+};
+
+/// \brief Log IPC queue metrics.
+void LogIpcQueueMetrics(const IpcQueueMetrics& metrics, size_t max_bytes,
+                        const std::string& t = "");
+
+/**
+ * \brief A queue with Arrow IPC messages, bounded by the number of bytes it holds.
+ *
+ * When enqueueing a message would exceed the byte budget, the producer blocks until
+ * consumers have dequeued enough bytes. Converter threads blocked on a full queue stop
+ * draining input buffers, so the buffers stay occupied, which in turn makes the TCP
+ * clients stop reading from their sockets. Backpressure of a slow sink thus propagates
+ * all the way to the sources, rather than growing memory without bounds.
+ *
+ * A message larger than the budget is still accepted when the queue is empty, such that
+ * producers can always make progress.
+ */
+class IpcQueue {
+ public:
+  /**
+   * \brief Construct an IPC queue.
+   * \param max_bytes Maximum number of bytes of messages in the queue, zero for no limit.
+   * \param reserve   Number of items to initially reserve space for.
+   */
+  explicit IpcQueue(size_t max_bytes = 0,
+                    size_t reserve = BOLSON_PUBLISH_IPC_QUEUE_SIZE);
+
+  /**
+   * \brief Enqueue an IPC message, blocking while the queue is full.
+   * \param item     The item to enqueue.
+   * \param shutdown Optional shutdown signal, to stop blocking when asserted.
+   * \return True if the item was enqueued, false if the shutdown signal was asserted.
+   */
+  auto enqueue(IpcQueueItem item, const std::atomic<bool>* shutdown = nullptr) -> bool;
+
+  /// \brief Dequeue an IPC message, if any.
+  auto try_dequeue(IpcQueueItem& item) -> bool;
+
+  /**
+   * \brief Dequeue an IPC message, waiting for one to appear.
+   * \param item    The dequeued item.
+   * \param timeout Maximum time to wait.
+   * \return True if an item was dequeued, false if the timeout expired.
+   */
+  template <typename Rep, typename Period>
+  auto wait_dequeue_timed(IpcQueueItem& item,
+                          const std::chrono::duration<Rep, Period>& timeout) -> bool {
+    if (queue_.wait_dequeue_timed(item, timeout)) {
+      Release(item);
+      return true;
+    }
+    return false;
+  }
+
+  /// \brief Return the approximate number of items in the queue.
+  [[nodiscard]] auto size_approx() const -> size_t { return queue_.size_approx(); }
+  /// \brief Return the number of bytes of messages in the queue.
+  [[nodiscard]] auto bytes() const -> size_t { return bytes_.load(); }
+  /// \brief Return the byte budget of the queue, zero if unbounded.
+  [[nodiscard]] auto max_bytes() const -> size_t { return max_bytes_; }
+  /// \brief Return occupancy metrics of the queue.
+  [[nodiscard]] auto metrics() const -> IpcQueueMetrics;
+
+ private:
+  /// \brief Return the number of bytes an item occupies.
+  static auto SizeOf(const IpcQueueItem& item) -> size_t;
+  /// \brief Account for a dequeued item and wake up blocked producers.
+  void Release(const IpcQueueItem& item);
+
+  /// The underlying queue.
+  moodycamel::BlockingConcurrentQueue<IpcQueueItem> queue_;
+  /// Byte budget.
+  size_t max_bytes_ = 0;
+  /// Number of bytes of messages in the queue.
+  std::atomic<size_t> bytes_ = 0;
+  /// Number of items in the queue.
+  std::atomic<size_t> items_ = 0;
+  /// Mutex for blocked producers and metrics.
+  mutable std::mutex mutex_;
+  /// Condition variable for blocked producers.
+  std::condition_variable not_full_;
+  /// Occupancy metrics.
+  IpcQueueMetrics metrics_;
+};
+
+}  // namespace bolson::publish
@@ -20,11 +20,14 @@
 #include <thread>
 #include <vector>
 
+#include "bolson/client/buffering.h"
 #include "bolson/latency.h"
 #include "bolson/metrics.h"
+#include "bolson/parse/dead_letter.h"
 #include "bolson/publish/publisher.h"
 #include "bolson/status.h"
 #include "bolson/utils.h"
+#include "bolson/wait.h"
 
 namespace bolson {
 
@@ -50,11 +53,25 @@ struct StreamThreads {
   }
 };
 
+auto StreamOptions::ParseInput() -> Status {
+  BOLSON_ROE(ParseWithScale(ipc_queue_max_bytes_str, &ipc_queue_max_bytes));
+  BOLSON_ROE(converter.ParseInput());
+  BOLSON_ROE(client.ParseInput());
+  BOLSON_ROE(affinity.ParseInput());
+  return Status::OK();
+}
+
 /// \brief Log the statistics.
-static auto LogStreamMetrics(const StreamOptions& opt, const StreamTimers& timers,
-                             const illex::BufferingClient& client,
-                             const convert::Converter& converter,
-                             const publish::ConcurrentPublisher& publisher) -> Status {
+static auto LogStreamMetrics(
+    const StreamOptions& opt, const StreamTimers& timers,
+    const std::vector<std::shared_ptr<client::BufferingClient>>& clients,
+    const convert::Converter& converter, const publish::IpcQueue& ipc_queue,
+    const publish::ConcurrentPublisher& publisher) -> Status {
+  // Report the malformed JSONs that were not written to a dead-letter file.
+  if (converter.dead_letters() != nullptr) {
+    parse::LogDeadLetters(converter.dead_letters().get());
+  }
+
   // Report some statistics.
   if (opt.statistics) {
     if (opt.succinct) {
@@ -67,23 +84,47 @@ static auto LogStreamMetrics(const StreamOptions& opt, const StreamTimers& timer
       spdlog::info("  Time                    : {}", timers.init.seconds());
       spdlog::info("  Conversion impl.        : {}", ToString(opt.converter.parser.impl));
       spdlog::info("  Conversion threads      : {}", opt.converter.num_threads);
-      spdlog::info("  TCP clients             : {}", 1);
+      spdlog::info("  Wait strategy           : {}",
+                   ToString(opt.converter.wait.strategy));
+      spdlog::info("  TCP clients             : {}", clients.size());
+      spdlog::info("  TCP client I/O          : {}", client::ToString(opt.client.io));
       opt.pulsar.Log();
 
       // TCP client statistics.
-      auto tcp_MiB = static_cast<double>(client.bytes_received()) / (1024.0 * 1024.0);
-      auto tcp_MB = static_cast<double>(client.bytes_received()) / 1E6;
-      auto tcp_MJs = client.jsons_received() / 1E6;
+      size_t bytes_received = 0;
+      for (const auto& client : clients) {
+        bytes_received += client->bytes_received();
+      }
+      auto jsons_received = client::JSONsReceived(clients);
+      auto tcp_MiB = static_cast<double>(bytes_received) / (1024.0 * 1024.0);
+      auto tcp_MB = static_cast<double>(bytes_received) / 1E6;
+      auto tcp_MJs = jsons_received / 1E6;
 
-      spdlog::info("TCP client:");
-      spdlog::info("  JSONs received          : {}", client.jsons_received());
+      spdlog::info("TCP clients:");
+      spdlog::info("  JSONs received          : {}", jsons_received);
       spdlog::info("  Bytes received          : {} MiB", tcp_MiB);
       spdlog::info("  Time                    : {} s", timers.tcp.seconds());
       spdlog::info("  Throughput              : {} MJ/s", tcp_MJs / timers.tcp.seconds());
       spdlog::info("  Throughput              : {} MB/s", tcp_MB / timers.tcp.seconds());
+      spdlog::info("  Receive syscalls        : {}", client::Syscalls(clients));
+
+      for (size_t c = 0; c < clients.size(); c++) {
+        const auto& client = clients[c];
+        auto c_MB = static_cast<double>(client->bytes_received()) / 1E6;
+        auto c_MJs = client->jsons_received() / 1E6;
+        auto c_t = client->receive_time();
+        spdlog::info("  Connection {} ({}:{}):", c, client->endpoint().host,
+                     client->endpoint().port);
+        spdlog::info("    JSONs received        : {}", client->jsons_received());
+        spdlog::info("    Time                  : {} s", c_t);
+        spdlog::info("    Throughput            : {} MJ/s", c_MJs / c_t);
+        spdlog::info("    Throughput            : {} MB/s", c_MB / c_t);
+      }
 
       spdlog::info("JSONs to IPC conversion:");
       LogConvertMetrics(c, "  ");
+      LogNumaMetrics(converter.metrics(), "  ");
+      publish::LogIpcQueueMetrics(ipc_queue.metrics(), ipc_queue.max_bytes(), "  ");
 
       // Pulsar producer / publishing statistics
       auto pub_MJs = p.rows / 1E6;
@@ -121,16 +162,18 @@ static auto LogStreamMetrics(const StreamOptions& opt, const StreamTimers& timer
 auto ProduceFromStream(const StreamOptions& opt) -> Status {
   StreamThreads threads;  // Management of all threads.
   StreamTimers timers;    // Performance metric timers.
-  publish::IpcQueue ipc_queue(
-      BOLSON_PUBLISH_IPC_QUEUE_SIZE);  // IPC queue to Pulsar producer.
+  publish::IpcQueue ipc_queue(opt.ipc_queue_max_bytes);  // IPC queue to Pulsar producer.
 
-  illex::BufferingClient client;                            // TCP client.
+  std::vector<std::shared_ptr<client::BufferingClient>> clients;  // TCP clients.
+  std::atomic<uint64_t> seq = 0;  // Sequence number counter shared by all clients.
   std::shared_ptr<convert::Converter> converter;            // Converters.
   std::shared_ptr<publish::ConcurrentPublisher> publisher;  // Pulsar producers.
 
   timers.init.Start();
   spdlog::info("Initializing converter(s)...");
-  BOLSON_ROE(convert::Converter::Make(opt.converter, &ipc_queue, &converter));
+  convert::ConverterOptions converter_options = opt.converter;
+  converter_options.affinity = opt.affinity;
+  BOLSON_ROE(convert::Converter::Make(converter_options, &ipc_queue, &converter));
 
   // Get the schema that the parsers will attempt to parse.
   publish::Options pulsar_options = opt.pulsar;
@@ -140,39 +183,47 @@ auto ProduceFromStream(const StreamOptions& opt) -> Status {
   BOLSON_ROE(publish::ConcurrentPublisher::Make(pulsar_options, &ipc_queue,
                                                 &threads.publish_count, &publisher));
 
-  spdlog::info("Initializing stream source client...");
-  BILLEX_ROE(illex::BufferingClient::Create(
-      opt.client, converter->parser_context()->mutable_buffers(),
-      converter->parser_context()->mutexes(), &client));
+  spdlog::info("Initializing stream source client(s)...");
+  if (opt.client.ring) {
+    // One ring per connection, in the same round-robin order as client buffers.
+    BOLSON_ROE(converter->parser_context()->EnableRingBuffers(
+        opt.client.endpoints.size(), opt.client.ring_hugepages));
+  }
+  BOLSON_ROE(client::CreateClients(opt.client, converter->parser_context().get(), &seq,
+                                   &clients));
   timers.init.Stop();
 
   spdlog::info("Starting JSON-to-Arrow converter thread(s)...");
-  converter->Start(&threads.shutdown);
+  SHUTDOWN_ON_FAILURE(converter->Start(&threads.shutdown));
 
   spdlog::info("Starting Pulsar publish thread(s)...");
-  publisher->Start(&threads.shutdown);
+  SHUTDOWN_ON_FAILURE(publisher->Start(&threads.shutdown, opt.affinity));
 
   spdlog::info("Receiving, converting, and publishing JSONs...");
-  // Receive JSONs (blocking) until the server closes the connection.
+  // Receive JSONs (blocking) until all servers close their connection.
   // Concurrently, the conversion and publish thread will do their job.
   timers.tcp.Start();
-  SHUTDOWN_ON_FAILURE(client.ReceiveJSONs());
+  SHUTDOWN_ON_FAILURE(
+      Aggregate(client::ReceiveJSONs(clients, opt.client.io, opt.affinity,
+                                     opt.converter.wait),
+                "Client "));
   timers.tcp.Stop();
-  SHUTDOWN_ON_FAILURE(client.Close());
+  SHUTDOWN_ON_FAILURE(client::Close(clients));
 
-  spdlog::info("Source server disconnected, emptying buffers...");
+  spdlog::info("Source server(s) disconnected, emptying buffers...");
 
   // Once the server disconnects, we can work towards finishing this function.
   // Wait until all JSONs have been published, or if either the publish or converter
   // thread have asserted the shutdown signal, the latter indicating some error.
-  while ((client.jsons_received() != threads.publish_count.load()) &&
+  Waiter waiter(opt.converter.wait);
+  const auto jsons_received = client::JSONsReceived(clients);
+  while ((jsons_received != threads.publish_count.load()) &&
          !threads.shutdown.load()) {
-    // Sleep this thread for a bit.
-    std::this_thread::sleep_for(std::chrono::milliseconds(BOLSON_QUEUE_WAIT_US));
+    waiter.Wait();
 #ifndef NDEBUG
     // Sleep a bit longer in debug.
     std::this_thread::sleep_for(std::chrono::milliseconds(100 * BOLSON_QUEUE_WAIT_US));
-    SPDLOG_DEBUG("Received: {}, Published: {}", client.jsons_received(),
+    SPDLOG_DEBUG("Received: {}, Published: {}", jsons_received,
                  threads.publish_count.load());
 #endif
   }
@@ -182,7 +233,7 @@ auto ProduceFromStream(const StreamOptions& opt) -> Status {
   BOLSON_ROE(threads.Shutdown(converter, publisher));
   spdlog::info("----------------------------------------------------------------");
 
-  BOLSON_ROE(LogStreamMetrics(opt, timers, client, *converter, *publisher));
+  BOLSON_ROE(LogStreamMetrics(opt, timers, clients, *converter, ipc_queue, *publisher));
 
   return Status::OK();
 }
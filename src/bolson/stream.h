@@ -21,6 +21,8 @@
 #include <utility>
 #include <variant>
 
+#include "bolson/affinity.h"
+#include "bolson/client/buffering.h"
 #include "bolson/convert/converter.h"
 #include "bolson/latency.h"
 #include "bolson/publish/publisher.h"
@@ -30,7 +32,7 @@ namespace bolson {
 /// Stream subcommand options.
 struct StreamOptions {
   /// The client options.
-  illex::ClientOptions client;
+  client::ClientOptions client;
   /// The Pulsar options.
   publish::Options pulsar;
   /// Enable statistics.
@@ -41,8 +43,16 @@ struct StreamOptions {
   std::string metrics_file;
   /// Whether to produce succinct statistics.
   bool succinct = false;
+  /// Maximum number of bytes of IPC messages waiting to be published.
+  std::string ipc_queue_max_bytes_str;
+  size_t ipc_queue_max_bytes = 0;
   /// Options related to conversion.
   convert::ConverterOptions converter;
+  /// CPU affinity of client, converter and publisher threads.
+  AffinityOptions affinity;
+
+  /// Parse string fields to useful values.
+  auto ParseInput() -> Status;
 };
 
 /**
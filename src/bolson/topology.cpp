@@ -0,0 +1,118 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/topology.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace bolson {
+
+auto ParseCpuList(const std::string& list, std::vector<size_t>* out) -> Status {
+  out->clear();
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    // Remove surrounding whitespace, e.g. the newline at the end of sysfs files.
+    range.erase(0, range.find_first_not_of(" \t\n"));
+    range.erase(range.find_last_not_of(" \t\n") + 1);
+    if (range.empty()) {
+      continue;
+    }
+    try {
+      auto dash = range.find('-');
+      size_t first = std::stoul(range.substr(0, dash));
+      size_t last = first;
+      if (dash != std::string::npos) {
+        last = std::stoul(range.substr(dash + 1));
+      }
+      if (last < first) {
+        return Status(Error::CLIError, "Invalid CPU range " + range);
+      }
+      for (size_t c = first; c <= last; c++) {
+        out->push_back(c);
+      }
+    } catch (const std::exception&) {
+      return Status(Error::CLIError, "Invalid CPU list " + list);
+    }
+  }
+  return Status::OK();
+}
+
+auto NumaNodes(std::vector<NumaNode>* out) -> Status {
+  namespace fs = std::filesystem;
+  out->clear();
+  const fs::path root = "/sys/devices/system/node";
+  std::error_code ec;
+  if (fs::is_directory(root, ec)) {
+    for (const auto& entry : fs::directory_iterator(root, ec)) {
+      auto name = entry.path().filename().string();
+      if ((name.rfind("node", 0) != 0) || (name.size() == 4) ||
+          (name.find_first_not_of("0123456789", 4) != std::string::npos)) {
+        continue;
+      }
+      std::ifstream ifs(entry.path() / "cpulist");
+      std::string list;
+      std::getline(ifs, list);
+      NumaNode node;
+      node.id = std::stoul(name.substr(4));
+      BOLSON_ROE(ParseCpuList(list, &node.cpus));
+      // Skip memory-only nodes.
+      if (!node.cpus.empty()) {
+        out->push_back(node);
+      }
+    }
+  }
+  std::sort(out->begin(), out->end(),
+            [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+
+  if (out->empty()) {
+    NumaNode node;
+    for (size_t c = 0; c < std::thread::hardware_concurrency(); c++) {
+      node.cpus.push_back(c);
+    }
+    out->push_back(node);
+  }
+  return Status::OK();
+}
+
+static auto PinThread(pthread_t thread, const std::vector<size_t>& cpus) -> Status {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto c : cpus) {
+    CPU_SET(c, &set);
+  }
+  auto ret = pthread_setaffinity_np(thread, sizeof(set), &set);
+  if (ret != 0) {
+    return Status(Error::GenericError,
+                  std::string("Unable to set thread affinity: ") + std::strerror(ret));
+  }
+  return Status::OK();
+}
+
+auto PinThread(const std::vector<size_t>& cpus) -> Status {
+  return PinThread(pthread_self(), cpus);
+}
+
+auto PinThread(std::thread* thread, const std::vector<size_t>& cpus) -> Status {
+  return PinThread(thread->native_handle(), cpus);
+}
+
+}  // namespace bolson
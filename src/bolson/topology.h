@@ -0,0 +1,58 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bolson/status.h"
+
+namespace bolson {
+
+/// A NUMA node and the CPUs it contains.
+struct NumaNode {
+  /// The NUMA node number.
+  size_t id = 0;
+  /// The CPUs on this node.
+  std::vector<size_t> cpus;
+};
+
+/**
+ * \brief Parse a CPU list such as "0-3,8,10-11".
+ * \param list The CPU list.
+ * \param out  The CPU numbers in the list.
+ * \return Status::OK() if successful, some error otherwise.
+ */
+auto ParseCpuList(const std::string& list, std::vector<size_t>* out) -> Status;
+
+/**
+ * \brief Discover the NUMA nodes of this machine.
+ *
+ * Nodes are read from sysfs. If sysfs does not expose any node, a single node holding all
+ * CPUs is returned.
+ *
+ * \param out The NUMA nodes that have CPUs.
+ * \return Status::OK() if successful, some error otherwise.
+ */
+auto NumaNodes(std::vector<NumaNode>* out) -> Status;
+
+/// \brief Pin the calling thread to a set of CPUs.
+auto PinThread(const std::vector<size_t>& cpus) -> Status;
+
+/// \brief Pin a thread to a set of CPUs.
+auto PinThread(std::thread* thread, const std::vector<size_t>& cpus) -> Status;
+
+}  // namespace bolson
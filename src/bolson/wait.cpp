@@ -0,0 +1,107 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bolson/wait.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <climits>
+#include <ctime>
+#include <thread>
+
+#include "bolson/latency.h"
+
+namespace bolson {
+
+/// \brief Hint the CPU that we are in a spin loop.
+static inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+void Waiter::Wait() {
+  switch (opts_.strategy) {
+    case WaitStrategy::SLEEP:
+      std::this_thread::sleep_for(std::chrono::microseconds(BOLSON_QUEUE_WAIT_US));
+      break;
+    case WaitStrategy::SPIN:
+      CpuRelax();
+      break;
+    case WaitStrategy::SPIN_YIELD:
+      if (spins_ < opts_.spin_limit) {
+        spins_++;
+        CpuRelax();
+      } else {
+        std::this_thread::yield();
+      }
+      break;
+    case WaitStrategy::PARK: {
+      timespec timeout{};
+      timeout.tv_sec = static_cast<time_t>(opts_.park_timeout_us / 1000000);
+      timeout.tv_nsec = static_cast<long>((opts_.park_timeout_us % 1000000) * 1000);
+      // Returns immediately if the signal was notified after the last Wait().
+      signal_->parked_.fetch_add(1);
+      syscall(SYS_futex, reinterpret_cast<uint32_t*>(&signal_->word_), FUTEX_WAIT_PRIVATE,
+              seen_, &timeout, nullptr, 0);
+      signal_->parked_.fetch_sub(1);
+      seen_ = signal_->word_.load();
+      break;
+    }
+  }
+}
+
+void WakeSignal::Notify() {
+  word_.fetch_add(1);
+  if (parked_.load() > 0) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word_), FUTEX_WAKE_PRIVATE, INT_MAX,
+            nullptr, nullptr, 0);
+  }
+}
+
+auto ToString(const WaitStrategy& strategy) -> std::string {
+  switch (strategy) {
+    case WaitStrategy::SLEEP:
+      return "sleep";
+    case WaitStrategy::SPIN:
+      return "spin";
+    case WaitStrategy::SPIN_YIELD:
+      return "spin-yield";
+    case WaitStrategy::PARK:
+      return "park";
+  }
+  return "Corrupt bolson::WaitStrategy enum value.";
+}
+
+void AddWaitOptionsToCLI(CLI::App* sub, WaitOptions* opts) {
+  sub->add_option("--wait", opts->strategy,
+                  "Strategy for threads polling for work. sleep: sleep shortly after "
+                  "every poll, spin: busy-spin, spin-yield: busy-spin then yield, park: "
+                  "park the thread in the kernel.")
+      ->transform(
+          CLI::CheckedTransformer(WaitOptions::strategies_map(), CLI::ignore_case))
+      ->default_val(WaitStrategy::SLEEP);
+  sub->add_option("--wait-spin-limit", opts->spin_limit,
+                  "Number of polls to busy-spin before yielding, for spin-yield.")
+      ->default_val(1024);
+  sub->add_option("--wait-park-timeout", opts->park_timeout_us,
+                  "Maximum time in microseconds to park a thread, for park.")
+      ->default_val(100);
+}
+
+}  // namespace bolson
@@ -0,0 +1,152 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <CLI/CLI.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace bolson {
+
+/// Strategies for threads that poll for work or for a status to change.
+enum class WaitStrategy {
+  SLEEP,       ///< Sleep for BOLSON_QUEUE_WAIT_US after every unsuccessful poll.
+  SPIN,        ///< Busy-spin with a CPU pause hint. Lowest latency, burns a core.
+  SPIN_YIELD,  ///< Busy-spin for a bounded number of polls, then yield the core.
+  PARK,        ///< Park the thread in the kernel until woken or a timeout expires.
+};
+
+/// Wait strategy options.
+struct WaitOptions {
+  /// The wait strategy.
+  WaitStrategy strategy = WaitStrategy::SLEEP;
+  /// Number of unsuccessful polls before yielding, when using SPIN_YIELD.
+  size_t spin_limit = 1024;
+  /// Maximum time in microseconds to park a thread, when using PARK.
+  size_t park_timeout_us = 100;
+
+  static auto strategies_map() -> std::map<std::string, WaitStrategy> {
+    static std::map<std::string, WaitStrategy> result = {
+        {"sleep", WaitStrategy::SLEEP},
+        {"spin", WaitStrategy::SPIN},
+        {"spin-yield", WaitStrategy::SPIN_YIELD},
+        {"park", WaitStrategy::PARK}};
+    return result;
+  }
+};
+
+/// \brief Add wait strategy options to a CLI subcommand.
+void AddWaitOptionsToCLI(CLI::App* sub, WaitOptions* opts);
+
+/// \brief Return a human-readable name of a wait strategy.
+auto ToString(const WaitStrategy& strategy) -> std::string;
+
+/**
+ * \brief A signal that producers raise when they make work available.
+ *
+ * Waiters parked on the signal are woken when it is notified. Notifying only makes a
+ * system call when some waiter is parked, so producers can notify on every push.
+ */
+class WakeSignal {
+ public:
+  /// \brief Wake up all waiters parked on this signal.
+  void Notify();
+
+ private:
+  friend class Waiter;
+  /// Futex word, incremented on every notification.
+  std::atomic<uint32_t> word_ = 0;
+  /// Number of parked waiters.
+  std::atomic<uint32_t> parked_ = 0;
+};
+
+/**
+ * \brief Implements a wait strategy for a single polling thread.
+ *
+ * Call Wait() after every unsuccessful poll and Reset() after every successful one.
+ *
+ * Parking is implemented through a futex on the wake signal of the polled condition,
+ * so a parked thread resumes as soon as a producer notifies it, and otherwise after the
+ * park timeout. A notification that arrives between a poll and the next Wait() makes
+ * that Wait() return immediately. When the polled condition has no producer that can
+ * notify the waiter (e.g. an MMIO status register), the waiter has no signal and a
+ * parked thread simply resumes after the park timeout, having released its core to the
+ * kernel in the meantime.
+ */
+class Waiter {
+ public:
+  /**
+   * \brief Construct a waiter.
+   * \param opts   The wait options.
+   * \param signal The signal producers notify when the polled condition may have
+   *               changed, if any.
+   */
+  explicit Waiter(const WaitOptions& opts = {}, WakeSignal* signal = nullptr)
+      : opts_(opts), signal_(signal == nullptr ? &own_ : signal) {
+    seen_ = signal_->word_.load();
+  }
+
+  /// \brief Wait according to the strategy, after an unsuccessful poll.
+  void Wait();
+  /// \brief Reset the spin count, after a successful poll.
+  void Reset() { spins_ = 0; }
+
+  /**
+   * \brief Dequeue an item from a moodycamel::BlockingConcurrentQueue.
+   *
+   * For the SLEEP and PARK strategies, this blocks on the queue's own semaphore, which
+   * is woken by the producer. The spinning strategies poll the queue instead.
+   *
+   * \param queue   The queue to dequeue from.
+   * \param item    The dequeued item.
+   * \param timeout Maximum time to wait for an item.
+   * \return True if an item was dequeued, false if the timeout expired.
+   */
+  template <typename Queue, typename T>
+  auto Dequeue(Queue* queue, T* item, std::chrono::microseconds timeout) -> bool {
+    if ((opts_.strategy == WaitStrategy::SLEEP) ||
+        (opts_.strategy == WaitStrategy::PARK)) {
+      return queue->wait_dequeue_timed(*item, timeout);
+    }
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!queue->try_dequeue(*item)) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      Wait();
+    }
+    Reset();
+    return true;
+  }
+
+  /// \brief Return the wait options.
+  [[nodiscard]] auto options() const -> const WaitOptions& { return opts_; }
+
+ private:
+  WaitOptions opts_;
+  /// Number of unsuccessful polls since the last successful one.
+  size_t spins_ = 0;
+  /// Signal to park on, which is never notified if no signal was supplied.
+  WakeSignal own_;
+  WakeSignal* signal_;
+  /// Value of the futex word of the signal after the last Wait().
+  uint32_t seen_ = 0;
+};
+
+}  // namespace bolson
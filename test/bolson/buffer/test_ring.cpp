@@ -0,0 +1,53 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "bolson/buffer/ring.h"
+
+namespace bolson::buffer {
+
+/// \brief Test whether regions that wrap around the end of the ring are contiguous.
+TEST(Ring, WrapAround) {
+  std::shared_ptr<RingBuffer> ring;
+  ASSERT_TRUE(RingBuffer::Make(1, false, &ring).ok());
+  ASSERT_EQ(ring->capacity(), BOLSON_RING_PAGE_SIZE);
+
+  // Fill all but 4 bytes of the ring, commit and release it.
+  const size_t first = ring->capacity() - 4;
+  std::memset(ring->write_ptr(), 'a', first);
+  ring->Produce(first);
+  ring->Commit(first);
+  ring->Release(first);
+  ASSERT_EQ(ring->writable(), ring->capacity());
+
+  // Write a line that wraps around the end of the ring.
+  const std::string line = "{\"wraps\":1}\n";
+  std::memcpy(ring->write_ptr(), line.data(), line.size());
+  ring->Produce(line.size());
+  ASSERT_EQ(ring->uncommitted(), line.size());
+
+  auto* view = reinterpret_cast<const char*>(ring->Commit(line.size()));
+  ASSERT_EQ(std::string(view, line.size()), line);
+  ASSERT_EQ(ring->writable(), ring->capacity() - line.size());
+
+  // The wrapped part must be visible at the start of the ring.
+  auto* start = reinterpret_cast<const char*>(ring->write_ptr()) - (line.size() - 4);
+  ASSERT_EQ(std::string(start, line.size() - 4), line.substr(4));
+}
+
+}  // namespace bolson::buffer
@@ -0,0 +1,53 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "bolson/client/buffering.h"
+
+namespace bolson::client {
+
+/// \brief Test whether endpoints with host names, IPv4 and IPv6 addresses are parsed.
+TEST(ClientOptions, Endpoints) {
+  ClientOptions opts;
+  opts.port = 10197;
+  opts.endpoints_str = {"localhost:1", "10.0.0.1", "[::1]:2", "[fe80::1]", "::1"};
+  ASSERT_TRUE(opts.ParseInput().ok());
+  ASSERT_EQ(opts.endpoints.size(), 5);
+  ASSERT_EQ(opts.endpoints[0].host, "localhost");
+  ASSERT_EQ(opts.endpoints[0].port, 1);
+  ASSERT_EQ(opts.endpoints[1].host, "10.0.0.1");
+  ASSERT_EQ(opts.endpoints[1].port, 10197);
+  ASSERT_EQ(opts.endpoints[2].host, "::1");
+  ASSERT_EQ(opts.endpoints[2].port, 2);
+  ASSERT_EQ(opts.endpoints[3].host, "fe80::1");
+  ASSERT_EQ(opts.endpoints[3].port, 10197);
+  ASSERT_EQ(opts.endpoints[4].host, "::1");
+  ASSERT_EQ(opts.endpoints[4].port, 10197);
+
+  opts.endpoints_str = {"[::1"};
+  ASSERT_FALSE(opts.ParseInput().ok());
+  opts.endpoints_str = {"[::1]x"};
+  ASSERT_FALSE(opts.ParseInput().ok());
+  opts.endpoints_str = {"[::1]:port"};
+  ASSERT_FALSE(opts.ParseInput().ok());
+  opts.endpoints_str = {"localhost:70000"};
+  ASSERT_FALSE(opts.ParseInput().ok());
+  opts.endpoints_str = {"localhost:80abc"};
+  ASSERT_FALSE(opts.ParseInput().ok());
+  opts.endpoints_str = {"localhost:-1"};
+  ASSERT_FALSE(opts.ParseInput().ok());
+}
+
+}  // namespace bolson::client
@@ -0,0 +1,118 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+
+#include "bolson/client/buffering.h"
+#include "bolson/parse/custom/battery.h"
+
+namespace bolson::client {
+
+/// \brief Open a listening TCP socket on a free loopback port.
+static void Listen(int* fd, uint16_t* port) {
+  *fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(*fd, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  ASSERT_EQ(bind(*fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  ASSERT_EQ(listen(*fd, 1), 0);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(getsockname(*fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+  *port = ntohs(addr.sin_port);
+}
+
+/// \brief Test whether a client receives more data than fits its ring, by filling
+///        views onto the ring and reclaiming them once they are parsed.
+TEST(BufferingClient, RingViews) {
+  // Two buffers sharing a single ring of one page.
+  parse::custom::BatteryOptions opts;
+  opts.num_buffers = 2;
+  std::shared_ptr<parse::ParserContext> context;
+  ASSERT_TRUE(parse::custom::BatteryParserContext::Make(opts, 1, BOLSON_RING_PAGE_SIZE,
+                                                         &context)
+                  .ok());
+  ASSERT_TRUE(context->EnableRingBuffers(1, false).ok());
+  ASSERT_EQ(context->ring(0)->capacity(), BOLSON_RING_PAGE_SIZE);
+
+  int server = -1;
+  uint16_t port = 0;
+  Listen(&server, &port);
+  illex::ClientOptions endpoint;
+  endpoint.host = "127.0.0.1";
+  endpoint.port = port;
+  std::atomic<uint64_t> seq = 0;
+  std::shared_ptr<BufferingClient> client;
+  ASSERT_TRUE(
+      BufferingClient::Create(endpoint, context.get(), {0, 1}, &seq, &client).ok());
+  ASSERT_TRUE(client->uses_ring());
+  int conn = accept(server, nullptr, nullptr);
+  ASSERT_GE(conn, 0);
+
+  // Send lines adding up to several times the ring capacity, so views wrap around.
+  std::string sent;
+  size_t num_lines = 0;
+  while (sent.size() < 4 * BOLSON_RING_PAGE_SIZE) {
+    sent += "{\"voltage\":[" + std::to_string(num_lines) + "]}\n";
+    num_lines++;
+  }
+  auto sender = std::async(std::launch::async, [&]() {
+    for (size_t pos = 0; pos < sent.size(); pos += 1000) {
+      auto len = std::min<size_t>(1000, sent.size() - pos);
+      EXPECT_EQ(send(conn, sent.data() + pos, len, 0), static_cast<ssize_t>(len));
+    }
+    close(conn);
+  });
+  auto receiver =
+      std::async(std::launch::async, [&]() { return client->ReceiveJSONs(); });
+
+  // Act as a converter, taking the filled buffers and resetting them.
+  std::string received;
+  uint64_t next_seq = 0;
+  auto buffers = context->mutable_buffers();
+  auto mutexes = context->mutexes();
+  while (received.size() < sent.size()) {
+    size_t idx = 0;
+    ASSERT_TRUE(
+        context->ready_queue()->wait_dequeue_timed(idx, std::chrono::seconds(5)));
+    mutexes[idx]->lock();
+    auto* buf = buffers[idx];
+    ASSERT_EQ(buf->range().first, next_seq);
+    next_seq = buf->range().last + 1;
+    received.append(reinterpret_cast<const char*>(buf->data()), buf->size());
+    buf->Reset();
+    mutexes[idx]->unlock();
+    context->free_signal()->Notify();
+  }
+  sender.get();
+  ASSERT_TRUE(receiver.get().ok());
+  ASSERT_TRUE(client->Close().ok());
+  close(server);
+
+  ASSERT_EQ(received, sent);
+  ASSERT_EQ(next_seq, num_lines);
+  ASSERT_EQ(client->jsons_received(), num_lines);
+}
+
+}  // namespace bolson::client
@@ -0,0 +1,82 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "bolson/convert/buffer_pool.h"
+#include "bolson/convert/serializer.h"
+
+namespace bolson::convert {
+
+/// \brief Test whether released buffers are reused by their size class.
+TEST(BufferPool, Reuse) {
+  auto pool = std::make_shared<BufferPool>(1024 * 1024);
+  std::shared_ptr<arrow::Buffer> buffer;
+  bool allocated = false;
+  ASSERT_TRUE(pool->Acquire(5000, &buffer, &allocated).ok());
+  ASSERT_TRUE(allocated);
+  ASSERT_EQ(buffer->size(), 8192);
+  const uint8_t* data = buffer->data();
+
+  buffer = nullptr;
+  ASSERT_EQ(pool->idle_bytes(), 8192);
+  ASSERT_TRUE(pool->Acquire(8192, &buffer, &allocated).ok());
+  ASSERT_FALSE(allocated);
+  ASSERT_EQ(buffer->data(), data);
+
+  // Another size class.
+  std::shared_ptr<arrow::Buffer> other;
+  ASSERT_TRUE(pool->Acquire(1, &other, &allocated).ok());
+  ASSERT_TRUE(allocated);
+  ASSERT_EQ(other->size(), 4096);
+
+  // Buffers may outlive the pool.
+  pool = nullptr;
+  buffer = nullptr;
+}
+
+/// \brief Test whether messages written into pooled buffers can be read back.
+TEST(BufferPool, Serializer) {
+  arrow::UInt64Builder builder;
+  for (uint64_t i = 0; i < 100; i++) {
+    ASSERT_TRUE(builder.Append(i).ok());
+  }
+  std::shared_ptr<arrow::Array> column;
+  ASSERT_TRUE(builder.Finish(&column).ok());
+  auto schema = arrow::schema({arrow::field("seq", arrow::uint64(), false)});
+  auto batch = arrow::RecordBatch::Make(schema, 100, {column});
+
+  Serializer serializer(1024 * 1024, nullptr, std::make_shared<BufferPool>(1024 * 1024));
+  for (int i = 0; i < 3; i++) {
+    SerializedBatches serialized;
+    ASSERT_TRUE(serializer.Serialize({{batch, {0, 99}}}, &serialized).ok());
+    ASSERT_EQ(serialized.size(), 1);
+
+    arrow::io::BufferReader reader(serialized[0].message);
+    auto read = arrow::ipc::ReadRecordBatch(schema, nullptr,
+                                            arrow::ipc::IpcReadOptions::Defaults(),
+                                            &reader);
+    ASSERT_TRUE(read.ok());
+    ASSERT_TRUE(read.ValueOrDie()->Equals(*batch));
+  }
+  // Every message was released before the next, so only the first one allocated.
+  ASSERT_EQ(serializer.num_allocations(), 1);
+}
+
+}  // namespace bolson::convert
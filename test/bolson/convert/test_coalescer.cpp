@@ -0,0 +1,130 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arrow/api.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "bolson/convert/coalescer.h"
+
+namespace bolson::convert {
+
+/// \brief Return a parsed batch with a column holding the sequence numbers of a range.
+static auto MakeParsed(uint64_t first, uint64_t last) -> parse::ParsedBatch {
+  arrow::UInt64Builder seq;
+  for (uint64_t i = first; i <= last; i++) {
+    EXPECT_TRUE(seq.Append(i).ok());
+  }
+  std::shared_ptr<arrow::Array> column;
+  EXPECT_TRUE(seq.Finish(&column).ok());
+  auto schema = arrow::schema({arrow::field("seq", arrow::uint64(), false)});
+  return {arrow::RecordBatch::Make(schema, column->length(), {column}), {first, last}};
+}
+
+/// \brief Return time points of a batch received at some time.
+static auto MakeTimePoints(illex::TimePoint received) -> TimePoints {
+  TimePoints result;
+  result[TimePoints::received] = received;
+  result[TimePoints::parsed] = received + std::chrono::microseconds(1);
+  return result;
+}
+
+/// \brief Test whether batches are coalesced up to the target number of rows.
+TEST(Coalescer, TargetRows) {
+  CoalesceOptions opts;
+  opts.linger_us = 1000000;
+  opts.target_rows = 10;
+  Coalescer coalescer(opts, 1024, 0);
+  auto now = illex::Timer::now();
+  auto earlier = now - std::chrono::seconds(1);
+
+  std::vector<CoalescedBatch> out;
+  // Batches of different threads arrive out of order.
+  ASSERT_TRUE(coalescer.Push(MakeParsed(4, 7), MakeTimePoints(now), &out).ok());
+  ASSERT_TRUE(coalescer.Push(MakeParsed(0, 3), MakeTimePoints(earlier), &out).ok());
+  ASSERT_TRUE(coalescer.Poll(false, &out).ok());
+  ASSERT_TRUE(out.empty());
+  // This batch does not fit, so the pending batches are taken first.
+  ASSERT_TRUE(coalescer.Push(MakeParsed(8, 11), MakeTimePoints(now), &out).ok());
+  ASSERT_EQ(out.size(), 1);
+
+  const auto& merged = out[0].parsed;
+  ASSERT_EQ(merged.batch->num_rows(), 8);
+  ASSERT_EQ(merged.seq_range.first, 0);
+  ASSERT_EQ(merged.seq_range.last, 7);
+  const auto& seq = static_cast<const arrow::UInt64Array&>(*merged.batch->column(0));
+  for (int64_t i = 0; i < seq.length(); i++) {
+    ASSERT_EQ(seq.Value(i), i);
+  }
+  // Latency is measured from the part that was received first.
+  ASSERT_TRUE(out[0].time_points[TimePoints::received] == earlier);
+  ASSERT_TRUE(out[0].time_points[TimePoints::parsed] ==
+              earlier + std::chrono::microseconds(1));
+
+  // Flushing takes the remaining batches.
+  ASSERT_TRUE(coalescer.Push(MakeParsed(12, 13), MakeTimePoints(now), &out).ok());
+  ASSERT_TRUE(coalescer.Poll(true, &out).ok());
+  ASSERT_EQ(out.size(), 2);
+  ASSERT_EQ(out[1].parsed.seq_range.first, 8);
+  ASSERT_EQ(out[1].parsed.seq_range.last, 13);
+  ASSERT_EQ(out[1].parsed.batch->num_rows(), 6);
+}
+
+/// \brief Test whether only batches with contiguous sequence numbers are concatenated.
+TEST(Coalescer, Gaps) {
+  CoalesceOptions opts;
+  opts.linger_us = 1000000;
+  Coalescer coalescer(opts, 0, 0);
+  auto now = illex::Timer::now();
+
+  std::vector<CoalescedBatch> out;
+  ASSERT_TRUE(coalescer.Push(MakeParsed(20, 21), MakeTimePoints(now), &out).ok());
+  ASSERT_TRUE(coalescer.Push(MakeParsed(0, 3), MakeTimePoints(now), &out).ok());
+  ASSERT_TRUE(coalescer.Push(MakeParsed(4, 9), MakeTimePoints(now), &out).ok());
+  ASSERT_TRUE(coalescer.Poll(true, &out).ok());
+  ASSERT_EQ(out.size(), 2);
+  // Every range holds exactly the rows of its batch.
+  for (const auto& batch : out) {
+    const auto& range = batch.parsed.seq_range;
+    ASSERT_EQ(range.last - range.first + 1,
+              static_cast<uint64_t>(batch.parsed.batch->num_rows()));
+  }
+  ASSERT_EQ(out[0].parsed.seq_range.first, 0);
+  ASSERT_EQ(out[0].parsed.seq_range.last, 9);
+  ASSERT_EQ(out[1].parsed.seq_range.first, 20);
+  ASSERT_EQ(out[1].parsed.seq_range.last, 21);
+}
+
+/// \brief Test whether pending batches are taken after lingering for the maximum time.
+TEST(Coalescer, Linger) {
+  CoalesceOptions opts;
+  opts.linger_us = 1000;
+  Coalescer coalescer(opts, 0, 0);
+  auto received = illex::Timer::now();
+
+  std::vector<CoalescedBatch> out;
+  ASSERT_TRUE(coalescer.Push(MakeParsed(0, 3), MakeTimePoints(received), &out).ok());
+  ASSERT_TRUE(coalescer.Poll(false, &out).ok());
+  ASSERT_TRUE(out.empty());
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  ASSERT_TRUE(coalescer.Poll(false, &out).ok());
+  ASSERT_EQ(out.size(), 1);
+  ASSERT_EQ(out[0].parsed.batch->num_rows(), 4);
+  ASSERT_TRUE(out[0].time_points[TimePoints::received] == received);
+}
+
+}  // namespace bolson::convert
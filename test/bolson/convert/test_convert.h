@@ -64,6 +64,7 @@ auto Convert(const ConverterOptions& opts, const std::vector<illex::JSONItem>& i
   std::shared_ptr<Converter> conv;
   BOLSON_ROE(Converter::Make(opts, &out_queue, &conv));
   BOLSON_ROE(FillBuffers(conv->parser_context()->mutable_buffers(), in));
+  conv->parser_context()->SignalFilledBuffers();
   std::atomic<bool> shutdown = false;
   conv->Start(&shutdown);
 
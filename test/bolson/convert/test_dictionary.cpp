@@ -0,0 +1,126 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "bolson/convert/dictionary.h"
+#include "bolson/convert/serializer.h"
+
+namespace bolson::convert {
+
+/// \brief Test whether equal strings get equal indices, also when the table grows.
+TEST(Dictionary, StringTable) {
+  StringTable table(1);
+  std::vector<std::string> values;
+  for (int i = 0; i < 1000; i++) {
+    values.push_back("value " + std::to_string(i));
+  }
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < 1000; i++) {
+      ASSERT_EQ(table.Insert(values[i]), i);
+    }
+  }
+  ASSERT_EQ(table.size(), 1000);
+  ASSERT_EQ(table.Insert(""), 1000);
+  ASSERT_EQ(table.values()[1000], "");
+  // Empty strings may have no data at all.
+  ASSERT_EQ(table.Insert(std::string_view()), 1000);
+}
+
+/// \brief Test encoding of tagged and auto-detected columns, and their serialization.
+TEST(Dictionary, Encode) {
+  auto tagged = arrow::key_value_metadata({kDictionaryMetaKey}, {"true"});
+  auto schema =
+      arrow::schema({arrow::field("tagged", arrow::utf8())->WithMetadata(tagged),
+                     arrow::field("few", arrow::utf8()),
+                     arrow::field("many", arrow::utf8())});
+
+  arrow::StringBuilder tagged_builder;
+  arrow::StringBuilder few_builder;
+  arrow::StringBuilder many_builder;
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(tagged_builder.Append(std::to_string(i)).ok());
+    ASSERT_TRUE(few_builder.Append(i % 2 == 0 ? "even" : "odd").ok());
+    ASSERT_TRUE(many_builder.Append(std::to_string(i)).ok());
+  }
+  std::vector<std::shared_ptr<arrow::Array>> columns(3);
+  ASSERT_TRUE(tagged_builder.Finish(&columns[0]).ok());
+  ASSERT_TRUE(few_builder.Finish(&columns[1]).ok());
+  ASSERT_TRUE(many_builder.Finish(&columns[2]).ok());
+  auto batch = arrow::RecordBatch::Make(schema, 100, columns);
+
+  DictionaryOptions opts;
+  opts.auto_detect = true;
+  std::shared_ptr<DictionaryEncoder> encoder;
+  ASSERT_TRUE(DictionaryEncoder::Make(*schema, opts, &encoder).ok());
+  ASSERT_NE(encoder, nullptr);
+  std::shared_ptr<arrow::RecordBatch> encoded;
+  ASSERT_TRUE(encoder->Encode(batch, &encoded).ok());
+  ASSERT_EQ(encoded->column(0)->type_id(), arrow::Type::DICTIONARY);
+  ASSERT_EQ(encoded->column(1)->type_id(), arrow::Type::DICTIONARY);
+  ASSERT_EQ(encoded->column(2)->type_id(), arrow::Type::STRING);
+  auto few = std::static_pointer_cast<arrow::DictionaryArray>(encoded->column(1));
+  ASSERT_EQ(few->dictionary()->length(), 2);
+
+  // Every message is a stream that decodes to the original strings.
+  Serializer serializer(1024 * 1024, encoder);
+  SerializedBatches serialized;
+  ASSERT_TRUE(serializer.Serialize({{batch, {0, 99}}}, &serialized).ok());
+  ASSERT_EQ(serialized.size(), 1);
+  auto input = std::make_shared<arrow::io::BufferReader>(serialized[0].message);
+  auto reader = arrow::ipc::RecordBatchStreamReader::Open(input).ValueOrDie();
+  std::shared_ptr<arrow::RecordBatch> decoded;
+  ASSERT_TRUE(reader->ReadNext(&decoded).ok());
+  ASSERT_TRUE(decoded->column(1)->Equals(encoded->column(1)));
+
+  // Columns are matched by name, also when a parser inserts a column in front.
+  auto seq = arrow::field("bolson_seq", arrow::uint64(), false);
+  auto with_seq = arrow::RecordBatch::Make(
+      schema->AddField(0, seq).ValueOrDie(), 100,
+      {arrow::MakeArrayFromScalar(arrow::UInt64Scalar(0), 100).ValueOrDie(), columns[0],
+       columns[1], columns[2]});
+  ASSERT_TRUE(encoder->Encode(with_seq, &encoded).ok());
+  ASSERT_EQ(encoded->column(0)->type_id(), arrow::Type::UINT64);
+  ASSERT_EQ(encoded->column(1)->type_id(), arrow::Type::DICTIONARY);
+  ASSERT_EQ(encoded->column(2)->type_id(), arrow::Type::DICTIONARY);
+  ASSERT_EQ(encoded->column(3)->type_id(), arrow::Type::STRING);
+
+  // Batches of which no column was encoded are streams too.
+  auto many = arrow::schema({schema->field(2)});
+  auto plain = arrow::RecordBatch::Make(many, 100, {columns[2]});
+  ASSERT_TRUE(DictionaryEncoder::Make(*many, opts, &encoder).ok());
+  ASSERT_NE(encoder, nullptr);
+  ASSERT_TRUE(encoder->Encode(plain, &encoded).ok());
+  ASSERT_EQ(encoded, plain);
+  Serializer plain_serializer(1024 * 1024, encoder);
+  ASSERT_TRUE(plain_serializer.Serialize({{plain, {0, 99}}}, &serialized).ok());
+  input = std::make_shared<arrow::io::BufferReader>(serialized[0].message);
+  reader = arrow::ipc::RecordBatchStreamReader::Open(input).ValueOrDie();
+  ASSERT_TRUE(reader->ReadNext(&decoded).ok());
+  ASSERT_TRUE(decoded->Equals(*plain));
+
+  // Without tagged fields or auto-detection, no encoder is required.
+  ASSERT_TRUE(DictionaryEncoder::Make(*schema->RemoveField(0).ValueOrDie(),
+                                      DictionaryOptions(), &encoder)
+                  .ok());
+  ASSERT_EQ(encoder, nullptr);
+}
+
+}  // namespace bolson::convert
@@ -0,0 +1,136 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arrow/api.h>
+#include <arrow/ipc/api.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "bolson/convert/resizer.h"
+#include "bolson/convert/serializer.h"
+
+namespace bolson::convert {
+
+static auto MakeBatch(int64_t num_rows) -> std::shared_ptr<arrow::RecordBatch> {
+  auto schema = arrow::schema(
+      {arrow::field("id", arrow::uint64(), false),
+       arrow::field("name", arrow::utf8(), false),
+       arrow::field("values", arrow::list(arrow::field("item", arrow::uint64(), false)),
+                    false)});
+  arrow::UInt64Builder id;
+  arrow::StringBuilder name;
+  arrow::ListBuilder values(arrow::default_memory_pool(),
+                            std::make_shared<arrow::UInt64Builder>());
+  auto* items = static_cast<arrow::UInt64Builder*>(values.value_builder());
+  for (int64_t i = 0; i < num_rows; i++) {
+    EXPECT_TRUE(id.Append(i).ok());
+    // Rows of strongly varying sizes.
+    EXPECT_TRUE(name.Append(std::string(i % 100 == 0 ? 4000 : i % 10, 'x')).ok());
+    EXPECT_TRUE(values.Append().ok());
+    for (int64_t j = 0; j < i % 7; j++) {
+      EXPECT_TRUE(items->Append(j).ok());
+    }
+  }
+  std::vector<std::shared_ptr<arrow::Array>> columns(3);
+  EXPECT_TRUE(id.Finish(&columns[0]).ok());
+  EXPECT_TRUE(name.Finish(&columns[1]).ok());
+  EXPECT_TRUE(values.Finish(&columns[2]).ok());
+  return arrow::RecordBatch::Make(schema, num_rows, columns);
+}
+
+/// \brief Test whether batches are packed up to, but not beyond, the maximum IPC size.
+TEST(Resizer, MaxBytes) {
+  constexpr size_t kMaxBytes = 16 * 1024;
+  auto batch = MakeBatch(1000);
+  Resizer resizer(0, kMaxBytes);
+  ResizedBatches resized;
+  ASSERT_TRUE(resizer.Resize({batch, {0, 999}}, &resized).ok());
+  ASSERT_GT(resized.size(), 1);
+
+  int64_t num_rows = 0;
+  size_t num_bytes = 0;
+  for (const auto& r : resized) {
+    ASSERT_EQ(r.seq_range.first, num_rows);
+    num_rows += r.batch->num_rows();
+    ASSERT_EQ(r.seq_range.last, num_rows - 1);
+    auto size = arrow::ipc::SerializeRecordBatch(*r.batch,
+                                                 arrow::ipc::IpcWriteOptions::Defaults())
+                    .ValueOrDie()
+                    ->size();
+    ASSERT_LE(size, kMaxBytes);
+    num_bytes += size;
+  }
+  ASSERT_EQ(num_rows, 1000);
+  // Messages are reasonably full.
+  ASSERT_GE(num_bytes, resized.size() * kMaxBytes / 2);
+
+  // Batches within both limits are not sliced.
+  ASSERT_TRUE(Resizer(1000, 1024 * 1024).Resize({batch, {0, 999}}, &resized).ok());
+  ASSERT_EQ(resized.size(), 1);
+}
+
+/// \brief Test whether slices around skipped JSONs hold the right sequence numbers.
+TEST(Resizer, Skipped) {
+  // Rows 0..9 hold sequence numbers 1, 2, 3, 5, 6, 7, 8, 9, 10 and 11.
+  parse::ParsedBatch in(MakeBatch(10), {0, 12});
+  in.skipped = {0, 4, 12};
+  ResizedBatches resized;
+  ASSERT_TRUE(Resizer(3, 0).Resize(in, &resized).ok());
+  ASSERT_EQ(resized.size(), 4);
+
+  const std::vector<illex::SeqRange> ranges = {{0, 3}, {4, 7}, {8, 10}, {11, 12}};
+  const std::vector<std::vector<illex::Seq>> skipped = {{0}, {4}, {}, {12}};
+  for (size_t i = 0; i < resized.size(); i++) {
+    ASSERT_EQ(resized[i].seq_range.first, ranges[i].first);
+    ASSERT_EQ(resized[i].seq_range.last, ranges[i].last);
+    ASSERT_EQ(resized[i].skipped, skipped[i]);
+    auto meta = resized[i].batch->schema()->metadata();
+    ASSERT_EQ(meta->Get("bolson_seq_first").ValueOrDie(),
+              std::to_string(ranges[i].first));
+    ASSERT_EQ(meta->Get("bolson_seq_last").ValueOrDie(), std::to_string(ranges[i].last));
+  }
+}
+
+/// \brief Test whether the serializer splits batches exceeding the maximum IPC size.
+TEST(Resizer, SerializerSplits) {
+  auto batch = MakeBatch(1000);
+  Serializer serializer(16 * 1024);
+  SerializedBatches serialized;
+  ASSERT_TRUE(serializer.Serialize({{batch, {0, 999}}}, &serialized).ok());
+  ASSERT_GT(serialized.size(), 1);
+  ASSERT_EQ(serialized.front().seq_range.first, 0);
+  ASSERT_EQ(serialized.back().seq_range.last, 999);
+  for (const auto& s : serialized) {
+    ASSERT_LE(s.message->size(), 16 * 1024);
+  }
+
+  // Split ranges account for every skipped JSON exactly once.
+  parse::ParsedBatch in(batch, {0, 1002});
+  in.skipped = {0, 500, 1002};
+  ASSERT_TRUE(serializer.Serialize({in}, &serialized).ok());
+  uint64_t next = 0;
+  for (const auto& s : serialized) {
+    ASSERT_EQ(s.seq_range.first, next);
+    next = s.seq_range.last + 1;
+  }
+  ASSERT_EQ(next, 1003);
+
+  // A single record exceeding the maximum size cannot be split.
+  ASSERT_FALSE(
+      Serializer(64).Serialize({{batch->Slice(0, 1), {0, 0}}}, &serialized).ok());
+}
+
+}  // namespace bolson::convert
@@ -0,0 +1,72 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arrow/api.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "bolson/parse/custom/codegen.h"
+
+namespace bolson::parse::custom {
+
+static auto Count(const std::string& haystack, const std::string& needle) -> size_t {
+  size_t result = 0;
+  for (auto pos = haystack.find(needle); pos != std::string::npos;
+       pos = haystack.find(needle, pos + 1)) {
+    result++;
+  }
+  return result;
+}
+
+/// \brief Test whether fixed-size lists are unrolled and keys are emitted as constants.
+TEST(Codegen, TripLike) {
+  auto schema = arrow::schema(
+      {arrow::field("vin", arrow::uint64(), false),
+       arrow::field(
+           "sec_in_band",
+           arrow::fixed_size_list(arrow::field("item", arrow::uint64(), false), 12),
+           false)});
+
+  GeneratedSources sources;
+  ASSERT_TRUE(GenerateParser(*schema, "trip", &sources).ok());
+  ASSERT_NE(sources.header.find("namespace bolson::parse::generated::trip"),
+            std::string::npos);
+  ASSERT_NE(sources.source.find("\"sec_in_band\","), std::string::npos);
+  ASSERT_EQ(Count(sources.source, "->UnsafeAppend(cur->UInt64());"), 12);
+  ASSERT_EQ(Count(sources.source, "custom::MemberDispatch::Make("), 1);
+
+  // Lists of strings are not supported.
+  auto strings = arrow::list(arrow::field("item", arrow::utf8(), false));
+  auto unsupported = arrow::schema({arrow::field("s", strings, false)});
+  ASSERT_FALSE(GenerateParser(*unsupported, "strings", &sources).ok());
+}
+
+/// \brief Test whether field metadata, such as dictionary tags, is kept.
+TEST(Codegen, FieldMetadata) {
+  auto tagged = arrow::field("name", arrow::utf8(), false,
+                             arrow::key_value_metadata({"bolson_dictionary"}, {"true"}));
+  auto schema = arrow::schema({arrow::field("id", arrow::uint64(), false), tagged});
+
+  GeneratedSources sources;
+  ASSERT_TRUE(GenerateParser(*schema, "tagged", &sources).ok());
+  ASSERT_NE(sources.source.find("arrow::field(\"name\", arrow::utf8(), false, "
+                                "arrow::key_value_metadata({\"bolson_dictionary\"}, "
+                                "{\"true\"}))"),
+            std::string::npos);
+  ASSERT_NE(sources.source.find("arrow::field(\"id\", arrow::uint64(), false)"),
+            std::string::npos);
+}
+
+}  // namespace bolson::parse::custom
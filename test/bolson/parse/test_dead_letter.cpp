@@ -0,0 +1,75 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "bolson/parse/custom/ndjson.h"
+#include "bolson/parse/dead_letter.h"
+
+namespace bolson::parse::custom {
+
+/// \brief Test whether malformed JSONs are skipped and parsing resumes at the next line.
+TEST(DeadLetter, Resync) {
+  std::string jsons =
+      "{\"x\":0}\n"
+      "{\"x\":1\n"          // missing brace
+      "{\"x\":\"2}\n"       // unterminated string, which confuses the index
+      "{\"x\":3}\n"
+      "{\"y\":4}\n"         // wrong key
+      "{\"x\":5}";
+
+  std::shared_ptr<DeadLetterSink> sink;
+  ASSERT_TRUE(DeadLetterSink::Make(DeadLetterOptions(), &sink).ok());
+
+  StructuralIndex index;
+  std::vector<uint64_t> values;
+  std::vector<size_t> cuts;
+  std::vector<illex::Seq> skipped;
+  auto parse = [&](IndexCursor* cur) {
+    cur->Expect('{');
+    cur->Key("x");
+    values.push_back(cur->UInt64());
+    cur->Expect('}');
+  };
+  auto cut = [&](size_t num_parsed) {
+    cuts.push_back(num_parsed);
+    return Status::OK();
+  };
+
+  ASSERT_TRUE(ParseNDJSONs(jsons.data(), jsons.size(), 10, &index, sink.get(), parse,
+                           cut, &skipped)
+                  .ok());
+  ASSERT_EQ(skipped, std::vector<illex::Seq>({11, 12, 14}));
+  ASSERT_EQ(sink->count(), 3);
+  ASSERT_EQ(cuts, std::vector<size_t>({1, 0, 1}));
+  // Values of malformed objects may have been appended before the cut.
+  ASSERT_EQ(values.back(), 5);
+
+  std::vector<illex::Seq> seqs;
+  DeadLetter letter;
+  while (sink->TryPop(&letter)) {
+    seqs.push_back(letter.seq);
+  }
+  ASSERT_EQ(seqs, std::vector<illex::Seq>({11, 12, 14}));
+
+  // Without sink, the whole buffer fails.
+  ASSERT_FALSE(ParseNDJSONs(jsons.data(), jsons.size(), 10, &index, nullptr, parse, cut,
+                            &skipped)
+                   .ok());
+}
+
+}  // namespace bolson::parse::custom
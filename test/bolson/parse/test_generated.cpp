@@ -0,0 +1,182 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <arrow/api.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "bolson/parse/custom/trip.h"
+#include "bolson/parse/dead_letter.h"
+#include "bolson/parse/generated/trip_test.h"
+
+namespace bolson::parse {
+
+/// \brief Return a trip JSON with values derived from i.
+static auto TripJSON(uint64_t i) -> std::string {
+  auto list = [&](size_t size) {
+    std::string result = "[";
+    for (size_t e = 0; e < size; e++) {
+      result += (e > 0 ? "," : "") + std::to_string(i * 100 + e);
+    }
+    return result + "]";
+  };
+  auto flag = [&](uint64_t bit) { return ((i >> bit) & 1) != 0 ? "true" : "false"; };
+  return "{\"timestamp\":\"2021-01-01T00:00:0" + std::to_string(i % 10) +
+         "Z\",\"timezone\":" + std::to_string(i % 24) +
+         ",\"vin\":" + std::to_string(1000 + i) + ",\"odometer\":" + std::to_string(i) +
+         ",\"hypermiling\":" + flag(0) + ",\"avgspeed\":" + std::to_string(i % 130) +
+         ",\"sec_in_band\":" + list(12) + ",\"miles_in_time_range\":" + list(24) +
+         ",\"const_speed_miles_in_band\":" + list(12) +
+         ",\"vary_speed_miles_in_band\":" + list(12) + ",\"sec_decel\":" + list(10) +
+         ",\"sec_accel\":" + list(10) + ",\"braking\":" + list(6) +
+         ",\"accel\":" + list(6) + ",\"orientation\":" + flag(1) +
+         ",\"small_speed_var\":" + list(13) + ",\"large_speed_var\":" + list(13) +
+         ",\"accel_decel\":" + std::to_string(i % 7) +
+         ",\"speed_changes\":" + std::to_string(i % 11) + "}\n";
+}
+
+/// \brief Return a JSON object with the members of another one in reverse order.
+static auto ReverseMembers(const std::string& json) -> std::string {
+  // Split the members at commas outside of arrays.
+  std::vector<std::string> members(1);
+  int depth = 0;
+  for (char c : json.substr(1, json.rfind('}') - 1)) {
+    depth += c == '[' ? 1 : (c == ']' ? -1 : 0);
+    if ((c == ',') && (depth == 0)) {
+      members.emplace_back();
+    } else {
+      members.back() += c;
+    }
+  }
+  std::string result = "{";
+  for (auto m = members.rbegin(); m != members.rend(); m++) {
+    result += (m != members.rbegin() ? "," : "") + *m;
+  }
+  return result + "}\n";
+}
+
+/// \brief Test whether a parser generated for the trip schema converts the same as the
+///        hand-written trip parser.
+TEST(Generated, Trip) {
+  std::shared_ptr<custom::TripParser> trip;
+  ASSERT_TRUE(custom::TripParser::Make(false, &trip).ok());
+  ASSERT_TRUE(generated::trip_test::schema()->Equals(*trip->output_schema()));
+
+  std::string jsons;
+  for (uint64_t i = 0; i < 100; i++) {
+    jsons += TripJSON(i);
+  }
+  illex::JSONBuffer buf;
+  ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(jsons.data()),
+                                        jsons.size(), &buf)
+                  .ok());
+  ASSERT_TRUE(buf.SetSize(jsons.size()).ok());
+  buf.SetRange({0, 99});
+
+  std::shared_ptr<generated::trip_test::GeneratedParser> parser;
+  ASSERT_TRUE(generated::trip_test::GeneratedParser::Make(&parser).ok());
+  ParsedBatch expected;
+  ParsedBatch actual;
+  ASSERT_TRUE(trip->ParseOne(&buf, &expected).ok());
+  ASSERT_TRUE(parser->ParseOne(&buf, &actual).ok());
+  ASSERT_EQ(actual.batch->num_rows(), 100);
+  ASSERT_TRUE(actual.batch->ValidateFull().ok());
+  ASSERT_TRUE(actual.batch->Equals(*expected.batch));
+  ASSERT_EQ(actual.seq_range.first, expected.seq_range.first);
+  ASSERT_EQ(actual.seq_range.last, expected.seq_range.last);
+}
+
+/// \brief Test whether trips after a partially parsed malformed trip are kept, by both
+///        the generated and the hand-written trip parser.
+TEST(Generated, Tolerant) {
+  std::shared_ptr<DeadLetterSink> sink;
+  ASSERT_TRUE(DeadLetterSink::Make(DeadLetterOptions(), &sink).ok());
+  std::shared_ptr<custom::TripParser> trip;
+  ASSERT_TRUE(custom::TripParser::Make(false, &trip).ok());
+  trip->set_dead_letters(sink);
+  std::shared_ptr<generated::trip_test::GeneratedParser> parser;
+  ASSERT_TRUE(generated::trip_test::GeneratedParser::Make(&parser).ok());
+  parser->set_dead_letters(sink);
+
+  // The malformed trip fails after its first member.
+  std::string jsons = TripJSON(0) +
+                      "{\"timestamp\":\"2021-01-01T00:00:01Z\",\"timezone\":}\n" +
+                      TripJSON(2);
+  illex::JSONBuffer buf;
+  ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(jsons.data()),
+                                        jsons.size(), &buf)
+                  .ok());
+  ASSERT_TRUE(buf.SetSize(jsons.size()).ok());
+  buf.SetRange({0, 2});
+
+  for (int i = 0; i < 2; i++) {
+    ParsedBatch expected;
+    ParsedBatch actual;
+    ASSERT_TRUE(trip->ParseOne(&buf, &expected).ok());
+    ASSERT_TRUE(parser->ParseOne(&buf, &actual).ok());
+    ASSERT_EQ(expected.skipped, std::vector<illex::Seq>({1}));
+    ASSERT_EQ(actual.skipped, std::vector<illex::Seq>({1}));
+    ASSERT_EQ(expected.batch->num_rows(), 2);
+    ASSERT_TRUE(expected.batch->ValidateFull().ok());
+    ASSERT_TRUE(actual.batch->Equals(*expected.batch));
+    auto vin = std::static_pointer_cast<arrow::UInt64Array>(
+        expected.batch->GetColumnByName("vin"));
+    ASSERT_EQ(vin->Value(0), 1000);
+    ASSERT_EQ(vin->Value(1), 1002);
+  }
+  ASSERT_EQ(sink->count(), 4);
+}
+
+/// \brief Test whether trip members in any order are parsed by both the generated and
+///        the hand-written trip parser.
+TEST(Generated, MemberOrder) {
+  std::shared_ptr<custom::TripParser> trip;
+  ASSERT_TRUE(custom::TripParser::Make(false, &trip).ok());
+  std::shared_ptr<generated::trip_test::GeneratedParser> parser;
+  ASSERT_TRUE(generated::trip_test::GeneratedParser::Make(&parser).ok());
+
+  std::string ordered;
+  std::string reversed;
+  for (uint64_t i = 0; i < 10; i++) {
+    ordered += TripJSON(i);
+    reversed += i % 2 == 0 ? TripJSON(i) : ReverseMembers(TripJSON(i));
+  }
+
+  auto parse = [&](Parser* p, std::string* jsons, ParsedBatch* out) {
+    illex::JSONBuffer buf;
+    ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(jsons->data()),
+                                          jsons->size(), &buf)
+                    .ok());
+    ASSERT_TRUE(buf.SetSize(jsons->size()).ok());
+    std::vector<ParsedBatch> batches;
+    ASSERT_TRUE(p->Parse({&buf}, &batches).ok());
+    ASSERT_EQ(batches.size(), 1);
+    *out = batches[0];
+  };
+  ParsedBatch expected;
+  parse(trip.get(), &ordered, &expected);
+  ASSERT_EQ(expected.batch->num_rows(), 10);
+  std::vector<Parser*> parsers = {trip.get(), parser.get()};
+  for (auto* p : parsers) {
+    ParsedBatch actual;
+    parse(p, &reversed, &actual);
+    ASSERT_TRUE(actual.batch->ValidateFull().ok());
+    ASSERT_TRUE(actual.batch->Equals(*expected.batch));
+  }
+}
+
+}  // namespace bolson::parse
@@ -0,0 +1,238 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arrow/api.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "bolson/parse/custom/generic.h"
+#include "bolson/parse/dead_letter.h"
+
+namespace bolson::parse::custom {
+
+/// \brief Test whether a plan compiled from a nested schema parses matching JSONs.
+TEST(Generic, NestedSchema) {
+  auto schema = arrow::schema(
+      {arrow::field("id", arrow::uint64(), false),
+       arrow::field("pos",
+                    arrow::struct_({arrow::field("x", arrow::float64(), false),
+                                    arrow::field("y", arrow::int64(), false)}),
+                    false),
+       arrow::field("tags", arrow::list(arrow::field("item", arrow::uint64(), false)),
+                    false),
+       arrow::field("rgb", arrow::fixed_size_list(arrow::uint64(), 3), false),
+       arrow::field("name", arrow::utf8(), false),
+       arrow::field("ok", arrow::boolean(), false)});
+
+  std::shared_ptr<GenericParser> parser;
+  ASSERT_TRUE(GenericParser::Make(schema, &parser).ok());
+  // One for the top-level object, one per field and two for struct members.
+  ASSERT_EQ(parser->plan().steps.size(), 1 + 6 + 2);
+
+  std::string jsons =
+      "{\"id\":1,\"pos\":{\"x\":0.5,\"y\":-2},\"tags\":[],\"rgb\":[1,2,3],"
+      "\"name\":\"a\",\"ok\":true}\n"
+      "{\"id\": 2, \"pos\": {\"x\": 1e3, \"y\": 7}, \"tags\": [4, 5], "
+      "\"rgb\": [0, 0, 0], \"name\": \"b\\\"c\", \"ok\": false}\n"
+      "{\"ok\":true,\"name\":\"d\",\"pos\":{\"y\":3,\"x\":4},\"id\":3,\"rgb\":[7,8,9],"
+      "\"tags\":[6]}\n";
+  illex::JSONBuffer buf;
+  ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(jsons.data()),
+                                        jsons.size(), &buf)
+                  .ok());
+  ASSERT_TRUE(buf.SetSize(jsons.size()).ok());
+
+  ParsedBatch out;
+  ASSERT_TRUE(parser->ParseOne(&buf, &out).ok());
+  ASSERT_EQ(out.batch->num_rows(), 3);
+  ASSERT_TRUE(out.batch->ValidateFull().ok());
+
+  auto pos = std::static_pointer_cast<arrow::StructArray>(out.batch->column(1));
+  auto x = std::static_pointer_cast<arrow::DoubleArray>(pos->field(0));
+  auto y = std::static_pointer_cast<arrow::Int64Array>(pos->field(1));
+  ASSERT_EQ(x->Value(1), 1000.0);
+  ASSERT_EQ(y->Value(0), -2);
+  auto tags = std::static_pointer_cast<arrow::ListArray>(out.batch->column(2));
+  ASSERT_EQ(tags->value_length(0), 0);
+  ASSERT_EQ(tags->value_length(1), 2);
+  auto name = std::static_pointer_cast<arrow::StringArray>(out.batch->column(4));
+  ASSERT_EQ(name->GetString(1), "b\"c");
+
+  // Members may appear in any order.
+  auto id = std::static_pointer_cast<arrow::UInt64Array>(out.batch->column(0));
+  ASSERT_EQ(id->Value(2), 3);
+  ASSERT_EQ(x->Value(2), 4.0);
+  ASSERT_EQ(y->Value(2), 3);
+  ASSERT_EQ(name->GetString(2), "d");
+
+  // Fixed-size lists of the wrong size are rejected.
+  std::string wrong = "{\"id\":1,\"pos\":{\"x\":0,\"y\":0},\"tags\":[],\"rgb\":[1,2],"
+                      "\"name\":\"a\",\"ok\":true}\n";
+  ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(wrong.data()),
+                                        wrong.size(), &buf)
+                  .ok());
+  ASSERT_TRUE(buf.SetSize(wrong.size()).ok());
+  ASSERT_FALSE(parser->ParseOne(&buf, &out).ok());
+}
+
+/// \brief Test whether absent members and nulls of nullable fields become nulls.
+TEST(Generic, Nullable) {
+  auto schema = arrow::schema(
+      {arrow::field("id", arrow::uint64(), false),
+       arrow::field("name", arrow::utf8(), true),
+       arrow::field("pos",
+                    arrow::struct_({arrow::field("x", arrow::float64(), false),
+                                    arrow::field("y", arrow::int64(), true)}),
+                    true),
+       arrow::field("rgb", arrow::fixed_size_list(arrow::uint64(), 3), true)});
+
+  std::shared_ptr<GenericParser> parser;
+  ASSERT_TRUE(GenericParser::Make(schema, &parser).ok());
+
+  std::string jsons;
+  for (int i = 0; i < 100; i++) {
+    switch (i % 4) {
+      case 0:
+        jsons += "{\"id\":0,\"name\":\"a\",\"pos\":{\"x\":1,\"y\":2},\"rgb\":[1,2,3]}\n";
+        break;
+      case 1:
+        jsons += "{\"id\":1}\n";
+        break;
+      case 2:
+        jsons += "{\"id\":2,\"name\":null,\"pos\":{\"x\":1},\"rgb\":null}\n";
+        break;
+      default:
+        jsons += "{\"pos\":null,\"id\":3}\n";
+        break;
+    }
+  }
+  illex::JSONBuffer buf;
+  ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(jsons.data()),
+                                        jsons.size(), &buf)
+                  .ok());
+  ASSERT_TRUE(buf.SetSize(jsons.size()).ok());
+
+  ParsedBatch out;
+  ASSERT_TRUE(parser->ParseOne(&buf, &out).ok());
+  ASSERT_EQ(out.batch->num_rows(), 100);
+  ASSERT_TRUE(out.batch->ValidateFull().ok());
+  ASSERT_EQ(out.batch->column(0)->null_count(), 0);
+  ASSERT_EQ(out.batch->column(1)->null_count(), 75);
+  ASSERT_EQ(out.batch->column(2)->null_count(), 50);
+  ASSERT_EQ(out.batch->column(3)->null_count(), 75);
+  auto pos = std::static_pointer_cast<arrow::StructArray>(out.batch->column(2));
+  ASSERT_TRUE(pos->IsValid(2));
+  ASSERT_TRUE(pos->field(1)->IsNull(2));
+  ASSERT_TRUE(pos->field(1)->IsValid(0));
+  auto name = std::static_pointer_cast<arrow::StringArray>(out.batch->column(1));
+  ASSERT_EQ(name->GetString(96), "a");
+
+  // Required members may not be absent or null.
+  for (std::string wrong : {"{\"name\":\"a\"}\n", "{\"id\":null}\n",
+                            "{\"id\":0,\"pos\":{\"y\":1}}\n"}) {
+    ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(wrong.data()),
+                                          wrong.size(), &buf)
+                    .ok());
+    ASSERT_TRUE(buf.SetSize(wrong.size()).ok());
+    ASSERT_FALSE(parser->ParseOne(&buf, &out).ok()) << wrong;
+  }
+
+  // Failed buffers leave no values or validity bits behind.
+  ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(jsons.data()),
+                                        jsons.size(), &buf)
+                  .ok());
+  ASSERT_TRUE(buf.SetSize(jsons.size()).ok());
+  ASSERT_TRUE(parser->ParseOne(&buf, &out).ok());
+  ASSERT_EQ(out.batch->num_rows(), 100);
+  ASSERT_TRUE(out.batch->ValidateFull().ok());
+  ASSERT_EQ(out.batch->column(1)->null_count(), 75);
+  ASSERT_EQ(out.batch->column(2)->null_count(), 50);
+  ASSERT_TRUE(out.batch->column(1)->IsValid(0));
+  ASSERT_TRUE(out.batch->column(1)->IsNull(1));
+}
+
+/// \brief Test whether objects after a partially parsed malformed object are kept.
+TEST(Generic, Tolerant) {
+  auto schema = arrow::schema(
+      {arrow::field("id", arrow::uint64(), false),
+       arrow::field("name", arrow::utf8(), true),
+       arrow::field("pos",
+                    arrow::struct_({arrow::field("x", arrow::float64(), false),
+                                    arrow::field("y", arrow::int64(), true)}),
+                    false)});
+
+  std::shared_ptr<GenericParser> parser;
+  ASSERT_TRUE(GenericParser::Make(schema, &parser).ok());
+  std::shared_ptr<DeadLetterSink> sink;
+  ASSERT_TRUE(DeadLetterSink::Make(DeadLetterOptions(), &sink).ok());
+  parser->set_dead_letters(sink);
+
+  // The malformed objects fail after their first member, or halfway a nested object.
+  std::string jsons =
+      "{\"id\":0,\"name\":\"a\",\"pos\":{\"x\":1,\"y\":2}}\n"
+      "{\"id\":1,\"name\":}\n"
+      "{\"id\":2,\"pos\":{\"x\":3,\"y\":4}}\n"
+      "{\"id\":3,\"name\":\"d\",\"pos\":{\"x\":5,\"y\":true}}\n"
+      "{\"id\":4,\"name\":\"e\",\"pos\":{\"x\":6}}\n";
+  illex::JSONBuffer buf;
+  ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(jsons.data()),
+                                        jsons.size(), &buf)
+                  .ok());
+  ASSERT_TRUE(buf.SetSize(jsons.size()).ok());
+  buf.SetRange({0, 4});
+
+  ParsedBatch out;
+  ASSERT_TRUE(parser->ParseOne(&buf, &out).ok());
+  ASSERT_EQ(out.skipped, std::vector<illex::Seq>({1, 3}));
+  ASSERT_EQ(sink->count(), 2);
+  ASSERT_EQ(out.batch->num_rows(), 3);
+  ASSERT_TRUE(out.batch->ValidateFull().ok());
+
+  auto id = std::static_pointer_cast<arrow::UInt64Array>(out.batch->column(0));
+  auto name = std::static_pointer_cast<arrow::StringArray>(out.batch->column(1));
+  auto pos = std::static_pointer_cast<arrow::StructArray>(out.batch->column(2));
+  auto x = std::static_pointer_cast<arrow::DoubleArray>(pos->field(0));
+  auto y = std::static_pointer_cast<arrow::Int64Array>(pos->field(1));
+  ASSERT_EQ(id->Value(1), 2);
+  ASSERT_TRUE(name->IsNull(1));
+  ASSERT_EQ(x->Value(1), 3.0);
+  ASSERT_EQ(y->Value(1), 4);
+  ASSERT_EQ(id->Value(2), 4);
+  ASSERT_EQ(name->GetString(2), "e");
+  ASSERT_EQ(x->Value(2), 6.0);
+  ASSERT_TRUE(y->IsNull(2));
+
+  // Nothing of the malformed objects is left in the builders.
+  ASSERT_TRUE(parser->ParseOne(&buf, &out).ok());
+  ASSERT_EQ(out.batch->num_rows(), 3);
+  ASSERT_TRUE(out.batch->ValidateFull().ok());
+
+  // A buffer without any valid object results in an empty batch.
+  std::string malformed = "{\"id\":5,\"name\":}\n";
+  illex::JSONBuffer empty;
+  ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(malformed.data()),
+                                        malformed.size(), &empty)
+                  .ok());
+  ASSERT_TRUE(empty.SetSize(malformed.size()).ok());
+  empty.SetRange({5, 5});
+  ASSERT_TRUE(parser->ParseOne(&empty, &out).ok());
+  ASSERT_EQ(out.batch->num_rows(), 0);
+  ASSERT_EQ(out.seq_range.first, 5);
+  ASSERT_EQ(out.seq_range.last, 5);
+  ASSERT_EQ(out.skipped, std::vector<illex::Seq>({5}));
+}
+
+}  // namespace bolson::parse::custom
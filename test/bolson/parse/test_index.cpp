@@ -0,0 +1,248 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bolson/parse/custom/index.h"
+#include "bolson/parse/custom/members.h"
+#include "bolson/parse/custom/skip.h"
+
+namespace bolson::parse::custom {
+
+/// \brief Test whether all instruction sets find the same structural characters.
+TEST(Index, SimdLevels) {
+  // Escaped quotes and backslashes, and objects crossing 64-byte blocks.
+  std::string json = "{\"a\\\"b\": [1, 2,3], \"s\":\"x\\\\\",\"t\" : true}\n";
+  std::string jsons;
+  for (int i = 0; i < 100; i++) {
+    jsons += json;
+  }
+
+  StructuralIndex scalar;
+  ASSERT_TRUE(
+      BuildStructuralIndex(json.data(), json.size(), &scalar, SimdLevel::SCALAR).ok());
+  std::string structurals;
+  for (size_t i = 0; i < scalar.num_positions; i++) {
+    structurals.push_back(json[scalar.positions[i]]);
+  }
+  ASSERT_EQ(structurals, "{\"\":[,,],\"\":\"\",\"\":}\n");
+
+  ASSERT_TRUE(
+      BuildStructuralIndex(jsons.data(), jsons.size(), &scalar, SimdLevel::SCALAR).ok());
+  for (auto level : {SimdLevel::SSE42, SimdLevel::AVX2}) {
+    if (level > DetectSimdLevel()) {
+      continue;
+    }
+    StructuralIndex simd;
+    ASSERT_TRUE(BuildStructuralIndex(jsons.data(), jsons.size(), &simd, level).ok());
+    ASSERT_EQ(simd.num_positions, scalar.num_positions) << ToString(level);
+    for (size_t i = 0; i < scalar.num_positions; i++) {
+      ASSERT_EQ(simd.positions[i], scalar.positions[i]) << ToString(level);
+    }
+  }
+
+  std::string unterminated = "{\"a\":\"b}\n";
+  ASSERT_FALSE(
+      BuildStructuralIndex(unterminated.data(), unterminated.size(), &scalar).ok());
+}
+
+/// \brief Test whether the cursor extracts values between structural characters.
+TEST(Index, Cursor) {
+  std::string json = "{\"a\\\"b\": [1, 2,3], \"s\":\"x\\\\\",\"t\" : true}\n";
+  StructuralIndex index;
+  ASSERT_TRUE(BuildStructuralIndex(json.data(), json.size(), &index).ok());
+
+  IndexCursor cur(json.data(), json.size(), index);
+  cur.Expect('{');
+  ASSERT_EQ(cur.String(), "a\\\"b");
+  cur.Expect(':');
+  std::vector<uint64_t> values;
+  cur.UInt64Array([&](uint64_t v) { values.push_back(v); });
+  ASSERT_EQ(values, std::vector<uint64_t>({1, 2, 3}));
+  cur.Expect(',');
+  cur.Key("s");
+  ASSERT_EQ(cur.String(), "x\\\\");
+  cur.Expect(',');
+  cur.Key("t");
+  ASSERT_TRUE(cur.Bool());
+  cur.Expect('}');
+  ASSERT_THROW(cur.Expect('}'), std::runtime_error);
+  cur.Expect('\n');
+  ASSERT_TRUE(cur.done());
+}
+
+/// \brief Test whether bytes between structural characters that are not part of a value
+///        are rejected.
+TEST(Index, Gaps) {
+  auto parse = [](const std::string& json) {
+    StructuralIndex index;
+    ASSERT_TRUE(BuildStructuralIndex(json.data(), json.size(), &index).ok());
+    IndexCursor cur(json.data(), json.size(), index);
+    cur.Expect('{');
+    cur.Key("k");
+    cur.UInt64();
+    cur.Expect(',');
+    cur.Key("s");
+    cur.String();
+    cur.Expect('}');
+    cur.Expect('\n');
+  };
+  ASSERT_NO_THROW(parse(" { \"k\" : 1 ,\t\"s\":\"x y\"}\r\n"));
+  for (std::string invalid :
+       {"{\"k\" x : 1,\"s\":\"\"}\n", "x{\"k\":1,\"s\":\"\"}\n",
+        "{\"k\":1,\"s\":\"\" x}\n", "{\"k\":1, x \"s\":\"\"}\n",
+        "{\"k\":1,\"s\":\"\"} x\n"}) {
+    ASSERT_THROW(parse(invalid), std::runtime_error) << invalid;
+  }
+}
+
+/// \brief Test whether SWAR number parsing matches std::from_chars.
+TEST(Index, UInt64Runs) {
+  std::mt19937_64 rng(0);
+  std::vector<uint64_t> expected = {0, 18446744073709551615ULL, 10000000000000000000ULL};
+  for (int i = 0; i < 1000; i++) {
+    expected.push_back(rng() >> (rng() % 64));
+  }
+  std::string json = "[";
+  for (size_t i = 0; i < expected.size(); i++) {
+    json += (i > 0 ? (i % 3 == 0 ? " , " : ",") : "") + std::to_string(expected[i]);
+  }
+  json += "]";
+
+  StructuralIndex index;
+  ASSERT_TRUE(BuildStructuralIndex(json.data(), json.size(), &index).ok());
+  IndexCursor cur(json.data(), json.size(), index);
+  std::vector<uint64_t> values;
+  ASSERT_EQ(cur.UInt64Runs([&](const uint64_t* run, size_t count) {
+    values.insert(values.end(), run, run + count);
+  }),
+            expected.size());
+  ASSERT_EQ(values, expected);
+  ASSERT_TRUE(cur.done());
+
+  for (std::string invalid :
+       {"[1,]", "[1 2]", "[-1]", "[1.5]", "[18446744073709551616]", "[01234567x]"}) {
+    ASSERT_TRUE(BuildStructuralIndex(invalid.data(), invalid.size(), &index).ok());
+    IndexCursor bad(invalid.data(), invalid.size(), index);
+    ASSERT_THROW(bad.UInt64Array([](uint64_t) {}), std::runtime_error) << invalid;
+  }
+}
+
+/// \brief Test vectorized skipping against the scalar definitions, at all offsets.
+TEST(Index, Skip) {
+  std::string data =
+      "  \t\r\n   {\"ab\" :  [1 ,2]}\n                   \n\t}   \"\\\"x\"";
+  const char* begin = data.data();
+  const char* end = begin + data.size();
+  for (const char* pos = begin; pos <= end; pos++) {
+    const char* ws = pos;
+    while ((ws < end) && IsWhitespace(*ws)) ws++;
+    ASSERT_EQ(SkipWhitespace(pos, end), ws);
+
+    const char* st = pos;
+    while ((st < end) && !IsIndexed(*st)) st++;
+    ASSERT_EQ(FindIndexed(pos, end), st);
+
+    const char* nl = nullptr;
+    for (const char* p = begin; p < pos; p++) {
+      if (*p == '\n') nl = p;
+    }
+    ASSERT_EQ(FindLastNewline(begin, pos), nl);
+  }
+}
+
+/// \brief Test whether members are dispatched in any order, but exactly once.
+TEST(Index, MemberDispatch) {
+  MemberDispatch dispatch;
+  ASSERT_FALSE(MemberDispatch::Make({"a", "bb", "a"}, &dispatch).ok());
+  ASSERT_TRUE(MemberDispatch::Make({"a", "bb", "ccc"}, &dispatch).ok());
+
+  auto parse = [&](const std::string& json) {
+    StructuralIndex index;
+    if (!BuildStructuralIndex(json.data(), json.size(), &index).ok()) {
+      throw std::runtime_error("Unable to index JSON.");
+    }
+    IndexCursor cur(json.data(), json.size(), index);
+    std::vector<uint64_t> values(3);
+    dispatch.Object(&cur, [&](size_t m) { values[m] = cur.UInt64(); });
+    return values;
+  };
+
+  const std::vector<uint64_t> expected = {1, 2, 3};
+  ASSERT_EQ(parse("{\"a\":1,\"bb\":2,\"ccc\":3}"), expected);
+  ASSERT_EQ(parse("{\"ccc\":3,\"a\":1,\"bb\":2}"), expected);
+  ASSERT_EQ(parse("{\"ccc\":3,\"a\":1,\"bb\":2}"), expected);
+  ASSERT_EQ(parse("{\"a\":1,\"bb\":2,\"ccc\":3}"), expected);
+  ASSERT_THROW(parse("{\"a\":1,\"a\":1,\"ccc\":3}"), std::runtime_error);
+  ASSERT_THROW(parse("{\"a\":1,\"b\":2,\"ccc\":3}"), std::runtime_error);
+  ASSERT_THROW(parse("{\"a\":1,\"bb\":2}"), std::runtime_error);
+  ASSERT_THROW(parse("{\"a\":1,\"bb\":2,\"ccc\":3,\"d\":4}"), std::runtime_error);
+  // Keys are unescaped.
+  ASSERT_EQ(parse("{\"\\u0061\":1,\"b\\u0062\":2,\"ccc\":3}"), expected);
+  ASSERT_THROW(parse("{\"a\":1,\"\\u0061\":1,\"ccc\":3}"), std::runtime_error);
+
+  // Absent members and null values are left to the caller.
+  auto parse_sparse = [&](const std::string& json) {
+    StructuralIndex index;
+    if (!BuildStructuralIndex(json.data(), json.size(), &index).ok()) {
+      throw std::runtime_error("Unable to index JSON.");
+    }
+    IndexCursor cur(json.data(), json.size(), index);
+    std::vector<uint64_t> values(3, 9);
+    dispatch.Object(
+        &cur, [&](size_t m) { values[m] = cur.Null() ? 0 : cur.UInt64(); },
+        [&](size_t m) { values[m] = 0; });
+    return values;
+  };
+  ASSERT_EQ(parse_sparse("{\"bb\":2}"), std::vector<uint64_t>({0, 2, 0}));
+  ASSERT_EQ(parse_sparse("{ }"), std::vector<uint64_t>({0, 0, 0}));
+  ASSERT_EQ(parse_sparse("{\"ccc\": null ,\"a\":1}"), std::vector<uint64_t>({1, 0, 0}));
+  ASSERT_THROW(parse_sparse("{\"a\":1,\"a\":1}"), std::runtime_error);
+  ASSERT_THROW(parse_sparse("{\"a\":1,}"), std::runtime_error);
+
+  // Raw keys never match keys with backslashes.
+  ASSERT_TRUE(MemberDispatch::Make({"a\\b", "c"}, &dispatch).ok());
+  ASSERT_EQ(parse_sparse("{\"a\\\\b\":1,\"c\":2}"), std::vector<uint64_t>({1, 2, 9}));
+  ASSERT_THROW(parse_sparse("{\"a\\b\":1}"), std::runtime_error);
+}
+
+/// \brief Test whether strings are unescaped, and only copied when they have escapes.
+TEST(Index, Strings) {
+  std::string json =
+      "[\"plain, long enough for a vector load\", "
+      "\"q\\\"b\\\\s\\/n\\nt\\tu\\u00e9\\u20AC\\ud83d\\ude00\", \"\\ud83d\"]";
+  StructuralIndex index;
+  ASSERT_TRUE(BuildStructuralIndex(json.data(), json.size(), &index).ok());
+  IndexCursor cur(json.data(), json.size(), index);
+  cur.Expect('[');
+  auto plain = cur.UnescapedString();
+  ASSERT_EQ(plain, "plain, long enough for a vector load");
+  ASSERT_GE(plain.data(), json.data());
+  ASSERT_LT(plain.data(), json.data() + json.size());
+  cur.Expect(',');
+  ASSERT_EQ(cur.UnescapedString(), "q\"b\\s/n\nt\tu\u00e9\u20ac\U0001F600");
+  cur.Expect(',');
+  ASSERT_THROW(cur.UnescapedString(), std::runtime_error);
+
+  for (std::string invalid : {"\\x", "\\u12", "\\u12g4", "\\udc00", "a\\"}) {
+    std::string out;
+    ASSERT_THROW(UnescapeString(invalid, &out), std::runtime_error) << invalid;
+  }
+}
+
+}  // namespace bolson::parse::custom
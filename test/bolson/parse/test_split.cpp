@@ -0,0 +1,78 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arrow/api.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "bolson/parse/parser.h"
+
+namespace bolson::parse {
+
+/// \brief Test whether buffers are split at newlines with matching sequence numbers.
+TEST(Split, NewlineAligned) {
+  std::string jsons = "{\"a\":1}\n{\"a\":22}\n{\"a\":333}\n{\"a\":4444}\n";
+  illex::JSONBuffer buf;
+  ASSERT_TRUE(illex::JSONBuffer::Create(reinterpret_cast<std::byte*>(jsons.data()),
+                                        jsons.size(), &buf)
+                  .ok());
+  ASSERT_TRUE(buf.SetSize(jsons.size()).ok());
+  buf.SetRange({10, 13});
+
+  std::vector<illex::JSONBuffer> chunks;
+  ASSERT_TRUE(SplitBuffer(&buf, 2, 1, &chunks).ok());
+  ASSERT_EQ(chunks.size(), 2);
+  ASSERT_EQ(chunks[0].size(), 27);
+  ASSERT_EQ(chunks[0].range().first, 10);
+  ASSERT_EQ(chunks[0].range().last, 12);
+  ASSERT_EQ(chunks[1].data(), buf.data() + 27);
+  ASSERT_EQ(chunks[1].size(), 11);
+  ASSERT_EQ(chunks[1].range().first, 13);
+  ASSERT_EQ(chunks[1].range().last, 13);
+
+  // A minimum chunk size larger than the buffer results in a single chunk.
+  ASSERT_TRUE(SplitBuffer(&buf, 2, 1024, &chunks).ok());
+  ASSERT_EQ(chunks.size(), 1);
+  ASSERT_EQ(chunks[0].size(), jsons.size());
+}
+
+/// \brief Test whether parsed chunks are stitched into one batch in order.
+TEST(Split, Stitch) {
+  auto schema = arrow::schema({arrow::field("a", arrow::uint64(), false)});
+  std::vector<ParsedBatch> parts;
+  for (uint64_t p = 0; p < 2; p++) {
+    arrow::UInt64Builder builder;
+    ASSERT_TRUE(builder.AppendValues({2 * p, 2 * p + 1}).ok());
+    std::shared_ptr<arrow::Array> a;
+    ASSERT_TRUE(builder.Finish(&a).ok());
+    auto batch = arrow::RecordBatch::Make(schema, 2, {a});
+    illex::SeqRange range = {2 * p, 2 * p + 1};
+    parts.emplace_back(AddSeqAsSchemaMeta(batch, range), range);
+  }
+
+  ParsedBatch stitched;
+  ASSERT_TRUE(StitchBatches(parts, &stitched).ok());
+  ASSERT_EQ(stitched.batch->num_rows(), 4);
+  ASSERT_EQ(stitched.seq_range.first, 0);
+  ASSERT_EQ(stitched.seq_range.last, 3);
+  auto col = std::static_pointer_cast<arrow::UInt64Array>(stitched.batch->column(0));
+  for (int64_t i = 0; i < 4; i++) {
+    ASSERT_EQ(col->Value(i), static_cast<uint64_t>(i));
+  }
+  auto meta = stitched.batch->schema()->metadata();
+  ASSERT_EQ(meta->value(meta->FindKey("bolson_seq_last")), "3");
+}
+
+}  // namespace bolson::parse
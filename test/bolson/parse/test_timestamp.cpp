@@ -0,0 +1,76 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arrow/api.h>
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "bolson/parse/timestamp.h"
+
+namespace bolson::parse {
+
+/// \brief Test ISO-8601 timestamps with several fractions and offsets.
+TEST(Timestamp, ISO8601) {
+  constexpr int64_t kSecond = 1000000000;
+  ASSERT_EQ(ParseISO8601("1970-01-01T00:00:00"), 0);
+  ASSERT_EQ(ParseISO8601("1970-01-01T00:00:00Z"), 0);
+  ASSERT_EQ(ParseISO8601("2005-09-05T17:04:01Z"), 1125939841 * kSecond);
+  ASSERT_EQ(ParseISO8601("2005-09-05 19:04:01+02:00"), 1125939841 * kSecond);
+  ASSERT_EQ(ParseISO8601("2005-09-05T12:34:01-0430"), 1125939841 * kSecond);
+  ASSERT_EQ(ParseISO8601("2005-09-05T18:04:01+01"), 1125939841 * kSecond);
+  ASSERT_EQ(ParseISO8601("1970-01-01T00:00:00.5Z"), kSecond / 2);
+  ASSERT_EQ(ParseISO8601("1970-01-01T00:00:00,000000001"), 1);
+  // Digits beyond nanoseconds are truncated.
+  ASSERT_EQ(ParseISO8601("1970-01-01T00:00:00.1234567899"), 123456789);
+  ASSERT_EQ(ParseISO8601("1969-12-31T23:59:59.9Z"), -kSecond / 10);
+  ASSERT_EQ(ParseISO8601("2000-02-29T00:00:00Z"), 951782400 * kSecond);
+
+  for (const auto* s :
+       {"", "2005-09-05", "2005-09-05X17:04:01", "2005-13-05T17:04:01",
+        "2005-02-29T17:04:01", "2005-09-05T24:00:00", "2005-09-05T17:04:01.",
+        "2005-09-05T17:04:01+1", "2005-09-05T17:04:01+01:", "2005-09-05T17:04:01ZZ",
+        "2005-09-0aT17:04:01", "1500-01-01T00:00:00Z", "3000-01-01T00:00:00Z"}) {
+    ASSERT_THROW(ParseISO8601(s), std::runtime_error) << s;
+  }
+}
+
+/// \brief Test conversion of a tagged utf8 column to a timestamp column.
+TEST(Timestamp, Columns) {
+  auto input = arrow::schema(
+      {arrow::field("ts", arrow::utf8())->WithMetadata(
+           arrow::key_value_metadata({kTimestampMetaKey}, {"UTC"})),
+       arrow::field("s", arrow::utf8())});
+  std::shared_ptr<arrow::Schema> output;
+  ASSERT_TRUE(WithTimestampFields(*input, &output).ok());
+  ASSERT_TRUE(output->field(0)->type()->Equals(
+      arrow::timestamp(arrow::TimeUnit::NANO, "UTC")));
+  ASSERT_TRUE(output->field(1)->type()->Equals(arrow::utf8()));
+
+  arrow::StringBuilder builder;
+  ASSERT_TRUE(builder.AppendValues({"1970-01-01T00:00:01Z", "not a timestamp"}).ok());
+  std::shared_ptr<arrow::Array> strings;
+  ASSERT_TRUE(builder.Finish(&strings).ok());
+  auto batch = arrow::RecordBatch::Make(input, 1, {strings->Slice(0, 1), strings});
+  std::shared_ptr<arrow::RecordBatch> converted;
+  ASSERT_TRUE(ConvertTimestampColumns(batch, output, &converted).ok());
+  ASSERT_EQ(
+      std::static_pointer_cast<arrow::TimestampArray>(converted->column(0))->Value(0),
+      1000000000);
+
+  batch = arrow::RecordBatch::Make(input, 1, {strings->Slice(1, 1), strings});
+  ASSERT_FALSE(ConvertTimestampColumns(batch, output, &converted).ok());
+}
+
+}  // namespace bolson::parse
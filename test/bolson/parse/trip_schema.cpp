@@ -0,0 +1,75 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+
+#include <iostream>
+
+// Writes the JSON schema of the trip parser to a file, from which a parser is generated
+// at build time to test it against the hand-written trip parser. The test checks that
+// this schema equals the output schema of the trip parser.
+
+static auto TripSchema() -> std::shared_ptr<arrow::Schema> {
+  auto list = [](int32_t size) {
+    return arrow::fixed_size_list(arrow::field("item", arrow::uint64(), false), size);
+  };
+  return arrow::schema({arrow::field("timestamp", arrow::utf8(), false),
+                        arrow::field("timezone", arrow::uint64(), false),
+                        arrow::field("vin", arrow::uint64(), false),
+                        arrow::field("odometer", arrow::uint64(), false),
+                        arrow::field("hypermiling", arrow::boolean(), false),
+                        arrow::field("avgspeed", arrow::uint64(), false),
+                        arrow::field("sec_in_band", list(12), false),
+                        arrow::field("miles_in_time_range", list(24), false),
+                        arrow::field("const_speed_miles_in_band", list(12), false),
+                        arrow::field("vary_speed_miles_in_band", list(12), false),
+                        arrow::field("sec_decel", list(10), false),
+                        arrow::field("sec_accel", list(10), false),
+                        arrow::field("braking", list(6), false),
+                        arrow::field("accel", list(6), false),
+                        arrow::field("orientation", arrow::boolean(), false),
+                        arrow::field("small_speed_var", list(13), false),
+                        arrow::field("large_speed_var", list(13), false),
+                        arrow::field("accel_decel", arrow::uint64(), false),
+                        arrow::field("speed_changes", arrow::uint64(), false)});
+}
+
+auto main(int argc, char* argv[]) -> int {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <output file>" << std::endl;
+    return -1;
+  }
+  auto buffer = arrow::ipc::SerializeSchema(*TripSchema());
+  if (!buffer.ok()) {
+    std::cerr << buffer.status().ToString() << std::endl;
+    return -1;
+  }
+  auto file = arrow::io::FileOutputStream::Open(argv[1]);
+  if (!file.ok()) {
+    std::cerr << file.status().ToString() << std::endl;
+    return -1;
+  }
+  auto status = file.ValueOrDie()->Write(buffer.ValueOrDie());
+  if (status.ok()) {
+    status = file.ValueOrDie()->Close();
+  }
+  if (!status.ok()) {
+    std::cerr << status.ToString() << std::endl;
+    return -1;
+  }
+  return 0;
+}
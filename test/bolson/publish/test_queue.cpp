@@ -0,0 +1,62 @@
+// Copyright 2020 Teratide B.V.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <arrow/api.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+
+#include "bolson/publish/queue.h"
+
+namespace bolson::publish {
+
+static auto MakeItem(size_t size) -> IpcQueueItem {
+  IpcQueueItem item;
+  item.message = std::make_shared<arrow::Buffer>(nullptr, static_cast<int64_t>(size));
+  return item;
+}
+
+/// \brief Test whether producers block on a full queue until consumers make room.
+TEST(IpcQueue, Backpressure) {
+  IpcQueue queue(100);
+  ASSERT_TRUE(queue.enqueue(MakeItem(60)));
+  ASSERT_EQ(queue.bytes(), 60);
+
+  auto producer =
+      std::async(std::launch::async, [&]() { return queue.enqueue(MakeItem(60)); });
+  ASSERT_EQ(producer.wait_for(std::chrono::milliseconds(50)),
+            std::future_status::timeout);
+
+  IpcQueueItem item;
+  ASSERT_TRUE(queue.wait_dequeue_timed(item, std::chrono::milliseconds(10)));
+  ASSERT_TRUE(producer.get());
+  ASSERT_EQ(queue.bytes(), 60);
+
+  auto m = queue.metrics();
+  ASSERT_EQ(m.enqueued, 2);
+  ASSERT_EQ(m.blocked, 1);
+  ASSERT_EQ(m.peak_bytes, 60);
+  ASSERT_EQ(m.peak_items, 1);
+
+  // A blocked producer gives up when the shutdown signal is asserted.
+  std::atomic<bool> shutdown = true;
+  ASSERT_FALSE(queue.enqueue(MakeItem(60), &shutdown));
+
+  // Messages larger than the budget are accepted when the queue is empty.
+  ASSERT_TRUE(queue.try_dequeue(item));
+  ASSERT_TRUE(queue.enqueue(MakeItem(200)));
+}
+
+}  // namespace bolson::publish